@@ -0,0 +1,178 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host benchmark of the CPU side of a frame, built with the GPUIMAGE_GL_MOCK
+// option. It runs a few typical graphs on GLMock, times every frame from the
+// upload to the last readback and checks the GL calls of each frame against
+// the budget of its graph. The counts are deterministic, a change in them is
+// a change of the library: lower a budget when a change saves calls, raise it
+// only for calls that are meant to be there. The CPU time depends on the host
+// and is only checked against the budget given on the command line.
+//
+//     GPUImage-x-benchmark [frames] [median CPU time budget per frame in us]
+//
+// Exits with 1 when a frame exceeds a budget.
+
+#include "GPUImage-x.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+USING_NS_GI
+
+static const int kWidth = 640;
+static const int kHeight = 480;
+// the first frames compile the programs and fill the framebuffer cache
+static const int kWarmupFrames = 3;
+
+struct Scene {
+    const char* name;
+    // builds the graph behind the camera, returns what to release afterwards
+    std::function<std::vector<Ref*>(SourceCamera*)> build;
+    GLMock::Stats budget;
+};
+
+// in the order the counters are printed
+static GLMock::Stats makeBudget(int totalCalls, int drawCalls, int clears, int programSwitches, int framebufferBinds,
+                                int textureBinds, int uniformUploads, int viewportChanges, int textureUploads, int readbacks,
+                                int redundantProgramSwitches, int redundantBinds, int redundantUniformUploads) {
+    GLMock::Stats budget;
+    budget.totalCalls = totalCalls;
+    budget.drawCalls = drawCalls;
+    budget.clears = clears;
+    budget.programSwitches = programSwitches;
+    budget.framebufferBinds = framebufferBinds;
+    budget.textureBinds = textureBinds;
+    budget.uniformUploads = uniformUploads;
+    budget.viewportChanges = viewportChanges;
+    budget.textureUploads = textureUploads;
+    budget.readbacks = readbacks;
+    budget.redundantProgramSwitches = redundantProgramSwitches;
+    budget.redundantBinds = redundantBinds;
+    budget.redundantUniformUploads = redundantUniformUploads;
+    return budget;
+}
+
+// reads every frame back like a consumer would
+static ReadbackTarget* createReadback() {
+    return ReadbackTarget::create([](const unsigned char* pixels, int width, int height) {});
+}
+
+static std::vector<Scene> makeScenes() {
+    std::vector<Scene> scenes;
+
+    // a single filter, the overhead every graph pays
+    scenes.push_back({"filter", [](SourceCamera* camera) {
+        SaturationFilter* saturation = SaturationFilter::create();
+        ReadbackTarget* readback = createReadback();
+        camera->addTarget(saturation)->addTarget(readback);
+        return std::vector<Ref*>{saturation, readback};
+    }, makeBudget(42, 1, 1, 0, 4, 3, 2, 0, 1, 1, 0, 0, 2)});
+
+    // a deep group of blurs and edge detection
+    scenes.push_back({"beautify", [](SourceCamera* camera) {
+        BeautifyFilter* beautify = BeautifyFilter::create();
+        ReadbackTarget* readback = createReadback();
+        camera->addTarget(beautify)->addTarget(readback);
+        return std::vector<Ref*>{beautify, readback};
+    }, makeBudget(222, 10, 10, 10, 22, 14, 31, 0, 1, 1, 0, 0, 29)});
+
+    // two identical branches, merged by the graph optimizer
+    scenes.push_back({"fan-out", [](SourceCamera* camera) {
+        std::vector<Ref*> objects;
+        for (int i = 0; i < 2; ++i) {
+            BrightnessFilter* brightness = BrightnessFilter::create(0.2);
+            brightness->setFilterClassName("BrightnessFilter");
+            GrayscaleFilter* grayscale = GrayscaleFilter::create();
+            grayscale->setFilterClassName("GrayscaleFilter");
+            ReadbackTarget* readback = createReadback();
+            camera->addTarget(brightness)->addTarget(grayscale)->addTarget(readback);
+            objects.push_back(brightness);
+            objects.push_back(grayscale);
+            objects.push_back(readback);
+        }
+        camera->setGraphOptimizationEnabled(true);
+        return objects;
+    }, makeBudget(74, 2, 2, 2, 8, 4, 3, 0, 1, 2, 0, 0, 3)});
+
+    return scenes;
+}
+
+static bool runScene(const Scene& scene, int frameCount, long cpuBudget) {
+    Context::init();
+    SourceCamera* camera = SourceCamera::create();
+    std::vector<Ref*> objects = scene.build(camera);
+    std::vector<unsigned char> pixels(kWidth * kHeight * 4, 128);
+
+    bool isWithinBudget = true;
+    std::vector<long> frameTimes;
+    GLMock::setFrameBudget(GLMock::unlimitedBudget());
+    for (int i = 0; i < kWarmupFrames + frameCount; ++i) {
+        if (i == kWarmupFrames) {
+            GLMock::setFrameBudget(scene.budget);
+        }
+        GLMock::beginFrame();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        camera->setFrameData(kWidth, kHeight, &pixels[0]);
+        camera->proceed();
+        Context::getInstance()->getReadbackQueue()->finish();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        if (!GLMock::endFrame()) {
+            isWithinBudget = false;
+        }
+        if (i >= kWarmupFrames) {
+            frameTimes.push_back((long)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        }
+    }
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    long median = frameTimes[frameTimes.size() / 2];
+    const GLMock::Stats& stats = GLMock::getFrameStats();
+    printf("%-10s %6ld us median %6ld us max | calls %d draws %d clears %d programs %d fbos %d textures %d uniforms %d viewports %d uploads %d readbacks %d | redundant programs %d binds %d uniforms %d\n",
+           scene.name, median, frameTimes.back(), stats.totalCalls, stats.drawCalls, stats.clears, stats.programSwitches,
+           stats.framebufferBinds, stats.textureBinds, stats.uniformUploads, stats.viewportChanges, stats.textureUploads, stats.readbacks,
+           stats.redundantProgramSwitches, stats.redundantBinds, stats.redundantUniformUploads);
+    if (cpuBudget > 0 && median > cpuBudget) {
+        printf("%-10s median CPU time %ld us exceeds budget %ld us\n", scene.name, median, cpuBudget);
+        isWithinBudget = false;
+    }
+
+    camera->release();
+    for (Ref* object : objects) {
+        object->release();
+    }
+    Context::destroy();
+    return isWithinBudget;
+}
+
+int main(int argc, char* argv[]) {
+    int frameCount = argc > 1 ? atoi(argv[1]) : 100;
+    long cpuBudget = argc > 2 ? atol(argv[2]) : 0;
+    if (frameCount < 1) frameCount = 1;
+
+    bool isWithinBudget = true;
+    for (const Scene& scene : makeScenes()) {
+        if (!runScene(scene, frameCount, cpuBudget)) {
+            isWithinBudget = false;
+        }
+    }
+    return isWithinBudget ? 0 : 1;
+}
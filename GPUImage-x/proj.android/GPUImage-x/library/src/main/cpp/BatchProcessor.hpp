@@ -0,0 +1,120 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BatchProcessor_hpp
+#define BatchProcessor_hpp
+
+#include "macros.h"
+#include "Context.hpp"
+#include "source/SourceImage.h"
+#include "target/ReadbackTarget.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+NS_GI_BEGIN
+
+// BatchProcessor runs a pipeline over many images at once. It owns a number of
+// workers, each a headless Context with a render thread of its own and its own
+// instance of the pipeline, built by the same builder.
+//
+// The images of a batch are dealt out to the workers in turn. A worker takes
+// its next image from the front of its own queue and, once that is empty,
+// steals from the back of the fullest other queue, so a slow worker does not
+// hold the batch up. Results are handed back in the order of the images.
+class BatchProcessor {
+public:
+    // RGBA, rows of width * 4 bytes
+    struct Image {
+        int width;
+        int height;
+        std::vector<unsigned char> pixels;
+
+        Image() : width(0), height(0) {}
+        Image(int w, int h, const unsigned char* data) : width(w), height(h), pixels(data, data + w * h * 4) {}
+    };
+
+    // Connects the pipeline from input to output, called once for every worker
+    // on its render thread. The graph holds the filters it is given, release
+    // the references of the builder before returning. Returns false on failure.
+    typedef std::function<bool(Source* input, Target* output)> PipelineBuilder;
+    // called on the thread of process(), in the order of the images; result is
+    // empty for an image that failed, and may be moved from
+    typedef std::function<void(int index, Image& result)> ResultCallback;
+
+    struct Stats {
+        int imageCount;
+        double seconds;
+        double imagesPerSecond;
+        // images a worker took from the queue of another
+        int stealCount;
+        std::vector<int> workerImageCounts;
+        // time each worker spent on images over the time of the batch, 0 to 1
+        std::vector<double> workerUtilization;
+    };
+
+    // workerCount of 0 for one worker per core
+    static BatchProcessor* create(PipelineBuilder builder, int workerCount = 0);
+    ~BatchProcessor();
+
+    // Runs every image through the pipeline, returns false if any failed. One
+    // batch at a time.
+    bool process(const std::vector<Image>& images, ResultCallback callback);
+    bool process(const std::vector<Image>& images, std::vector<Image>& results);
+
+    int getWorkerCount() const { return (int)_workers.size(); }
+    // of the last batch
+    const Stats& getStats() const { return _stats; }
+
+private:
+    struct Worker {
+        Context* context;
+        SourceImage* input;
+        ReadbackTarget* output;
+        // the result of the image in flight, filled by the output
+        Image* result;
+
+        std::mutex jobsMutex;
+        std::deque<int> jobs;
+
+        double busySeconds;
+        int imageCount;
+    };
+    std::vector<Worker*> _workers;
+    Stats _stats;
+
+    // state of the batch being processed
+    const std::vector<Image>* _images;
+    std::vector<Image> _results;
+    std::vector<char> _isReady;
+    int _activeWorkerCount;
+    int _stealCount;
+    std::mutex _resultsMutex;
+    std::condition_variable _resultReady;
+
+    BatchProcessor();
+    bool _init(PipelineBuilder builder, int workerCount);
+    bool _takeJob(int workerIndex, int& job);
+    void _work(int workerIndex);
+};
+
+NS_GI_END
+
+#endif /* BatchProcessor_hpp */
@@ -18,6 +18,7 @@
 
 #include "Context.hpp"
 #include "util.h"
+#include "RenderThread.hpp"
 
 #if PLATFORM == PLATFORM_IOS
 #import <OpenGLES/EAGLDrawable.h>
@@ -30,16 +31,30 @@ NS_GI_BEGIN
 #define GL_CONTEXT_QUEUE    "com.jin.GPUImage-x.openglESContextQueue"
 #endif
 
-Context* Context::_instance = 0;
+std::atomic<Context*> Context::_instance(0);
 std::mutex Context::_mutex;
+thread_local Context* Context::_current = 0;
 
 Context::Context()
-:_curShaderProgram(0)
-,isCapturingFrame(false)
+:isCapturingFrame(false)
 ,captureUpToFilter(0)
 ,capturedFrameData(0)
+,captureDestination(0)
+,captureStride(0)
+,captureTimestamp(0)
+,_curShaderProgram(0)
+,_passSource(0)
+,_passSerial(0)
+,_passDepth(0)
+,_redundantRunCount(0)
+,_threadId(std::this_thread::get_id())
+#if PLATFORM != PLATFORM_IOS
+,_renderThread(0)
+#endif
 {
     _framebufferCache = new FramebufferCache();
+    _readbackQueue = new ReadbackQueue();
+    _frameDataPool = new FrameDataPool();
     
 #if PLATFORM == PLATFORM_IOS
     _contextQueue = dispatch_queue_create(GL_CONTEXT_QUEUE, DISPATCH_QUEUE_SERIAL);
@@ -49,29 +64,105 @@ Context::Context()
 }
 
 Context::~Context() {
+    if (_current == this) {
+        _current = 0;
+    }
+    // the knobs hold sources and filters, let them go before the caches
+    _qualityController.removeAllKnobs();
+#if PLATFORM != PLATFORM_IOS
+    if (_renderThread) {
+        // the cached GL objects belong to the context of the render thread
+        _renderThread->runSync([this]() {
+            delete _readbackQueue;
+            delete _frameDataPool;
+            delete _framebufferCache;
+            _runDeferredDeletions();
+        });
+        delete _renderThread;
+        _renderThread = 0;
+        return;
+    }
+#endif
+    delete _readbackQueue;
+    delete _frameDataPool;
     delete _framebufferCache;
+    // the GL context is expected to be current here, as for the caches
+    _runDeferredDeletions();
 }
 
 Context* Context::getInstance() {
-    if (!_instance)
+    return _current ? _current : getDefault();
+}
+
+Context* Context::getDefault() {
+    // acquire pairs with the release below, so a thread that sees the pointer
+    // also sees the context it was constructed into
+    Context* instance = _instance.load(std::memory_order_acquire);
+    if (!instance)
     {
         std::unique_lock<std::mutex> lock(_mutex);
-        if (!_instance) {
-            _instance = new (std::nothrow) Context;
+        instance = _instance.load(std::memory_order_relaxed);
+        if (!instance) {
+            instance = new (std::nothrow) Context;
+            _instance.store(instance, std::memory_order_release);
         }
     }
-    return _instance;
+    return instance;
 };
 
+Context* Context::setCurrent(Context* context) {
+    Context* previous = _current;
+    _current = (context == _instance.load(std::memory_order_acquire)) ? 0 : context;
+    if (context) {
+        context->_threadId.store(std::this_thread::get_id());
+    }
+    return previous;
+}
+
+void Context::deferDeletion(Context* context, std::function<void(void)> deletion) {
+    if (!context) context = _instance.load(std::memory_order_acquire);
+    // the default context is gone, nothing is left to defer to
+    if (!context || context->isContextThread()) {
+        deletion();
+        return;
+    }
+#if PLATFORM != PLATFORM_IOS
+    if (context->_renderThread && context->_renderThread->isRunning()) {
+        context->_renderThread->runAsync(deletion);
+        return;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(context->_deferredDeletionsMutex);
+    context->_deferredDeletions.push_back(deletion);
+}
+
+int Context::getDeferredDeletionCount() {
+    std::lock_guard<std::mutex> lock(_deferredDeletionsMutex);
+    return (int)_deferredDeletions.size();
+}
+
+void Context::_runDeferredDeletions() {
+    std::vector<std::function<void(void)>> deletions;
+    {
+        std::lock_guard<std::mutex> lock(_deferredDeletionsMutex);
+        if (_deferredDeletions.empty()) return;
+        deletions.swap(_deferredDeletions);
+    }
+    for (auto const& deletion : deletions) {
+        deletion();
+    }
+}
+
 void Context::init() {
     destroy();
     getInstance();
 }
 
 void Context::destroy() {
-    if (_instance) {
-        delete _instance;
-        _instance = 0;
+    Context* instance = _instance.load(std::memory_order_acquire);
+    if (instance) {
+        delete instance;
+        _instance.store(0, std::memory_order_release);
     }
 }
 
@@ -79,6 +170,14 @@ FramebufferCache* Context::getFramebufferCache() const {
     return _framebufferCache;
 }
 
+ReadbackQueue* Context::getReadbackQueue() const {
+    return _readbackQueue;
+}
+
+FrameDataPool* Context::getFrameDataPool() const {
+    return _frameDataPool;
+}
+
 void Context::setActiveShaderProgram(GLProgram* shaderProgram) {
     if (_curShaderProgram != shaderProgram)
     {
@@ -89,32 +188,101 @@ void Context::setActiveShaderProgram(GLProgram* shaderProgram) {
 
 void Context::purge() {
     _framebufferCache->purge();
+    _frameDataPool->purge();
+    if (isContextThread()) {
+        _runDeferredDeletions();
+    }
+}
+
+void Context::beginPass(Source* source) {
+    if (_passDepth++ == 0) {
+        ++_passSerial;
+        _passSource = source;
+        _threadId.store(std::this_thread::get_id());
+        _runDeferredDeletions();
+    }
+}
+
+void Context::endPass() {
+    if (_passDepth > 0 && --_passDepth == 0) {
+        _passSource = 0;
+    }
+}
+
+#if PLATFORM != PLATFORM_IOS
+bool Context::startRenderThread(void* sharedContext/* = 0*/) {
+    if (!_renderThread) {
+        _renderThread = new (std::nothrow) RenderThread();
+        if (!_renderThread) return false;
+    }
+    if (!_renderThread->start(sharedContext)) return false;
+    _renderThread->runSync([this]() { setCurrent(this); });
+    return true;
+}
+
+void Context::stopRenderThread() {
+    if (!_renderThread) return;
+    // GL objects still held by the graph go with the context of the thread
+    _renderThread->runSync([this]() {
+        _readbackQueue->finish();
+        delete _readbackQueue;
+        _readbackQueue = new ReadbackQueue();
+        purge();
+        _curShaderProgram = 0;
+    });
+    delete _renderThread;
+    _renderThread = 0;
+}
+
+void Context::runSync(std::function<void(void)> func) {
+    if (_renderThread && _renderThread->isRunning()) {
+        _renderThread->runSync(func);
+    } else {
+        func();
+    }
 }
 
+void Context::runAsync(std::function<void(void)> func) {
+    if (_renderThread && _renderThread->isRunning()) {
+        _renderThread->runAsync(func);
+    } else {
+        func();
+    }
+}
+#endif
+
 #if PLATFORM == PLATFORM_IOS
 void Context::runSync(std::function<void(void)> func) {
     useAsCurrent();
-    dispatch_queue_t contextQueue = Context::getInstance()->getContextQueue();
+    dispatch_queue_t contextQueue = _contextQueue;
 
     if (dispatch_get_current_queue() == contextQueue)
     {
         func();
     }else
     {
-        dispatch_sync(contextQueue, ^{ func(); });
+        dispatch_sync(contextQueue, ^{
+            Context* previous = setCurrent(this);
+            func();
+            setCurrent(previous);
+        });
     }
 }
 
 void Context::runAsync(std::function<void(void)> func) {
     useAsCurrent();
-    dispatch_queue_t contextQueue = Context::getInstance()->getContextQueue();
+    dispatch_queue_t contextQueue = _contextQueue;
 
     if (dispatch_get_current_queue() == contextQueue)
     {
         func();
     }else
     {
-        dispatch_async(contextQueue, ^{ func(); });
+        dispatch_async(contextQueue, ^{
+            Context* previous = setCurrent(this);
+            func();
+            setCurrent(previous);
+        });
     }
 }
 
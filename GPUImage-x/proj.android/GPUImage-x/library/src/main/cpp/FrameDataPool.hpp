@@ -0,0 +1,74 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FrameDataPool_hpp
+#define FrameDataPool_hpp
+
+#include "macros.h"
+#include "Ref.hpp"
+#include <mutex>
+#include <vector>
+
+NS_GI_BEGIN
+
+class Context;
+
+// RGBA pixels of a captured frame, rows are stride bytes apart.
+class FrameData : public Ref {
+public:
+    FrameData(int width, int height, int stride = 0);
+    ~FrameData();
+
+    // at a reference count of 0 the memory goes back to the frame data pool
+    virtual void release(bool returnToPool = true);
+
+    unsigned char* getData() const { return _data; }
+    int getWidth() const { return _width; }
+    int getHeight() const { return _height; }
+    int getStride() const { return _stride; }
+    int getSize() const { return _stride * _height; }
+
+private:
+    // the context it was made in, 0 for the default one; it goes back to its pool
+    Context* _context;
+    unsigned char* _data;
+    int _width;
+    int _height;
+    int _stride;
+};
+
+// Recycles capture memory for callers that do not own a buffer. Frame data
+// may be released from any thread, the pool is locked.
+class FrameDataPool {
+public:
+    FrameDataPool(int capacity = 4);
+    ~FrameDataPool();
+
+    FrameData* fetchFrameData(int width, int height, int stride = 0);
+    void returnFrameData(FrameData* frameData);
+    void purge();
+
+private:
+    std::vector<FrameData*> _frameDatas;
+    int _capacity;
+    std::mutex _mutex;
+};
+
+NS_GI_END
+
+#endif /* FrameDataPool_hpp */
@@ -0,0 +1,128 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FrameMetrics_hpp
+#define FrameMetrics_hpp
+
+#include "macros.h"
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+NS_GI_BEGIN
+
+// Histogram of durations in microseconds, up to about 38 hours. Buckets are
+// exact below 32us and 1/16 of a power of two wide above, so a percentile is
+// within about 3% of the true value however wide the range, as in
+// HdrHistogram, at a fixed 544 counters.
+class Histogram {
+public:
+    Histogram();
+
+    void record(int64_t valueUs);
+    void add(const Histogram& histogram);
+    void reset();
+
+    uint64_t getCount() const { return _count; }
+    int64_t getMax() const { return _max; }
+    double getMean() const { return _count > 0 ? (double)_sum / _count : 0; }
+    // the value below which percentile (0 to 100) of the values are, 0 if empty
+    int64_t getPercentile(double percentile) const;
+
+private:
+    static const int kSubBucketCount = 16;
+    static const int kBucketCount = 544;
+    std::vector<uint64_t> _counts;
+    uint64_t _count;
+    int64_t _sum;
+    int64_t _max;
+
+    static int _getIndex(int64_t valueUs);
+    static int64_t _getValue(int index);
+};
+
+// FrameMetrics keeps rolling histograms of how long frames take, from the
+// timestamp a frame got at its source (see Framebuffer::getTimestamp()):
+//
+//   ProcessingLatency  to the end of the pass that processed it
+//   DisplayLatency     to being drawn into a TargetView
+//   CaptureLatency     to its pixels being handed to a capture or readback callback
+//   FrameInterval      between the ends of consecutive passes
+//   FrameJitter        between consecutive frame intervals
+//   FrameTime          from the upload of a frame to the end of its pass,
+//                      waiting for the GPU included
+//
+// Each histogram covers the last one to two windows: values go into the
+// current window, and when it is full it replaces the previous one. Every
+// Context has one, recorded on its thread and queried from any.
+class FrameMetrics {
+public:
+    enum Metric {
+        ProcessingLatency = 0,
+        DisplayLatency,
+        CaptureLatency,
+        FrameInterval,
+        FrameJitter,
+        FrameTime,
+        MetricCount
+    };
+
+    // durations in milliseconds
+    struct Stats {
+        uint64_t count;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+        double mean;
+    };
+
+    FrameMetrics(double windowSeconds = 10);
+
+    void setEnabled(bool enabled) { _isEnabled = enabled; }
+    bool isEnabled() const { return _isEnabled; }
+    void setWindow(double windowSeconds);
+
+    // the time from timestamp to now, frames without a timestamp are skipped
+    void recordLatency(Metric metric, int64_t timestamp);
+    // the end of a pass, for the interval and jitter
+    void recordPassEnd();
+    void record(Metric metric, int64_t valueUs);
+
+    Stats getStats(Metric metric) const;
+    // the histogram merged over both windows
+    Histogram getHistogram(Metric metric) const;
+    void reset();
+
+private:
+    mutable std::mutex _mutex;
+    std::atomic<bool> _isEnabled;
+    int64_t _window;
+    int64_t _windowStart;
+    Histogram _current[MetricCount];
+    Histogram _previous[MetricCount];
+    int64_t _lastPassEnd;
+    int64_t _lastInterval;
+
+    void _roll(int64_t now);
+};
+
+NS_GI_END
+
+#endif /* FrameMetrics_hpp */
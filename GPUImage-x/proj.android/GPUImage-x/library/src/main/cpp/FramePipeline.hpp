@@ -0,0 +1,126 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FramePipeline_hpp
+#define FramePipeline_hpp
+
+#include "macros.h"
+#include "Framebuffer.hpp"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+NS_GI_BEGIN
+
+class Context;
+
+// FramePipeline lets a source run up to depth frames ahead of the GPU, so the
+// upload of frame N+1, the processing of frame N and the readback or display
+// of frame N-1 overlap instead of following one another.
+//
+// Every framebuffer fetched from the cache while a frame is open joins the set
+// of that frame and is held out of the cache until a fence inserted at the end
+// of the frame has signalled; the next frames render into other framebuffers
+// and never wait on the GPU for the ones still being read. Beginning a frame
+// blocks only while depth frames are in flight. Depth 1 is the serial mode,
+// each frame is finished before the next one begins.
+//
+// GLES2 has no fences, there a frame is retired once depth newer frames have
+// begun and the driver orders the accesses.
+//
+// Latency and throughput are measured per depth, so a pipeline switched
+// between depths reports what the deeper one costs and what it gains.
+class FramePipeline {
+public:
+    static const int kMaxDepth = 3;
+
+    struct Stats {
+        int depth;
+        // frames retired at this depth
+        unsigned int frameCount;
+        // from the beginning of a frame to its fence seen signalled
+        double averageLatencyMs;
+        // time beginFrame() waited for a frame to retire
+        double averageStallMs;
+        double framesPerSecond;
+        // against depth 1, both 0 until depth 1 has been measured
+        double addedLatencyMs;
+        double throughputGain;
+    };
+
+    FramePipeline(int depth = 2);
+    ~FramePipeline();
+
+    void setDepth(int depth);
+    int getDepth() const { return _depth; }
+
+    // Open a frame, waiting for the oldest one while depth frames are in
+    // flight. Does nothing if a frame is open already.
+    void beginFrame();
+    // close the open frame with a fence and let it fly
+    void endFrame();
+    bool isFrameOpen() const { return _isFrameOpen; }
+
+    // retire the frames whose fences have signalled, never blocks
+    void poll();
+    // wait for and retire every frame in flight
+    void finish();
+    int getFrameCount() const { return (int)_frames.size(); }
+
+    // stats of depth, 0 for the current one; may be called on any thread
+    Stats getStats(int depth = 0) const;
+    void resetStats();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Frame {
+        GLsync fence;
+        std::vector<Framebuffer*> framebuffers;
+        Clock::time_point beginTime;
+        double stallMs;
+        // the depth it was begun at, its stats go there
+        int depth;
+    };
+
+    struct DepthStats {
+        unsigned int frameCount;
+        double latencyMs;
+        double stallMs;
+        Clock::time_point firstRetireTime;
+        Clock::time_point lastRetireTime;
+    };
+
+    // the context it was made in, 0 for the default one
+    Context* _context;
+    int _depth;
+    std::deque<Frame> _frames;
+    Frame _openFrame;
+    bool _isFrameOpen;
+    mutable std::mutex _statsMutex;
+    DepthStats _depthStats[kMaxDepth + 1];
+
+    void _retire(Frame& frame, bool wait);
+    static void _releaseFrame(Frame& frame, Context* context);
+    Stats _getStats(int depth) const;
+};
+
+NS_GI_END
+
+#endif /* FramePipeline_hpp */
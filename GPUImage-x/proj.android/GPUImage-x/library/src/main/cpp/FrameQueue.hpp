@@ -0,0 +1,118 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FrameQueue_hpp
+#define FrameQueue_hpp
+
+#include "macros.h"
+#include "target/Target.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+NS_GI_BEGIN
+
+// FrameQueue sits between a producer that delivers frames at its own rate, a
+// camera, and the GL thread that processes them, and decides what happens
+// when processing falls behind:
+//
+//   LatestFrameWins  one frame is kept, a newer one replaces it unprocessed
+//   BoundedQueue     up to capacity frames are kept, the oldest is dropped
+//   Block            up to capacity frames are kept, push() waits for room
+//
+// Either way no more than capacity frames wait, so the time from push() to
+// processing stays bounded by the processing time of capacity frames however
+// slow the filters are. The pixels are copied in, the producer may reuse its
+// buffer as soon as push() returns; copies are recycled.
+class FrameQueue {
+public:
+    enum Policy {
+        LatestFrameWins = 0,
+        BoundedQueue = 1,
+        Block = 2
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Frame {
+        int width;
+        int height;
+        // what the pixels are, up to the producer and the consumer
+        int format;
+        RotationMode rotation;
+        std::vector<unsigned char> pixels;
+        Clock::time_point queueTime;
+    };
+
+    struct Counters {
+        // frames pushed, dropped before they were processed and processed
+        unsigned long long queuedCount;
+        unsigned long long droppedCount;
+        unsigned long long processedCount;
+        // frames waiting now
+        int pendingCount;
+        // from push() to processed
+        double averageLatencyMs;
+        double maxLatencyMs;
+    };
+
+    FrameQueue(Policy policy = LatestFrameWins, int capacity = 1);
+    ~FrameQueue();
+
+    // capacity is 1 for LatestFrameWins; frames over a smaller capacity are dropped
+    void setPolicy(Policy policy, int capacity = 1);
+    Policy getPolicy() const;
+    int getCapacity() const;
+
+    // Copy a frame in, on any thread but the one that pops. Returns false if it
+    // was dropped at once, the queue being closed.
+    bool push(int width, int height, int format, RotationMode rotation, const void* pixels, size_t size);
+    // Take the oldest frame into frame, false if none is waiting. Give it back
+    // with processed() once done, its copy is reused.
+    bool pop(Frame& frame);
+    void processed(Frame& frame);
+
+    // drop what is waiting and let blocked pushes return, until reopened
+    void close();
+    void open();
+
+    Counters getCounters() const;
+    void resetCounters();
+
+private:
+    mutable std::mutex _mutex;
+    std::condition_variable _spaceAvailable;
+    Policy _policy;
+    int _capacity;
+    bool _isClosed;
+    std::deque<Frame> _frames;
+    std::vector<std::vector<unsigned char>> _freeBuffers;
+    unsigned long long _queuedCount;
+    unsigned long long _droppedCount;
+    unsigned long long _processedCount;
+    double _latencyMs;
+    double _maxLatencyMs;
+
+    void _dropFront();
+};
+
+NS_GI_END
+
+#endif /* FrameQueue_hpp */
@@ -27,11 +27,16 @@
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 #endif
+#include "GLMock.hpp"
+#include <mutex>
+#include <stdint.h>
 #include <vector>
 #include "Ref.hpp"
 
 NS_GI_BEGIN
 
+class Context;
+
 typedef struct {
     GLenum minFilter;
     GLenum magFilter;
@@ -62,6 +67,10 @@ public:
     int getHeight() const { return _height; }
     const TextureAttributes& getTextureAttributes() const { return _textureAttributes; };
     bool hasFramebuffer() { return _hasFB; };
+
+    // when the frame it holds was taken, see getMonotonicTimestamp(); 0 if unknown
+    int64_t getTimestamp() const { return _timestamp; }
+    void setTimestamp(int64_t timestamp) { _timestamp = timestamp; }
     
     void active();
     void inactive();
@@ -69,16 +78,20 @@ public:
     static TextureAttributes defaultTextureAttribures;
     
 private:
+    // the context it was made in, 0 for the default one; it goes back to its cache
+    Context* _context;
     int _width, _height;
     TextureAttributes _textureAttributes;
     bool _hasFB;
     GLuint _texture;
     GLuint _framebuffer;
+    int64_t _timestamp;
     
     void _generateTexture();
     void _generateFramebuffer();
 
     static std::vector<Framebuffer*> _framebuffers;
+    static std::mutex _framebuffersMutex;
 };
 
 
@@ -23,6 +23,7 @@ NS_GI_BEGIN
 
 
 FramebufferCache::FramebufferCache()
+:_frameSet(0)
 {
 }
 
@@ -32,6 +33,7 @@ FramebufferCache::~FramebufferCache() {
 
 Framebuffer* FramebufferCache::fetchFramebuffer(int width, int height, bool onlyTexture/* = false*/, const TextureAttributes textureAttributes/* = defaultTextureAttribure*/) {
     
+    std::lock_guard<std::mutex> lock(_mutex);
     Framebuffer* framebufferFromCache = 0;
     std::string lookupHash = _getHash(width, height, onlyTexture, textureAttributes);
     int numberOfMatchingFramebuffers = 0;
@@ -61,11 +63,17 @@ Framebuffer* FramebufferCache::fetchFramebuffer(int width, int height, bool only
     
     // make sure this framebuffer is not referenced by others
     framebufferFromCache->resetRefenceCount();
+    framebufferFromCache->setTimestamp(0);
+    if (_frameSet) {
+        framebufferFromCache->retain();
+        _frameSet->push_back(framebufferFromCache);
+    }
     return framebufferFromCache;
 }
 
 void FramebufferCache::returnFramebuffer(Framebuffer* framebuffer) {
     if (framebuffer == 0) return;
+    std::lock_guard<std::mutex> lock(_mutex);
     int width = framebuffer->getWidth();
     int height = framebuffer->getHeight();
     const TextureAttributes& textureAttributes = framebuffer->getTextureAttributes();
@@ -95,12 +103,16 @@ Framebuffer* FramebufferCache::_getFramebufferByHash(const std::string& hash) {
 }
 
 void FramebufferCache::purge() {
-    for(const auto kvp : _framebuffers)
+    std::map<std::string, Framebuffer*> framebuffers;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        framebuffers.swap(_framebuffers);
+        _framebufferTypeCounts.clear();
+    }
+    for(const auto& kvp : framebuffers)
     {
         delete kvp.second;
     }
-    _framebuffers.clear();
-    _framebufferTypeCounts.clear();
 }
 
 NS_GI_END
@@ -23,15 +23,32 @@
 #include "Context.hpp"
 #include "Framebuffer.hpp"
 #include "FramebufferCache.hpp"
+#include "FrameDataPool.hpp"
+#include "InputTexture.hpp"
 #include "GLProgram.hpp"
+#include "GLMock.hpp"
+#include "GLES3.hpp"
+#include "ReadbackQueue.hpp"
 #include "macros.h"
+#include "MultiCapture.hpp"
+#include "GraphOptimizer.hpp"
+#include "RenderThread.hpp"
+#include "BatchProcessor.hpp"
+#include "FramePipeline.hpp"
+#include "FrameQueue.hpp"
+#include "FrameMetrics.hpp"
+#include "QualityController.hpp"
 #include "math.hpp"
 #include "Ref.hpp"
 #include "util.h"
+#include "YUVConverter.hpp"
 #include "source/Source.hpp"
 #include "source/SourceImage.h"
 #include "source/SourceCamera.h"
 #include "target/Target.hpp"
+#include "target/ReadbackTarget.hpp"
+#include "target/YUVTarget.hpp"
+#include "target/TensorTarget.hpp"
 #include "target/TargetView.h"
 #if PLATFORM == PLATFORM_IOS
 #include "target/iOS/IOSTarget.hpp"
@@ -0,0 +1,66 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GraphOptimizer_hpp
+#define GraphOptimizer_hpp
+
+#include "macros.h"
+#include "source/Source.hpp"
+#include "filter/Filter.hpp"
+#include <vector>
+
+NS_GI_BEGIN
+
+// GraphOptimizer finds filters reachable from a source that would compute the
+// same output, the same class and properties over the same inputs, e.g. two
+// saturation filters with the same level attached to one camera, and has them
+// share a single draw per pass. Inputs count as the same once their own
+// filters have been merged, so whole identical chains collapse to one.
+//
+// The graph itself is left as it is: merged filters keep their targets and
+// can be changed, removed or retargeted as usual. Any such change, and any
+// property set, marks the merges stale and update() works them out again.
+// Only filters created by class name take part, compared by their merge key,
+// see Filter::getMergeKey(). Filter groups are never merged, neither as a
+// whole nor their members, e.g. two identical Gaussian blurs or the grayscale
+// steps of a sketch and a toon filter each still draw, and neither are
+// filters fed from outside of the graph of the source.
+class GraphOptimizer {
+public:
+    GraphOptimizer(Source* source);
+    ~GraphOptimizer();
+
+    // re-evaluates the merges if the graph changed since the last call
+    void update();
+    // filters that do not draw because an identical one does
+    int getMergedFilterCount() const { return _mergedFilterCount; }
+
+private:
+    Source* _source;
+    unsigned int _graphRevision;
+    bool _evaluated;
+    int _mergedFilterCount;
+    std::vector<Filter*> _mergedFilters;
+
+    void _merge();
+    void _clear();
+};
+
+NS_GI_END
+
+#endif /* GraphOptimizer_hpp */
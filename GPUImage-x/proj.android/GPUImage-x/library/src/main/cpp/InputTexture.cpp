@@ -0,0 +1,189 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InputTexture.hpp"
+#include <string.h>
+#include "GLES3.hpp"
+#include "Context.hpp"
+#include "util.h"
+
+NS_GI_BEGIN
+
+InputTexture::InputTexture(int bufferCount/* = 2*/, bool usePixelBuffers/* = false*/)
+:_context(Context::getCurrent())
+,_bufferCount(bufferCount < kMinBufferCount ? kMinBufferCount : (bufferCount > kMaxBufferCount ? kMaxBufferCount : bufferCount))
+,_current(-1)
+,_usePixelBuffers(usePixelBuffers)
+{
+    for (int i = 0; i < kMaxBufferCount; ++i) {
+        _framebuffers[i] = 0;
+        _pixelBuffers[i] = 0;
+        _pixelBufferSizes[i] = 0;
+        _fences[i] = 0;
+    }
+}
+
+InputTexture::~InputTexture() {
+    releaseTextures();
+}
+
+Framebuffer* InputTexture::upload(int width, int height, const void* pixels, const TextureAttributes& textureAttributes/* = Framebuffer::defaultTextureAttribures*/) {
+    _current = (_current + 1) % _bufferCount;
+    Framebuffer* framebuffer = _framebuffers[_current];
+
+    int rowSize = width * _getBytesPerPixel(textureAttributes);
+    if (rowSize % 4 != 0) {
+        CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    }
+
+    if (framebuffer && _isCompatible(framebuffer, width, height, textureAttributes)) {
+        CHECK_GL(glBindTexture(GL_TEXTURE_2D, framebuffer->getTexture()));
+        if (!(_usePixelBuffers && GLES3::isAvailable()
+              && _uploadThroughPixelBuffer(width, height, pixels, (GLsizeiptr)rowSize * height, textureAttributes))) {
+            CHECK_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, textureAttributes.format, textureAttributes.type, pixels));
+        }
+    } else {
+        if (framebuffer) {
+            // still referenced by a source or a target, it goes back to the framebuffer cache once they let go
+            framebuffer->release(false);
+        }
+        framebuffer = _framebuffers[_current] = new Framebuffer(width, height, true, textureAttributes);
+        CHECK_GL(glBindTexture(GL_TEXTURE_2D, framebuffer->getTexture()));
+        CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, textureAttributes.internalFormat, width, height, 0, textureAttributes.format, textureAttributes.type, pixels));
+    }
+    CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+
+    if (rowSize % 4 != 0) {
+        CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    }
+    return framebuffer;
+}
+
+Framebuffer* InputTexture::getFramebuffer() const {
+    return _current < 0 ? 0 : _framebuffers[_current];
+}
+
+void InputTexture::setBufferCount(int bufferCount) {
+    // textures past a shrunk ring are kept until releaseTextures(), the ring wraps on the next upload
+    _bufferCount = bufferCount < kMinBufferCount ? kMinBufferCount : (bufferCount > kMaxBufferCount ? kMaxBufferCount : bufferCount);
+}
+
+void InputTexture::releaseTextures() {
+    for (int i = 0; i < kMaxBufferCount; ++i) {
+        if (_framebuffers[i]) {
+            _framebuffers[i]->release(false);
+            _framebuffers[i] = 0;
+        }
+        GLuint pixelBuffer = _pixelBuffers[i];
+        GLsync fence = _fences[i];
+        if (pixelBuffer || fence) {
+            Context::deferDeletion(_context, [pixelBuffer, fence]() {
+                if (pixelBuffer) {
+                    CHECK_GL(glDeleteBuffers(1, &pixelBuffer));
+                }
+                if (fence) {
+                    GLES3::deleteSync(fence);
+                }
+            });
+        }
+        _pixelBuffers[i] = 0;
+        _pixelBufferSizes[i] = 0;
+        _fences[i] = 0;
+    }
+    _current = -1;
+}
+
+bool InputTexture::_uploadThroughPixelBuffer(int width, int height, const void* pixels, GLsizeiptr size, const TextureAttributes& textureAttributes) {
+    GLuint& pixelBuffer = _pixelBuffers[_current];
+    GLsync& fence = _fences[_current];
+    if (!pixelBuffer) {
+        CHECK_GL(glGenBuffers(1, &pixelBuffer));
+    }
+    CHECK_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer));
+
+    // The transfer issued from this buffer a ring ago has normally finished by
+    // now. If it has not, orphan the storage rather than wait for the GPU.
+    if (_pixelBufferSizes[_current] != size || !GLES3::isSignaled(fence)) {
+        CHECK_GL(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_STREAM_DRAW));
+        _pixelBufferSizes[_current] = size;
+    }
+    if (fence) {
+        GLES3::deleteSync(fence);
+        fence = 0;
+    }
+
+    void* mapped = GLES3::mapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!mapped) {
+        Log("WARNING", "InputTexture: failed to map the pixel unpack buffer, uploading directly");
+        CHECK_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        return false;
+    }
+    memcpy(mapped, pixels, size);
+    if (!GLES3::unmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+        // the buffer contents were lost, e.g. on a display mode change
+        CHECK_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        return false;
+    }
+
+    // with an unpack buffer bound the data pointer is an offset into it
+    CHECK_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, textureAttributes.format, textureAttributes.type, 0));
+    fence = GLES3::fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    CHECK_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    return true;
+}
+
+int InputTexture::_getBytesPerPixel(const TextureAttributes& textureAttributes) {
+    int components = 4;
+    switch (textureAttributes.format) {
+        case GL_ALPHA:
+        case GL_LUMINANCE:
+            components = 1;
+            break;
+        case GL_LUMINANCE_ALPHA:
+            components = 2;
+            break;
+        case GL_RGB:
+            components = 3;
+            break;
+        default:
+            break;
+    }
+    switch (textureAttributes.type) {
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            return 2;
+        default:
+            return components;
+    }
+}
+
+bool InputTexture::_isCompatible(const Framebuffer* framebuffer, int width, int height, const TextureAttributes& textureAttributes) {
+    const TextureAttributes& current = framebuffer->getTextureAttributes();
+    return framebuffer->getWidth() == width
+        && framebuffer->getHeight() == height
+        && current.minFilter == textureAttributes.minFilter
+        && current.magFilter == textureAttributes.magFilter
+        && current.wrapS == textureAttributes.wrapS
+        && current.wrapT == textureAttributes.wrapT
+        && current.internalFormat == textureAttributes.internalFormat
+        && current.format == textureAttributes.format
+        && current.type == textureAttributes.type;
+}
+
+NS_GI_END
@@ -0,0 +1,79 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef InputTexture_hpp
+#define InputTexture_hpp
+
+#include "macros.h"
+#include "Framebuffer.hpp"
+
+NS_GI_BEGIN
+
+class Context;
+
+// InputTexture streams client memory into a small ring of persistent textures.
+// Storage is allocated with glTexImage2D only when the size or the texture
+// attributes change; every other frame is written with glTexSubImage2D. Each
+// upload goes to the next texture of the ring, so writing frame N+1 does not
+// have to wait for the GPU to finish sampling frame N.
+//
+// With usePixelBuffers on a GLES3 context, each texture of the ring also has
+// a pixel unpack buffer. The frame is copied into the mapped buffer and the
+// driver moves it into the texture asynchronously; a fence marks when the
+// buffer may be written again. GLES2 contexts upload from client memory.
+class InputTexture {
+public:
+    InputTexture(int bufferCount = 2, bool usePixelBuffers = false);
+    ~InputTexture();
+
+    // Upload tightly packed pixels and return the texture-only framebuffer holding them.
+    Framebuffer* upload(int width, int height, const void* pixels, const TextureAttributes& textureAttributes = Framebuffer::defaultTextureAttribures);
+
+    // the framebuffer written by the last upload
+    Framebuffer* getFramebuffer() const;
+
+    // Resize the ring, one more than the frames in flight keeps the next
+    // upload off every texture the GPU may still sample. Two at least, a
+    // single texture would be written while the last frame is sampled.
+    void setBufferCount(int bufferCount);
+    int getBufferCount() const { return _bufferCount; }
+
+    // give up the textures, the next upload allocates new storage
+    void releaseTextures();
+
+private:
+    static const int kMinBufferCount = 2;
+    static const int kMaxBufferCount = 4;
+    Framebuffer* _framebuffers[kMaxBufferCount];
+    GLuint _pixelBuffers[kMaxBufferCount];
+    GLsizeiptr _pixelBufferSizes[kMaxBufferCount];
+    GLsync _fences[kMaxBufferCount];
+    // the context it was made in, 0 for the default one
+    Context* _context;
+    int _bufferCount;
+    int _current;
+    bool _usePixelBuffers;
+
+    bool _uploadThroughPixelBuffer(int width, int height, const void* pixels, GLsizeiptr size, const TextureAttributes& textureAttributes);
+    static int _getBytesPerPixel(const TextureAttributes& textureAttributes);
+    static bool _isCompatible(const Framebuffer* framebuffer, int width, int height, const TextureAttributes& textureAttributes);
+};
+
+NS_GI_END
+
+#endif /* InputTexture_hpp */
@@ -0,0 +1,68 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MultiCapture_hpp
+#define MultiCapture_hpp
+
+#include "macros.h"
+#include "filter/Filter.hpp"
+#include "target/ReadbackTarget.hpp"
+#include <vector>
+
+NS_GI_BEGIN
+
+// MultiCapture reads back the outputs of several filters of one graph from a
+// single pass, e.g. an edge mask and the final image of the same frame. Each
+// capture point has its own output size and format. During capture() every
+// point holds its frame while the graph renders, and all reads are issued
+// together once the pass is over.
+//
+// Results go through the ReadbackQueue of the source's context: on GLES2 the callback runs
+// for every point before capture() returns, on GLES3 from a later poll. Call
+// finish() on the queue to wait for them.
+class MultiCapture {
+public:
+    typedef std::function<void(int pointIndex, const unsigned char* pixels, int width, int height)> Callback;
+
+    MultiCapture();
+    ~MultiCapture();
+
+    // Returns the index the results of the point are reported with. A width or
+    // height of 0 keeps the size of the filter output.
+    int addCapturePoint(Filter* filter, int width = 0, int height = 0, ReadbackTarget::Format format = ReadbackTarget::RGBA);
+    void removeAllCapturePoints();
+    int getCapturePointCount() const { return (int)_capturePoints.size(); }
+    ReadbackTarget::Format getCapturePointFormat(int index) const { return _capturePoints[index].target->getOutputFormat(); }
+    // in 0 to 1 of the filter output, see ReadbackTarget::setCropRegion
+    void setCapturePointCropRegion(int index, float x, float y, float width, float height);
+
+    // Runs the graph of source once and reads every capture point back. Returns
+    // false if a point was not reached by the pass.
+    bool capture(Source* source, Callback callback);
+
+private:
+    struct CapturePoint {
+        Filter* filter;
+        ReadbackTarget* target;
+    };
+    std::vector<CapturePoint> _capturePoints;
+};
+
+NS_GI_END
+
+#endif /* MultiCapture_hpp */
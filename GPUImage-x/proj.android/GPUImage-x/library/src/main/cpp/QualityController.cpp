@@ -0,0 +1,283 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QualityController.hpp"
+#include "util.h"
+#include "source/Source.hpp"
+#include "filter/Filter.hpp"
+#include <algorithm>
+
+NS_GI_BEGIN
+
+// weight of a new frame in the smoothed frame time
+static const double kSmoothing = 0.2;
+// frames begun before a step still run at the old level and are not counted
+static const int kSettleFrames = 3;
+// the longest a step up waits, in multiples of the upgrade frames
+static const int kMaxUpgradeBackoff = 16;
+
+QualityController::QualityController()
+:_nextKnobId(0)
+,_budgetMs(0)
+,_downgradeFrames(5)
+,_upgradeFrames(60)
+,_upgradeFraction(0.75)
+,_frameTimeMs(0)
+,_sampleCount(0)
+,_overBudgetCount(0)
+,_underBudgetCount(0)
+,_upgradeWait(60)
+,_framesSinceUpgrade(-1)
+,_downgradeCount(0)
+,_upgradeCount(0)
+{
+}
+
+QualityController::~QualityController() {
+    removeAllKnobs();
+}
+
+void QualityController::setFrameBudget(double budgetMs) {
+    std::vector<std::pair<Apply, int>> applies;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _budgetMs = budgetMs > 0 ? budgetMs : 0;
+        _sampleCount = 0;
+        _overBudgetCount = 0;
+        _underBudgetCount = 0;
+        _upgradeWait = _upgradeFrames;
+        _framesSinceUpgrade = -1;
+        if (_budgetMs == 0) {
+            for (auto& knob : _knobs) {
+                if (knob.level != 0) {
+                    knob.level = 0;
+                    applies.push_back(std::make_pair(knob.apply, 0));
+                }
+            }
+        }
+    }
+    for (auto const& apply : applies) {
+        apply.first(apply.second);
+    }
+}
+
+double QualityController::getFrameBudget() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _budgetMs;
+}
+
+bool QualityController::isActive() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _budgetMs > 0 && !_knobs.empty();
+}
+
+void QualityController::setHysteresis(int downgradeFrames, int upgradeFrames, double upgradeFraction) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _downgradeFrames = downgradeFrames > 1 ? downgradeFrames : 1;
+    _upgradeFrames = upgradeFrames > 1 ? upgradeFrames : 1;
+    _upgradeFraction = (upgradeFraction > 0 && upgradeFraction < 1) ? upgradeFraction : 0.75;
+    _upgradeWait = _upgradeFrames;
+}
+
+int QualityController::addKnob(const std::string& name, int levelCount, Apply apply) {
+    if (levelCount < 2 || !apply) {
+        Log("WARNING", "QualityController::addKnob %s needs two levels or more", name.c_str());
+        return -1;
+    }
+    Knob knob;
+    knob.name = name;
+    knob.levelCount = levelCount;
+    knob.level = 0;
+    knob.apply = apply;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        knob.id = _nextKnobId++;
+        _knobs.push_back(knob);
+    }
+    apply(0);
+    return knob.id;
+}
+
+int QualityController::addFramebufferScaleKnob(Source* source, const std::vector<float>& scales) {
+    if (!source || scales.size() < 2) return -1;
+    source->retain();
+    std::vector<float> levels = scales;
+    int knobId = addKnob("framebufferScale", (int)levels.size(), [source, levels](int level) {
+        source->setFramebufferScale(levels[level]);
+    });
+    if (knobId < 0) {
+        source->release();
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _knobs.back().release = [source]() { source->release(); };
+    return knobId;
+}
+
+int QualityController::addPropertyKnob(Filter* filter, const std::string& property, const std::vector<float>& values) {
+    std::string type;
+    if (!filter || !filter->getPropertyType(property, type) || type == "string") {
+        Log("WARNING", "QualityController::addPropertyKnob no number property %s", property.c_str());
+        return -1;
+    }
+    if (values.size() < 2) return -1;
+    filter->retain();
+    std::vector<float> levels = values;
+    bool isInt = (type == "int");
+    int knobId = addKnob(property, (int)levels.size(), [filter, property, levels, isInt](int level) {
+        if (isInt) {
+            filter->setProperty(property, (int)levels[level]);
+        } else {
+            filter->setProperty(property, levels[level]);
+        }
+    });
+    if (knobId < 0) {
+        filter->release();
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _knobs.back().release = [filter]() { filter->release(); };
+    return knobId;
+}
+
+void QualityController::removeKnob(int knobId) {
+    Knob knob;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<Knob>::iterator it = _knobs.begin();
+        for (; it != _knobs.end() && it->id != knobId; ++it);
+        if (it == _knobs.end()) return;
+        knob = *it;
+        _knobs.erase(it);
+    }
+    if (knob.level != 0) {
+        knob.apply(0);
+    }
+    if (knob.release) {
+        knob.release();
+    }
+}
+
+void QualityController::removeAllKnobs() {
+    std::vector<Knob> knobs;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        knobs.swap(_knobs);
+    }
+    for (auto const& knob : knobs) {
+        if (knob.level != 0) {
+            knob.apply(0);
+        }
+        if (knob.release) {
+            knob.release();
+        }
+    }
+}
+
+int QualityController::getKnobLevel(int knobId) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto const& knob : _knobs) {
+        if (knob.id == knobId) return knob.level;
+    }
+    return -1;
+}
+
+void QualityController::recordFrame(int64_t frameTimeUs) {
+    std::vector<std::pair<Apply, int>> applies;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_sampleCount++ < kSettleFrames) return;
+        double frameTimeMs = frameTimeUs / 1000.0;
+        _frameTimeMs = (_sampleCount == kSettleFrames + 1) ? frameTimeMs : _frameTimeMs + (frameTimeMs - _frameTimeMs) * kSmoothing;
+        if (_budgetMs == 0 || _knobs.empty()) return;
+
+        if (_framesSinceUpgrade >= 0 && ++_framesSinceUpgrade >= _upgradeFrames) {
+            // the step up held, the next one needs no longer wait
+            _upgradeWait = _upgradeFrames;
+            _framesSinceUpgrade = -1;
+        }
+        _overBudgetCount = (_frameTimeMs > _budgetMs) ? _overBudgetCount + 1 : 0;
+        _underBudgetCount = (_frameTimeMs < _budgetMs * _upgradeFraction) ? _underBudgetCount + 1 : 0;
+
+        if (_overBudgetCount >= _downgradeFrames && _step(true, applies)) {
+            ++_downgradeCount;
+            if (_framesSinceUpgrade >= 0) {
+                // the level just stepped up to did not hold
+                _upgradeWait = std::min(_upgradeWait * 2, _upgradeFrames * kMaxUpgradeBackoff);
+                _framesSinceUpgrade = -1;
+            }
+        } else if (_underBudgetCount >= _upgradeWait && _step(false, applies)) {
+            ++_upgradeCount;
+            _framesSinceUpgrade = 0;
+        }
+        if (!applies.empty()) {
+            _sampleCount = 0;
+            _overBudgetCount = 0;
+            _underBudgetCount = 0;
+        }
+    }
+    for (auto const& apply : applies) {
+        apply.first(apply.second);
+    }
+}
+
+// Knobs are given up in the order they were added: stepping down lowers the
+// first one that has a level left, stepping up raises the last one lowered.
+bool QualityController::_step(bool down, std::vector<std::pair<Apply, int>>& applies) {
+    if (down) {
+        for (auto& knob : _knobs) {
+            if (knob.level < knob.levelCount - 1) {
+                applies.push_back(std::make_pair(knob.apply, ++knob.level));
+                return true;
+            }
+        }
+    } else {
+        for (std::vector<Knob>::reverse_iterator it = _knobs.rbegin(); it != _knobs.rend(); ++it) {
+            if (it->level > 0) {
+                applies.push_back(std::make_pair(it->apply, --it->level));
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int QualityController::_getLevel() const {
+    int level = 0;
+    for (auto const& knob : _knobs) {
+        level += knob.level;
+    }
+    return level;
+}
+
+QualityController::Stats QualityController::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Stats stats;
+    stats.budgetMs = _budgetMs;
+    stats.frameTimeMs = _frameTimeMs;
+    stats.level = _getLevel();
+    stats.maxLevel = 0;
+    for (auto const& knob : _knobs) {
+        stats.maxLevel += knob.levelCount - 1;
+    }
+    stats.downgradeCount = _downgradeCount;
+    stats.upgradeCount = _upgradeCount;
+    return stats;
+}
+
+NS_GI_END
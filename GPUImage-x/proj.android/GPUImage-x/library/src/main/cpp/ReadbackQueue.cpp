@@ -0,0 +1,215 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ReadbackQueue.hpp"
+#include <string.h>
+#include "GLES3.hpp"
+#include "Context.hpp"
+#include "util.h"
+
+NS_GI_BEGIN
+
+// how long a full ring waits for its oldest read, in nanoseconds
+static const GLuint64 kReadbackTimeout = 1000000000;
+
+ReadbackQueue::ReadbackQueue(int depth/* = 3*/)
+:_next(0)
+,_deliveredTimestamp(0)
+,_deliveryDepth(0)
+{
+    Slot slot;
+    slot.buffer = 0;
+    slot.size = 0;
+    slot.fence = 0;
+    slot.width = 0;
+    slot.height = 0;
+    slot.timestamp = 0;
+    slot.isDelivering = false;
+    _slots.resize(depth < 1 ? 1 : depth, slot);
+}
+
+ReadbackQueue::~ReadbackQueue() {
+    // pending reads are dropped, their callbacks never run
+    for (auto& slot : _slots) {
+        if (slot.fence) {
+            GLES3::deleteSync(slot.fence);
+            slot.fence = 0;
+        }
+        if (slot.buffer) {
+            CHECK_GL(glDeleteBuffers(1, &slot.buffer));
+            slot.buffer = 0;
+        }
+    }
+}
+
+void ReadbackQueue::read(Framebuffer* framebuffer, Callback callback) {
+    int width = framebuffer->getWidth();
+    int height = framebuffer->getHeight();
+
+    if (!GLES3::isAvailable() || _slots[_next].isDelivering) {
+        _readBlocking(framebuffer, callback);
+        return;
+    }
+
+    Slot& slot = _slots[_next];
+    if (_isPending(slot)) {
+        // the ring is full, the oldest read has to complete first
+        _deliver(slot);
+    }
+    _next = (_next + 1) % _slots.size();
+
+    GLsizeiptr size = (GLsizeiptr)width * height * 4;
+    if (!slot.buffer) {
+        CHECK_GL(glGenBuffers(1, &slot.buffer));
+    }
+    CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer));
+    if (slot.size != size) {
+        CHECK_GL(glBufferData(GL_PIXEL_PACK_BUFFER, size, 0, GL_STREAM_READ));
+        slot.size = size;
+    }
+    framebuffer->active();
+    // with a pack buffer bound the pointer is an offset and glReadPixels returns without waiting
+    CHECK_GL(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0));
+    framebuffer->inactive();
+    CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    slot.fence = GLES3::fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // make sure the fence reaches the GPU, otherwise poll() could never see it signalled
+    CHECK_GL(glFlush());
+    slot.width = width;
+    slot.height = height;
+    slot.timestamp = framebuffer->getTimestamp();
+    slot.callback = callback;
+}
+
+bool ReadbackQueue::readInto(Framebuffer* framebuffer, unsigned char* pixels, int stride/* = 0*/) {
+    int width = framebuffer->getWidth();
+    int height = framebuffer->getHeight();
+    int rowSize = width * 4;
+    if (stride <= 0) stride = rowSize;
+    if (stride < rowSize) {
+        Log("WARNING", "ReadbackQueue: stride %d is too small for a %dx%d read", stride, width, height);
+        return false;
+    }
+
+    framebuffer->active();
+    if (stride == rowSize) {
+        CHECK_GL(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    } else if (stride % 4 == 0 && GLES3::isAvailable()) {
+        // GLES3 lays the rows out itself
+        CHECK_GL(glPixelStorei(GL_PACK_ROW_LENGTH, stride / 4));
+        CHECK_GL(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+        CHECK_GL(glPixelStorei(GL_PACK_ROW_LENGTH, 0));
+    } else {
+        // GLES2 only packs tightly, go through the scratch buffer, a fresh one
+        // when a callback may still be reading it
+        std::vector<unsigned char> nestedPixels;
+        std::vector<unsigned char>& scratchPixels = _deliveryDepth > 0 ? nestedPixels : _syncPixels;
+        scratchPixels.resize(rowSize * height);
+        CHECK_GL(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &scratchPixels[0]));
+        for (int y = 0; y < height; ++y) {
+            memcpy(pixels + y * stride, &scratchPixels[y * rowSize], rowSize);
+        }
+    }
+    framebuffer->inactive();
+    Context::getInstance()->getFrameMetrics()->recordLatency(FrameMetrics::CaptureLatency, framebuffer->getTimestamp());
+    return true;
+}
+
+void ReadbackQueue::poll() {
+    // pending slots always form a run that ends right before _next
+    for (size_t i = 0; i < _slots.size(); ++i) {
+        Slot& slot = _slots[(_next + i) % _slots.size()];
+        if (!_isPending(slot)) continue;
+        if (!GLES3::isSignaled(slot.fence)) break;
+        _deliver(slot);
+    }
+}
+
+void ReadbackQueue::finish() {
+    for (size_t i = 0; i < _slots.size(); ++i) {
+        Slot& slot = _slots[(_next + i) % _slots.size()];
+        if (_isPending(slot)) {
+            _deliver(slot);
+        }
+    }
+}
+
+int ReadbackQueue::getPendingCount() const {
+    int count = 0;
+    for (const auto& slot : _slots) {
+        if (_isPending(slot)) ++count;
+    }
+    return count;
+}
+
+void ReadbackQueue::_deliver(Slot& slot) {
+    GLenum result = GLES3::clientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kReadbackTimeout);
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+        Log("WARNING", "ReadbackQueue: waiting for a %dx%d read failed (0x%04X)", slot.width, slot.height, result);
+    }
+    GLES3::deleteSync(slot.fence);
+    slot.fence = 0;
+
+    // the callback may issue new reads, so take it out of the slot first
+    Callback callback = slot.callback;
+    slot.callback = nullptr;
+
+    CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer));
+    const unsigned char* pixels = (const unsigned char*)GLES3::mapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+    if (!pixels) {
+        Log("WARNING", "ReadbackQueue: failed to map a %dx%d read", slot.width, slot.height);
+        CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+        return;
+    }
+    // unbound while the callback runs, a glReadPixels there must not land in it
+    CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    int64_t deliveredTimestamp = _deliveredTimestamp;
+    _deliveredTimestamp = slot.timestamp;
+    Context::getInstance()->getFrameMetrics()->recordLatency(FrameMetrics::CaptureLatency, _deliveredTimestamp);
+    slot.isDelivering = true;
+    ++_deliveryDepth;
+    callback(pixels, slot.width, slot.height);
+    --_deliveryDepth;
+    slot.isDelivering = false;
+    _deliveredTimestamp = deliveredTimestamp;
+    CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer));
+    GLES3::unmapBuffer(GL_PIXEL_PACK_BUFFER);
+    CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+void ReadbackQueue::_readBlocking(Framebuffer* framebuffer, const Callback& callback) {
+    int width = framebuffer->getWidth();
+    int height = framebuffer->getHeight();
+    // a callback reading again must not reallocate the pixels it was given
+    std::vector<unsigned char> nestedPixels;
+    std::vector<unsigned char>& pixels = _deliveryDepth > 0 ? nestedPixels : _syncPixels;
+    pixels.resize(width * height * 4);
+    framebuffer->active();
+    CHECK_GL(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]));
+    framebuffer->inactive();
+    int64_t deliveredTimestamp = _deliveredTimestamp;
+    _deliveredTimestamp = framebuffer->getTimestamp();
+    Context::getInstance()->getFrameMetrics()->recordLatency(FrameMetrics::CaptureLatency, _deliveredTimestamp);
+    ++_deliveryDepth;
+    callback(&pixels[0], width, height);
+    --_deliveryDepth;
+    _deliveredTimestamp = deliveredTimestamp;
+}
+
+NS_GI_END
@@ -0,0 +1,344 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RenderThread.hpp"
+#include "util.h"
+
+#if PLATFORM != PLATFORM_IOS && !ENABLE_GL_MOCK
+#include <EGL/egl.h>
+#define RENDER_THREAD_USE_EGL 1
+#else
+#define RENDER_THREAD_USE_EGL 0
+#endif
+
+NS_GI_BEGIN
+
+RenderThread::RenderThread(int capacity/* = 64*/)
+:_capacity(1)
+,_enqueuePosition(0)
+,_dequeuePosition(0)
+,_fullQueueCount(0)
+,_isClosed(false)
+,_postingCount(0)
+,_threadId(std::thread::id())
+,_isSleeping(false)
+,_startResult(0)
+,_isStopping(false)
+,_frameInterval(0)
+,_eglDisplay(0)
+,_eglSurface(0)
+,_eglContext(0)
+{
+    while (_capacity < capacity) {
+        _capacity <<= 1;
+    }
+    _slots = new Slot[_capacity];
+    for (int i = 0; i < _capacity; ++i) {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+RenderThread::~RenderThread() {
+    stop();
+    delete[] _slots;
+    _slots = 0;
+}
+
+bool RenderThread::start(void* sharedContext/* = 0*/) {
+    if (isRunning()) return true;
+
+    std::unique_lock<std::mutex> lock(_sleepMutex);
+    _startResult = 0;
+    _isStopping = false;
+    _isClosed.store(false);
+    _thread = std::thread([this, sharedContext]() {
+        bool isCreated = _createContext(sharedContext);
+        {
+            std::lock_guard<std::mutex> startLock(_sleepMutex);
+            _threadId.store(std::this_thread::get_id());
+            _startResult = isCreated ? 1 : -1;
+        }
+        _wakeUp.notify_all();
+        if (isCreated) {
+            _loop();
+        }
+    });
+    _wakeUp.wait(lock, [this]() { return _startResult != 0; });
+    if (_startResult < 0) {
+        lock.unlock();
+        _thread.join();
+        _threadId.store(std::thread::id());
+        Log("ERROR", "RenderThread: failed to create the GL context");
+        return false;
+    }
+    return true;
+}
+
+void RenderThread::stop() {
+    if (!isRunning()) return;
+    if (isRenderThread()) {
+        Log("ERROR", "RenderThread: cannot stop from the render thread itself");
+        return;
+    }
+
+    // another thread is stopping it already
+    if (_isClosed.exchange(true)) return;
+    // every post that got past the check is queued before the stop command
+    while (_postingCount.load() > 0) {
+        std::this_thread::yield();
+    }
+    Command command = [this]() { _isStopping = true; };
+    _postingCount.fetch_add(1);
+    _enqueue(command);
+    _postingCount.fetch_sub(1);
+    _thread.join();
+    _threadId.store(std::thread::id());
+}
+
+void RenderThread::runSync(Command func) {
+    if (isRenderThread()) {
+        func();
+        return;
+    }
+    if (!isRunning()) {
+        Log("WARNING", "RenderThread: not running, the command is dropped");
+        return;
+    }
+
+    struct Completion {
+        std::mutex mutex;
+        std::condition_variable done;
+        bool isDone;
+    } completion;
+    completion.isDone = false;
+    // two references, small enough for std::function to store without allocating
+    Command command = [&func, &completion]() {
+        func();
+        std::lock_guard<std::mutex> lock(completion.mutex);
+        completion.isDone = true;
+        completion.done.notify_one();
+    };
+    if (!_post(command)) {
+        Log("WARNING", "RenderThread: stopping, the command is dropped");
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(completion.mutex);
+    completion.done.wait(lock, [&completion]() { return completion.isDone; });
+}
+
+void RenderThread::runAsync(Command func) {
+    if (isRenderThread()) {
+        func();
+        return;
+    }
+    if (!isRunning()) {
+        Log("WARNING", "RenderThread: not running, the command is dropped");
+        return;
+    }
+    if (!_post(func)) {
+        Log("WARNING", "RenderThread: stopping, the command is dropped");
+    }
+}
+
+void RenderThread::startFrames(float fps, FrameCallback callback) {
+    if (fps <= 0 || !callback) {
+        Log("WARNING", "RenderThread: invalid frame rate %f", fps);
+        return;
+    }
+    runAsync([this, fps, callback]() {
+        _frameCallback = callback;
+        _frameInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.0 / fps));
+        _framesStart = _nextFrame = std::chrono::steady_clock::now();
+    });
+}
+
+void RenderThread::stopFrames() {
+    runAsync([this]() { _frameCallback = nullptr; });
+}
+
+bool RenderThread::_post(Command& func) {
+    // counted before checking, so stop() either sees this post or it sees stop()
+    _postingCount.fetch_add(1);
+    if (_isClosed.load()) {
+        _postingCount.fetch_sub(1);
+        return false;
+    }
+    _enqueue(func);
+    _postingCount.fetch_sub(1);
+    return true;
+}
+
+void RenderThread::_enqueue(Command& func) {
+    // A slot is free for position p when its sequence is p, and holds a
+    // command for the render thread when it is p + 1. Producers race for a
+    // position with a compare-and-swap, the winner owns the slot.
+    unsigned int position = _enqueuePosition.load(std::memory_order_relaxed);
+    bool wasFull = false;
+    for (;;) {
+        Slot& slot = _slots[position & (_capacity - 1)];
+        unsigned int sequence = slot.sequence.load(std::memory_order_acquire);
+        int diff = (int)(sequence - position);
+        if (diff == 0) {
+            if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.command = std::move(func);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                break;
+            }
+        } else if (diff < 0) {
+            // full, the render thread frees the slot once it takes the command
+            if (!wasFull) {
+                wasFull = true;
+                ++_fullQueueCount;
+            }
+            std::this_thread::yield();
+            position = _enqueuePosition.load(std::memory_order_relaxed);
+        } else {
+            position = _enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    // pairs with the fence in _loop(), either the render thread sees the
+    // command before sleeping or this sees it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_isSleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _wakeUp.notify_one();
+    }
+}
+
+bool RenderThread::_hasNext() const {
+    const Slot& slot = _slots[_dequeuePosition & (_capacity - 1)];
+    return (int)(slot.sequence.load(std::memory_order_acquire) - (_dequeuePosition + 1)) >= 0;
+}
+
+bool RenderThread::_runNext() {
+    if (!_hasNext()) return false;
+
+    // free the slot before running, so posters are not held up by the command
+    Slot& slot = _slots[_dequeuePosition & (_capacity - 1)];
+    Command command = std::move(slot.command);
+    slot.command = nullptr;
+    slot.sequence.store(_dequeuePosition + _capacity, std::memory_order_release);
+    ++_dequeuePosition;
+
+    command();
+    return true;
+}
+
+void RenderThread::_loop() {
+    while (!_isStopping) {
+        if (_runNext()) continue;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (_frameCallback && now >= _nextFrame) {
+            _frameCallback(std::chrono::duration<float>(now - _framesStart).count());
+            _nextFrame += _frameInterval;
+            if (_nextFrame < now) {
+                // fell behind, skip the missed frames instead of catching up
+                _nextFrame = now + _frameInterval;
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _isSleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!_hasNext()) {
+            if (_frameCallback) {
+                _wakeUp.wait_until(lock, _nextFrame);
+            } else {
+                _wakeUp.wait(lock);
+            }
+        }
+        _isSleeping.store(false, std::memory_order_relaxed);
+    }
+
+    // nothing can be posted once stopping, but run what is left in any case
+    while (_runNext());
+    _frameCallback = nullptr;
+    _destroyContext();
+}
+
+bool RenderThread::_createContext(void* sharedContext) {
+#if RENDER_THREAD_USE_EGL
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    // eglTerminate is never called, the display is shared with the rest of the process
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, 0, 0)) {
+        Log("ERROR", "RenderThread: no EGL display");
+        return false;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount < 1) {
+        Log("ERROR", "RenderThread: no EGL config for a GLES2 pbuffer");
+        return false;
+    }
+
+    EGLContext context = EGL_NO_CONTEXT;
+    for (int version = 3; version >= 2 && context == EGL_NO_CONTEXT; --version) {
+        const EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, version, EGL_NONE };
+        context = eglCreateContext(display, config, sharedContext ? (EGLContext)sharedContext : EGL_NO_CONTEXT, contextAttributes);
+    }
+    if (context == EGL_NO_CONTEXT) {
+        Log("ERROR", "RenderThread: eglCreateContext failed 0x%04X", eglGetError());
+        return false;
+    }
+
+    const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+        Log("ERROR", "RenderThread: cannot make the context current 0x%04X", eglGetError());
+        if (surface != EGL_NO_SURFACE) {
+            eglDestroySurface(display, surface);
+        }
+        eglDestroyContext(display, context);
+        return false;
+    }
+
+    _eglDisplay = display;
+    _eglSurface = surface;
+    _eglContext = context;
+#endif
+    return true;
+}
+
+void RenderThread::_destroyContext() {
+#if RENDER_THREAD_USE_EGL
+    if (!_eglDisplay) return;
+    eglMakeCurrent(_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroySurface(_eglDisplay, _eglSurface);
+    eglDestroyContext(_eglDisplay, _eglContext);
+    eglReleaseThread();
+#endif
+    _eglDisplay = 0;
+    _eglSurface = 0;
+    _eglContext = 0;
+}
+
+NS_GI_END
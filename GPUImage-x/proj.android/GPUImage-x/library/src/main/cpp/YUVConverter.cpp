@@ -0,0 +1,753 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "YUVConverter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include "util.h"
+
+#if defined(__SSE2__)
+    #define YUV_CONVERTER_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define YUV_CONVERTER_AVX2 1
+    #include <immintrin.h>
+    #include <cpuid.h>
+    #define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define YUV_CONVERTER_NEON 1
+    #include <arm_neon.h>
+#endif
+
+NS_GI_BEGIN
+
+// Every kernel evaluates, in 16-bit lanes,
+//   luma = (Y - yOffset) * yCoeff + 32
+//   R = clamp((luma + rv * (V - 128)) >> 6)
+//   G = clamp((luma - gu * (U - 128) - gv * (V - 128)) >> 6)
+//   B = clamp((luma + bu * (U - 128)) >> 6)
+// Only the R and B sums can leave the int16 range, and only upwards past a
+// value that clamps to 255 anyway, so saturating adds keep the SIMD results
+// identical to the int arithmetic of the reference.
+struct Coefficients {
+    int yOffset;
+    int yCoeff;
+    int rv;
+    int gu;
+    int gv;
+    int bu;
+};
+
+static const Coefficients _coefficients[] = {
+    {  0, 64,  90, 22, 46, 113 },   // BT601FullRange
+    { 16, 74, 102, 25, 52, 129 },   // BT601VideoRange
+    {  0, 64, 101, 12, 30, 119 },   // BT709FullRange
+    { 16, 74, 115, 14, 34, 135 },   // BT709VideoRange
+};
+
+// pointers to the first pixel of one output row and the samples it reads
+struct Row {
+    const unsigned char* y;
+    const unsigned char* u;
+    const unsigned char* v;
+    unsigned char* dst;
+};
+
+// plane layout of a tightly packed frame
+struct Frame {
+    YUVConverter::SourceFormat format;
+    const unsigned char* y;
+    const unsigned char* u;
+    const unsigned char* v;
+    int yStride;
+    int chromaStride;
+    unsigned char* dst;
+    int dstStride;
+
+    Frame(const unsigned char* src, int width, int height, YUVConverter::SourceFormat srcFormat, unsigned char* dstData, int dstRowStride)
+    : format(srcFormat)
+    , y(src)
+    , dst(dstData)
+    , dstStride(dstRowStride)
+    {
+        int chromaWidth = (width + 1) / 2;
+        int chromaHeight = (height + 1) / 2;
+        const unsigned char* chroma = src + width * height;
+        switch (format) {
+            case YUVConverter::NV21:
+                yStride = width;
+                chromaStride = chromaWidth * 2;
+                v = chroma;
+                u = chroma + 1;
+                break;
+            case YUVConverter::NV12:
+                yStride = width;
+                chromaStride = chromaWidth * 2;
+                u = chroma;
+                v = chroma + 1;
+                break;
+            case YUVConverter::I420:
+                yStride = width;
+                chromaStride = chromaWidth;
+                u = chroma;
+                v = chroma + chromaWidth * chromaHeight;
+                break;
+            case YUVConverter::YUY2:
+                yStride = chromaStride = chromaWidth * 4;
+                u = src + 1;
+                v = src + 3;
+                break;
+        }
+    }
+
+    Row row(int j) const {
+        Row r;
+        int chromaRow = (format == YUVConverter::YUY2 ? j : j / 2);
+        r.y = y + j * yStride;
+        r.u = u + chromaRow * chromaStride;
+        r.v = v + chromaRow * chromaStride;
+        r.dst = dst + j * dstStride;
+        return r;
+    }
+};
+
+static size_t _frameSize(int width, int height, YUVConverter::SourceFormat format) {
+    size_t chromaWidth = (width + 1) / 2;
+    size_t chromaHeight = (height + 1) / 2;
+    switch (format) {
+        case YUVConverter::NV21:
+        case YUVConverter::NV12:
+            return (size_t)width * height + chromaWidth * 2 * chromaHeight;
+        case YUVConverter::I420:
+            return (size_t)width * height + chromaWidth * chromaHeight * 2;
+        case YUVConverter::YUY2:
+            return chromaWidth * 4 * height;
+    }
+    return 0;
+}
+
+static inline unsigned char _clampPixel(int value) {
+    value >>= 6;
+    return value < 0 ? 0 : (value > 255 ? 255 : (unsigned char)value);
+}
+
+// scalar conversion of the pixels [x, width) of a row
+static void _convertRowReference(YUVConverter::SourceFormat format, const Row& row, int x, int width, const Coefficients& c, bool bgra) {
+    int yStep = (format == YUVConverter::YUY2 ? 2 : 1);
+    int chromaStep = (format == YUVConverter::I420 ? 1 : (format == YUVConverter::YUY2 ? 4 : 2));
+    int rIndex = bgra ? 2 : 0;
+    int bIndex = bgra ? 0 : 2;
+    for (; x < width; ++x) {
+        int luma = (row.y[x * yStep] - c.yOffset) * c.yCoeff + 32;
+        int u = row.u[(x >> 1) * chromaStep] - 128;
+        int v = row.v[(x >> 1) * chromaStep] - 128;
+        unsigned char* pixel = row.dst + x * 4;
+        pixel[rIndex] = _clampPixel(luma + c.rv * v);
+        pixel[1] = _clampPixel(luma - c.gu * u - c.gv * v);
+        pixel[bIndex] = _clampPixel(luma + c.bu * u);
+        pixel[3] = 255;
+    }
+}
+
+#if YUV_CONVERTER_SSE2
+
+struct SSE2Coefficients {
+    __m128i yOffset, yCoeff, rv, gu, gv, bu, round, chromaBias, alpha;
+
+    SSE2Coefficients(const Coefficients& c)
+    : yOffset(_mm_set1_epi16(c.yOffset))
+    , yCoeff(_mm_set1_epi16(c.yCoeff))
+    , rv(_mm_set1_epi16(c.rv))
+    , gu(_mm_set1_epi16(c.gu))
+    , gv(_mm_set1_epi16(c.gv))
+    , bu(_mm_set1_epi16(c.bu))
+    , round(_mm_set1_epi16(32))
+    , chromaBias(_mm_set1_epi16(128))
+    , alpha(_mm_set1_epi8((char)0xff))
+    {}
+};
+
+static inline void _convertHalfSSE2(__m128i y, __m128i u, __m128i v, const SSE2Coefficients& k, __m128i& r, __m128i& g, __m128i& b) {
+    __m128i luma = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, k.yOffset), k.yCoeff), k.round);
+    r = _mm_srai_epi16(_mm_adds_epi16(luma, _mm_mullo_epi16(v, k.rv)), 6);
+    g = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(luma, _mm_mullo_epi16(u, k.gu)), _mm_mullo_epi16(v, k.gv)), 6);
+    b = _mm_srai_epi16(_mm_adds_epi16(luma, _mm_mullo_epi16(u, k.bu)), 6);
+}
+
+// 16 pixels: yLo/yHi hold 8 luma samples each, u/v the 8 chroma samples shared by pixel pairs
+static inline void _storePixelsSSE2(__m128i yLo, __m128i yHi, __m128i u, __m128i v, const SSE2Coefficients& k, unsigned char* dst, bool bgra) {
+    u = _mm_sub_epi16(u, k.chromaBias);
+    v = _mm_sub_epi16(v, k.chromaBias);
+    __m128i r0, g0, b0, r1, g1, b1;
+    _convertHalfSSE2(yLo, _mm_unpacklo_epi16(u, u), _mm_unpacklo_epi16(v, v), k, r0, g0, b0);
+    _convertHalfSSE2(yHi, _mm_unpackhi_epi16(u, u), _mm_unpackhi_epi16(v, v), k, r1, g1, b1);
+
+    __m128i r = _mm_packus_epi16(r0, r1);
+    __m128i g = _mm_packus_epi16(g0, g1);
+    __m128i b = _mm_packus_epi16(b0, b1);
+    if (bgra) {
+        __m128i t = r; r = b; b = t;
+    }
+    __m128i rg0 = _mm_unpacklo_epi8(r, g);
+    __m128i rg1 = _mm_unpackhi_epi8(r, g);
+    __m128i ba0 = _mm_unpacklo_epi8(b, k.alpha);
+    __m128i ba1 = _mm_unpackhi_epi8(b, k.alpha);
+    _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(rg0, ba0));
+    _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi16(rg0, ba0));
+    _mm_storeu_si128((__m128i*)(dst + 32), _mm_unpacklo_epi16(rg1, ba1));
+    _mm_storeu_si128((__m128i*)(dst + 48), _mm_unpackhi_epi16(rg1, ba1));
+}
+
+// return the number of pixels converted, the caller finishes the row
+static int _convertRowSSE2(YUVConverter::SourceFormat format, const Row& row, int width, const Coefficients& c, bool bgra) {
+    const SSE2Coefficients k(c);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowBytes = _mm_set1_epi16(0xff);
+    int x = 0;
+    switch (format) {
+        case YUVConverter::NV21:
+        case YUVConverter::NV12: {
+            bool uFirst = (format == YUVConverter::NV12);
+            const unsigned char* chroma = uFirst ? row.u : row.v;
+            for (; x + 16 <= width; x += 16) {
+                __m128i y = _mm_loadu_si128((const __m128i*)(row.y + x));
+                __m128i pairs = _mm_loadu_si128((const __m128i*)(chroma + x));
+                __m128i first = _mm_and_si128(pairs, lowBytes);
+                __m128i second = _mm_srli_epi16(pairs, 8);
+                _storePixelsSSE2(_mm_unpacklo_epi8(y, zero), _mm_unpackhi_epi8(y, zero),
+                                 uFirst ? first : second, uFirst ? second : first,
+                                 k, row.dst + x * 4, bgra);
+            }
+            break;
+        }
+        case YUVConverter::I420:
+            for (; x + 16 <= width; x += 16) {
+                __m128i y = _mm_loadu_si128((const __m128i*)(row.y + x));
+                __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row.u + x / 2)), zero);
+                __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row.v + x / 2)), zero);
+                _storePixelsSSE2(_mm_unpacklo_epi8(y, zero), _mm_unpackhi_epi8(y, zero), u, v, k, row.dst + x * 4, bgra);
+            }
+            break;
+        case YUVConverter::YUY2: {
+            const __m128i lowWords = _mm_set1_epi32(0xffff);
+            for (; x + 16 <= width; x += 16) {
+                __m128i a = _mm_loadu_si128((const __m128i*)(row.y + x * 2));
+                __m128i b = _mm_loadu_si128((const __m128i*)(row.y + x * 2 + 16));
+                __m128i chromaA = _mm_srli_epi16(a, 8);
+                __m128i chromaB = _mm_srli_epi16(b, 8);
+                __m128i u = _mm_packs_epi32(_mm_and_si128(chromaA, lowWords), _mm_and_si128(chromaB, lowWords));
+                __m128i v = _mm_packs_epi32(_mm_srli_epi32(chromaA, 16), _mm_srli_epi32(chromaB, 16));
+                _storePixelsSSE2(_mm_and_si128(a, lowBytes), _mm_and_si128(b, lowBytes), u, v, k, row.dst + x * 4, bgra);
+            }
+            break;
+        }
+    }
+    return x;
+}
+
+#endif // YUV_CONVERTER_SSE2
+
+#if YUV_CONVERTER_AVX2
+
+static bool _cpuSupportsAVX2() {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, 0) < 7 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    // the OS must save the ymm registers on context switches
+    if (!(ecx & (1 << 27)) || !(ecx & (1 << 28)))
+        return false;
+    unsigned int xcr0Low, xcr0High;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    if ((xcr0Low & 6) != 6)
+        return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & (1 << 5)) != 0;
+}
+
+struct AVX2Coefficients {
+    __m256i yOffset, yCoeff, rv, gu, gv, bu, round, chromaBias, alpha;
+
+    AVX2_FUNCTION AVX2Coefficients(const Coefficients& c)
+    : yOffset(_mm256_set1_epi16(c.yOffset))
+    , yCoeff(_mm256_set1_epi16(c.yCoeff))
+    , rv(_mm256_set1_epi16(c.rv))
+    , gu(_mm256_set1_epi16(c.gu))
+    , gv(_mm256_set1_epi16(c.gv))
+    , bu(_mm256_set1_epi16(c.bu))
+    , round(_mm256_set1_epi16(32))
+    , chromaBias(_mm256_set1_epi16(128))
+    , alpha(_mm256_set1_epi8((char)0xff))
+    {}
+};
+
+AVX2_FUNCTION static inline void _convertHalfAVX2(__m256i y, __m256i u, __m256i v, const AVX2Coefficients& k, __m256i& r, __m256i& g, __m256i& b) {
+    __m256i luma = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(y, k.yOffset), k.yCoeff), k.round);
+    r = _mm256_srai_epi16(_mm256_adds_epi16(luma, _mm256_mullo_epi16(v, k.rv)), 6);
+    g = _mm256_srai_epi16(_mm256_sub_epi16(_mm256_sub_epi16(luma, _mm256_mullo_epi16(u, k.gu)), _mm256_mullo_epi16(v, k.gv)), 6);
+    b = _mm256_srai_epi16(_mm256_adds_epi16(luma, _mm256_mullo_epi16(u, k.bu)), 6);
+}
+
+// 32 pixels, all inputs are 16 samples in pixel order. The AVX2 unpack and
+// pack instructions work within 128-bit lanes, hence the permutes.
+AVX2_FUNCTION static inline void _storePixelsAVX2(__m256i yLo, __m256i yHi, __m256i u, __m256i v, const AVX2Coefficients& k, unsigned char* dst, bool bgra) {
+    u = _mm256_permute4x64_epi64(_mm256_sub_epi16(u, k.chromaBias), 0xD8);
+    v = _mm256_permute4x64_epi64(_mm256_sub_epi16(v, k.chromaBias), 0xD8);
+    __m256i r0, g0, b0, r1, g1, b1;
+    _convertHalfAVX2(yLo, _mm256_unpacklo_epi16(u, u), _mm256_unpacklo_epi16(v, v), k, r0, g0, b0);
+    _convertHalfAVX2(yHi, _mm256_unpackhi_epi16(u, u), _mm256_unpackhi_epi16(v, v), k, r1, g1, b1);
+
+    __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(r0, r1), 0xD8);
+    __m256i g = _mm256_permute4x64_epi64(_mm256_packus_epi16(g0, g1), 0xD8);
+    __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(b0, b1), 0xD8);
+    if (bgra) {
+        __m256i t = r; r = b; b = t;
+    }
+    __m256i rg0 = _mm256_unpacklo_epi8(r, g);
+    __m256i rg1 = _mm256_unpackhi_epi8(r, g);
+    __m256i ba0 = _mm256_unpacklo_epi8(b, k.alpha);
+    __m256i ba1 = _mm256_unpackhi_epi8(b, k.alpha);
+    __m256i p0 = _mm256_unpacklo_epi16(rg0, ba0);
+    __m256i p1 = _mm256_unpackhi_epi16(rg0, ba0);
+    __m256i p2 = _mm256_unpacklo_epi16(rg1, ba1);
+    __m256i p3 = _mm256_unpackhi_epi16(rg1, ba1);
+    _mm256_storeu_si256((__m256i*)dst, _mm256_permute2x128_si256(p0, p1, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 32), _mm256_permute2x128_si256(p2, p3, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 64), _mm256_permute2x128_si256(p0, p1, 0x31));
+    _mm256_storeu_si256((__m256i*)(dst + 96), _mm256_permute2x128_si256(p2, p3, 0x31));
+}
+
+AVX2_FUNCTION static int _convertRowAVX2(YUVConverter::SourceFormat format, const Row& row, int width, const Coefficients& c, bool bgra) {
+    const AVX2Coefficients k(c);
+    const __m256i lowBytes = _mm256_set1_epi16(0xff);
+    int x = 0;
+    switch (format) {
+        case YUVConverter::NV21:
+        case YUVConverter::NV12: {
+            bool uFirst = (format == YUVConverter::NV12);
+            const unsigned char* chroma = uFirst ? row.u : row.v;
+            for (; x + 32 <= width; x += 32) {
+                __m256i yLo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row.y + x)));
+                __m256i yHi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row.y + x + 16)));
+                __m256i pairs = _mm256_loadu_si256((const __m256i*)(chroma + x));
+                __m256i first = _mm256_and_si256(pairs, lowBytes);
+                __m256i second = _mm256_srli_epi16(pairs, 8);
+                _storePixelsAVX2(yLo, yHi, uFirst ? first : second, uFirst ? second : first, k, row.dst + x * 4, bgra);
+            }
+            break;
+        }
+        case YUVConverter::I420:
+            for (; x + 32 <= width; x += 32) {
+                __m256i yLo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row.y + x)));
+                __m256i yHi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row.y + x + 16)));
+                __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row.u + x / 2)));
+                __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row.v + x / 2)));
+                _storePixelsAVX2(yLo, yHi, u, v, k, row.dst + x * 4, bgra);
+            }
+            break;
+        case YUVConverter::YUY2: {
+            const __m256i lowWords = _mm256_set1_epi32(0xffff);
+            for (; x + 32 <= width; x += 32) {
+                __m256i a = _mm256_loadu_si256((const __m256i*)(row.y + x * 2));
+                __m256i b = _mm256_loadu_si256((const __m256i*)(row.y + x * 2 + 32));
+                __m256i chromaA = _mm256_srli_epi16(a, 8);
+                __m256i chromaB = _mm256_srli_epi16(b, 8);
+                __m256i u = _mm256_packs_epi32(_mm256_and_si256(chromaA, lowWords), _mm256_and_si256(chromaB, lowWords));
+                __m256i v = _mm256_packs_epi32(_mm256_srli_epi32(chromaA, 16), _mm256_srli_epi32(chromaB, 16));
+                _storePixelsAVX2(_mm256_and_si256(a, lowBytes), _mm256_and_si256(b, lowBytes),
+                                 _mm256_permute4x64_epi64(u, 0xD8), _mm256_permute4x64_epi64(v, 0xD8),
+                                 k, row.dst + x * 4, bgra);
+            }
+            break;
+        }
+    }
+    return x;
+}
+
+#endif // YUV_CONVERTER_AVX2
+
+#if YUV_CONVERTER_NEON
+
+struct NEONCoefficients {
+    int16x8_t yOffset, yCoeff, rv, gu, gv, bu, round, chromaBias;
+
+    NEONCoefficients(const Coefficients& c)
+    : yOffset(vdupq_n_s16(c.yOffset))
+    , yCoeff(vdupq_n_s16(c.yCoeff))
+    , rv(vdupq_n_s16(c.rv))
+    , gu(vdupq_n_s16(c.gu))
+    , gv(vdupq_n_s16(c.gv))
+    , bu(vdupq_n_s16(c.bu))
+    , round(vdupq_n_s16(32))
+    , chromaBias(vdupq_n_s16(128))
+    {}
+};
+
+static inline int16x8_t _widenNEON(uint8x8_t value) {
+    return vreinterpretq_s16_u16(vmovl_u8(value));
+}
+
+static inline void _convertHalfNEON(int16x8_t y, int16x8_t u, int16x8_t v, const NEONCoefficients& k, uint8x8_t& r, uint8x8_t& g, uint8x8_t& b) {
+    int16x8_t luma = vaddq_s16(vmulq_s16(vsubq_s16(y, k.yOffset), k.yCoeff), k.round);
+    // vqshrun clamps (x >> 6) to [0, 255] while narrowing
+    r = vqshrun_n_s16(vqaddq_s16(luma, vmulq_s16(v, k.rv)), 6);
+    g = vqshrun_n_s16(vsubq_s16(vsubq_s16(luma, vmulq_s16(u, k.gu)), vmulq_s16(v, k.gv)), 6);
+    b = vqshrun_n_s16(vqaddq_s16(luma, vmulq_s16(u, k.bu)), 6);
+}
+
+// 16 pixels: yLo/yHi hold 8 luma samples each, u/v the 8 chroma samples shared by pixel pairs
+static inline void _storePixelsNEON(int16x8_t yLo, int16x8_t yHi, int16x8_t u, int16x8_t v, const NEONCoefficients& k, unsigned char* dst, bool bgra) {
+    int16x8x2_t uu = vzipq_s16(vsubq_s16(u, k.chromaBias), vsubq_s16(u, k.chromaBias));
+    int16x8x2_t vv = vzipq_s16(vsubq_s16(v, k.chromaBias), vsubq_s16(v, k.chromaBias));
+    uint8x8_t r0, g0, b0, r1, g1, b1;
+    _convertHalfNEON(yLo, uu.val[0], vv.val[0], k, r0, g0, b0);
+    _convertHalfNEON(yHi, uu.val[1], vv.val[1], k, r1, g1, b1);
+
+    uint8x16x4_t pixels;
+    pixels.val[bgra ? 2 : 0] = vcombine_u8(r0, r1);
+    pixels.val[1] = vcombine_u8(g0, g1);
+    pixels.val[bgra ? 0 : 2] = vcombine_u8(b0, b1);
+    pixels.val[3] = vdupq_n_u8(0xff);
+    vst4q_u8(dst, pixels);
+}
+
+static int _convertRowNEON(YUVConverter::SourceFormat format, const Row& row, int width, const Coefficients& c, bool bgra) {
+    const NEONCoefficients k(c);
+    int x = 0;
+    switch (format) {
+        case YUVConverter::NV21:
+        case YUVConverter::NV12: {
+            bool uFirst = (format == YUVConverter::NV12);
+            const unsigned char* chroma = uFirst ? row.u : row.v;
+            for (; x + 16 <= width; x += 16) {
+                uint8x16_t y = vld1q_u8(row.y + x);
+                uint8x8x2_t pairs = vld2_u8(chroma + x);
+                _storePixelsNEON(_widenNEON(vget_low_u8(y)), _widenNEON(vget_high_u8(y)),
+                                 _widenNEON(pairs.val[uFirst ? 0 : 1]), _widenNEON(pairs.val[uFirst ? 1 : 0]),
+                                 k, row.dst + x * 4, bgra);
+            }
+            break;
+        }
+        case YUVConverter::I420:
+            for (; x + 16 <= width; x += 16) {
+                uint8x16_t y = vld1q_u8(row.y + x);
+                _storePixelsNEON(_widenNEON(vget_low_u8(y)), _widenNEON(vget_high_u8(y)),
+                                 _widenNEON(vld1_u8(row.u + x / 2)), _widenNEON(vld1_u8(row.v + x / 2)),
+                                 k, row.dst + x * 4, bgra);
+            }
+            break;
+        case YUVConverter::YUY2:
+            for (; x + 16 <= width; x += 16) {
+                // val[0] even luma, val[1] U, val[2] odd luma, val[3] V
+                uint8x8x4_t packed = vld4_u8(row.y + x * 2);
+                uint8x8x2_t y = vzip_u8(packed.val[0], packed.val[2]);
+                _storePixelsNEON(_widenNEON(y.val[0]), _widenNEON(y.val[1]),
+                                 _widenNEON(packed.val[1]), _widenNEON(packed.val[3]),
+                                 k, row.dst + x * 4, bgra);
+            }
+            break;
+    }
+    return x;
+}
+
+#endif // YUV_CONVERTER_NEON
+
+static void _convertRows(const Frame& frame, int rowBegin, int rowEnd, int width, const Coefficients& c, bool bgra, YUVConverter::Implementation implementation) {
+    for (int j = rowBegin; j < rowEnd; ++j) {
+        Row row = frame.row(j);
+        int x = 0;
+        switch (implementation) {
+#if YUV_CONVERTER_SSE2
+            case YUVConverter::SSE2:
+                x = _convertRowSSE2(frame.format, row, width, c, bgra);
+                break;
+#endif
+#if YUV_CONVERTER_AVX2
+            case YUVConverter::AVX2:
+                x = _convertRowAVX2(frame.format, row, width, c, bgra);
+                break;
+#endif
+#if YUV_CONVERTER_NEON
+            case YUVConverter::NEON:
+                x = _convertRowNEON(frame.format, row, width, c, bgra);
+                break;
+#endif
+            default:
+                break;
+        }
+        _convertRowReference(frame.format, row, x, width, c, bgra);
+    }
+}
+
+// A fixed set of worker threads. run() hands out task indices to the workers
+// and the calling thread, and returns once every task has finished.
+class WorkerPool {
+public:
+    WorkerPool(int workerCount)
+    : _task(0)
+    , _nextTask(0)
+    , _taskCount(0)
+    , _busyWorkers(0)
+    , _generation(0)
+    , _quit(false)
+    {
+        for (int i = 0; i < workerCount; ++i) {
+            _workers.push_back(std::thread(&WorkerPool::_workerLoop, this));
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _quit = true;
+        }
+        _wakeCondition.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    void run(int taskCount, const std::function<void(int)>& task) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = &task;
+            _taskCount = taskCount;
+            _nextTask = 0;
+            _busyWorkers = (int)_workers.size();
+            ++_generation;
+        }
+        _wakeCondition.notify_all();
+        _runTasks();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _doneCondition.wait(lock, [this] { return _busyWorkers == 0; });
+        _task = 0;
+    }
+
+private:
+    void _workerLoop() {
+        unsigned int seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wakeCondition.wait(lock, [&] { return _quit || _generation != seenGeneration; });
+                if (_quit)
+                    return;
+                seenGeneration = _generation;
+            }
+            _runTasks();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (--_busyWorkers == 0)
+                    _doneCondition.notify_one();
+            }
+        }
+    }
+
+    void _runTasks() {
+        for (int i = _nextTask++; i < _taskCount; i = _nextTask++) {
+            (*_task)(i);
+        }
+    }
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wakeCondition;
+    std::condition_variable _doneCondition;
+    const std::function<void(int)>* _task;
+    std::atomic<int> _nextTask;
+    int _taskCount;
+    int _busyWorkers;
+    unsigned int _generation;
+    bool _quit;
+};
+
+// below this many pixels per task the hand-off costs more than it saves
+static const int kMinPixelsPerTask = 64 * 1024;
+
+static std::mutex _poolMutex;
+static WorkerPool* _pool = 0;
+// set under _poolMutex, read by convert() before it tries to take the pool
+static std::atomic<int> _threadCount(0);
+
+static int _resolvedThreadCount() {
+    int threadCount = _threadCount;
+    if (threadCount > 0)
+        return threadCount;
+    int cores = (int)std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+static bool _checkArguments(const unsigned char* src, int width, int height, unsigned char* dst, int dstStride) {
+    if (!src || !dst || width <= 0 || height <= 0) {
+        Log("WARNING", "YUVConverter: invalid frame %dx%d", width, height);
+        return false;
+    }
+    if (dstStride < width * 4) {
+        Log("WARNING", "YUVConverter: destination stride %d is smaller than a row of %d pixels", dstStride, width);
+        return false;
+    }
+    return true;
+}
+
+bool YUVConverter::convert(const unsigned char* src, int width, int height, SourceFormat srcFormat,
+                           unsigned char* dst, OutputFormat dstFormat,
+                           ColorSpace colorSpace/* = BT601FullRange*/, int dstStride/* = 0*/) {
+    if (dstStride == 0) dstStride = width * 4;
+    if (!_checkArguments(src, width, height, dst, dstStride))
+        return false;
+
+    const Frame frame(src, width, height, srcFormat, dst, dstStride);
+    const Coefficients& c = _coefficients[colorSpace];
+    const bool bgra = (dstFormat == BGRA);
+    const Implementation implementation = getImplementation();
+
+    // split into bands of an even number of rows so each chroma row is read by one task only
+    int taskCount = std::min(_resolvedThreadCount(), std::max(1, width * height / kMinPixelsPerTask));
+    int rowsPerTask = ((height + taskCount - 1) / taskCount + 1) & ~1;
+    taskCount = (height + rowsPerTask - 1) / rowsPerTask;
+
+    // a concurrent caller converts on its own thread instead of waiting for the pool
+    std::unique_lock<std::mutex> lock(_poolMutex, std::try_to_lock);
+    if (taskCount <= 1 || !lock.owns_lock()) {
+        _convertRows(frame, 0, height, width, c, bgra, implementation);
+        return true;
+    }
+
+    if (!_pool) {
+        _pool = new (std::nothrow) WorkerPool(_resolvedThreadCount() - 1);
+        if (!_pool) {
+            _convertRows(frame, 0, height, width, c, bgra, implementation);
+            return true;
+        }
+    }
+    _pool->run(taskCount, [&](int task) {
+        int rowBegin = task * rowsPerTask;
+        _convertRows(frame, rowBegin, std::min(rowBegin + rowsPerTask, height), width, c, bgra, implementation);
+    });
+    return true;
+}
+
+bool YUVConverter::convertReference(const unsigned char* src, int width, int height, SourceFormat srcFormat,
+                                    unsigned char* dst, OutputFormat dstFormat,
+                                    ColorSpace colorSpace/* = BT601FullRange*/, int dstStride/* = 0*/) {
+    if (dstStride == 0) dstStride = width * 4;
+    if (!_checkArguments(src, width, height, dst, dstStride))
+        return false;
+
+    const Frame frame(src, width, height, srcFormat, dst, dstStride);
+    _convertRows(frame, 0, height, width, _coefficients[colorSpace], dstFormat == BGRA, Reference);
+    return true;
+}
+
+YUVConverter::Implementation YUVConverter::getImplementation() {
+#if YUV_CONVERTER_NEON
+    return NEON;
+#else
+#if YUV_CONVERTER_AVX2
+    static const bool hasAVX2 = _cpuSupportsAVX2();
+    if (hasAVX2)
+        return AVX2;
+#endif
+#if YUV_CONVERTER_SSE2
+    return SSE2;
+#endif
+    return Reference;
+#endif
+}
+
+const char* YUVConverter::getImplementationName(Implementation implementation) {
+    switch (implementation) {
+        case SSE2: return "SSE2";
+        case AVX2: return "AVX2";
+        case NEON: return "NEON";
+        default: return "reference";
+    }
+}
+
+void YUVConverter::setThreadCount(int threadCount) {
+    std::lock_guard<std::mutex> lock(_poolMutex);
+    _threadCount = threadCount > 0 ? threadCount : 0;
+    delete _pool;
+    _pool = 0;
+}
+
+int YUVConverter::getThreadCount() {
+    std::lock_guard<std::mutex> lock(_poolMutex);
+    return _resolvedThreadCount();
+}
+
+float YUVConverter::benchmark(int width, int height, SourceFormat srcFormat,
+                              OutputFormat dstFormat/* = RGBA*/, int iterations/* = 100*/) {
+    static const char* formatNames[] = { "NV21", "NV12", "I420", "YUY2" };
+    if (width <= 0 || height <= 0 || iterations <= 0) {
+        Log("WARNING", "YUVConverter: invalid benchmark %dx%d x%d", width, height, iterations);
+        return -1;
+    }
+
+    // a fixed pseudo-random frame reaches the clamping paths of every kernel
+    std::vector<unsigned char> src(_frameSize(width, height, srcFormat));
+    unsigned int seed = 1;
+    for (auto& sample : src) {
+        seed = seed * 1103515245 + 12345;
+        sample = (unsigned char)(seed >> 16);
+    }
+    std::vector<unsigned char> expected(width * height * 4);
+    std::vector<unsigned char> result(width * height * 4);
+
+    for (int colorSpace = BT601FullRange; colorSpace <= BT709VideoRange; ++colorSpace) {
+        convertReference(&src[0], width, height, srcFormat, &expected[0], dstFormat, (ColorSpace)colorSpace);
+        convert(&src[0], width, height, srcFormat, &result[0], dstFormat, (ColorSpace)colorSpace);
+        if (memcmp(&expected[0], &result[0], expected.size()) != 0) {
+            size_t i = 0;
+            while (expected[i] == result[i]) ++i;
+            Log("ERROR", "YUVConverter: %s output differs from the reference at pixel %d, color space %d",
+                getImplementationName(getImplementation()), (int)(i / 4), colorSpace);
+            return -1;
+        }
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    convertReference(&src[0], width, height, srcFormat, &expected[0], dstFormat);
+    float referenceMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        convert(&src[0], width, height, srcFormat, &result[0], dstFormat);
+    }
+    float ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count() / iterations;
+
+    Log("INFO", "YUVConverter: %s %dx%d with %s on %d threads: %.3f ms/frame, reference %.3f ms/frame",
+        formatNames[srcFormat], width, height, getImplementationName(getImplementation()),
+        getThreadCount(), ms, referenceMs);
+    return ms;
+}
+
+NS_GI_END
@@ -0,0 +1,87 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef YUVConverter_hpp
+#define YUVConverter_hpp
+
+#include "macros.h"
+
+NS_GI_BEGIN
+
+// YUVConverter converts camera frames to 32-bit RGB on the CPU, for the paths
+// that cannot hand the frame to SourceCamera::setYUVFrameData.
+//
+// All implementations share one 6-bit fixed-point formula, so the SSE2, AVX2
+// and NEON kernels produce exactly the bytes of the scalar reference. Rows are
+// split across a small pool of worker threads.
+class YUVConverter {
+public:
+    enum SourceFormat {
+        NV21 = 0,   // Y plane, then interleaved V/U at half resolution
+        NV12,       // Y plane, then interleaved U/V at half resolution
+        I420,       // Y plane, U plane and V plane, chroma at half resolution
+        YUY2        // packed Y0 U Y1 V, chroma at half horizontal resolution
+    };
+
+    enum OutputFormat {
+        RGBA = 0,
+        BGRA        // also the memory layout of a little-endian ARGB int
+    };
+
+    enum ColorSpace {
+        BT601FullRange = 0,
+        BT601VideoRange,
+        BT709FullRange,
+        BT709VideoRange
+    };
+
+    enum Implementation {
+        Reference = 0,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    // Convert a tightly packed frame. dstStride is in bytes, 0 means width * 4.
+    static bool convert(const unsigned char* src, int width, int height, SourceFormat srcFormat,
+                        unsigned char* dst, OutputFormat dstFormat,
+                        ColorSpace colorSpace = BT601FullRange, int dstStride = 0);
+
+    // Single-threaded scalar version of convert, the output convert must match
+    static bool convertReference(const unsigned char* src, int width, int height, SourceFormat srcFormat,
+                                 unsigned char* dst, OutputFormat dstFormat,
+                                 ColorSpace colorSpace = BT601FullRange, int dstStride = 0);
+
+    // the fastest kernel supported by the running CPU
+    static Implementation getImplementation();
+    static const char* getImplementationName(Implementation implementation);
+
+    // 0 means one thread per CPU core, 1 converts on the calling thread only
+    static void setThreadCount(int threadCount);
+    static int getThreadCount();
+
+    // Convert a synthetic frame `iterations` times, check the result against
+    // convertReference and log the timings. Return the average milliseconds
+    // per frame, or -1 if the output differs from the reference.
+    static float benchmark(int width, int height, SourceFormat srcFormat,
+                           OutputFormat dstFormat = RGBA, int iterations = 100);
+};
+
+NS_GI_END
+
+#endif /* YUVConverter_hpp */
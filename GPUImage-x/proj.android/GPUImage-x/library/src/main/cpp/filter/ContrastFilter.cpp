@@ -60,6 +60,7 @@ void ContrastFilter::setContrast(float contrast) {
     _contrast = contrast;
     if (_contrast > 4.0) _contrast = 4.0;
     else if (_contrast < 0.0) _contrast = 0.0;
+    _notifyGraphChanged();
 }
 
 bool ContrastFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -67,3 +68,8 @@ bool ContrastFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool ContrastFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_contrast});
+    return true;
+}
@@ -79,4 +79,10 @@ bool Convolution3x3Filter::proceed(bool bUpdateTargets/* = true*/) {
     return NearbySampling3x3Filter::proceed(bUpdateTargets);
 }
 
+bool Convolution3x3Filter::getMergeKey(std::string& key) const {
+    if (!NearbySampling3x3Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, _convolutionKernel.m, 9);
+    return true;
+}
+
 NS_GI_END
@@ -53,6 +53,7 @@ void EmbossFilter::setIntensity(float intensity) {
                            -_intensity, 1.0, _intensity,
                            0.0, _intensity, _intensity * 2.0
                            );
+    _notifyGraphChanged();
 }
 
 
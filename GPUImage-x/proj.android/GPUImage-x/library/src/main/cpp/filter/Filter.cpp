@@ -47,8 +47,10 @@ Filter* Filter::create(const std::string& filterClassName) {
         return 0;
     else {
         Filter* filter = it->second();
-        filter->setFilterClassName(filterClassName);
-        return it->second();
+        if (filter) {
+            filter->setFilterClassName(filterClassName);
+        }
+        return filter;
     }
 }
 
@@ -249,12 +251,29 @@ void Filter::update(float frameTime) {
         int captureHeight = Context::getInstance()->captureHeight;
 
         _framebuffer = Context::getInstance()->getFramebufferCache()->fetchFramebuffer(captureWidth, captureHeight);
+        _framebuffer->setTimestamp(getInputTimestamp());
+        Context::getInstance()->captureTimestamp = getInputTimestamp();
         proceed(false);
 
-        _framebuffer->active();
-        Context::getInstance()->capturedFrameData = new unsigned char[captureWidth * captureHeight * 4];
-        CHECK_GL(glReadPixels(0, 0, captureWidth, captureHeight, GL_RGBA, GL_UNSIGNED_BYTE, Context::getInstance()->capturedFrameData));
-        _framebuffer->inactive();
+        if (Context::getInstance()->captureCallback) {
+            Context::getInstance()->getReadbackQueue()->read(_framebuffer, Context::getInstance()->captureCallback);
+        } else {
+            unsigned char* pixels = Context::getInstance()->captureDestination;
+            if (!pixels) {
+                pixels = new unsigned char[captureWidth * captureHeight * 4];
+            }
+            Context::getInstance()->getReadbackQueue()->readInto(_framebuffer, pixels, Context::getInstance()->captureStride);
+            Context::getInstance()->capturedFrameData = pixels;
+        }
+    } else if (_mergeGroup && _mergeGroup->framebuffer && _mergeGroup->passSerial == Context::getInstance()->getPassSerial()) {
+        // an identical filter has drawn this pass already
+        _framebuffer = _mergeGroup->framebuffer;
+        _framebuffer->retain();
+        if (--_mergeGroup->pendingUses <= 0) {
+            _mergeGroup->framebuffer->release();
+            _mergeGroup->framebuffer = 0;
+        }
+        Source::proceed();
     } else {
         // todo
         Framebuffer* firstInputFramebuffer = _inputFramebuffers.begin()->second.frameBuffer;
@@ -275,6 +294,18 @@ void Filter::update(float frameTime) {
         }
 
         _framebuffer = Context::getInstance()->getFramebufferCache()->fetchFramebuffer(rotatedFramebufferWidth, rotatedFramebufferHeight);
+        // the output is the same frame as the inputs, a later stage sees when it was taken
+        _framebuffer->setTimestamp(getInputTimestamp());
+        if (_mergeGroup && _mergeGroup->memberCount > 1) {
+            // kept for the other members until each has used it
+            if (_mergeGroup->framebuffer) {
+                _mergeGroup->framebuffer->release();
+            }
+            _mergeGroup->framebuffer = _framebuffer;
+            _mergeGroup->framebuffer->retain();
+            _mergeGroup->passSerial = Context::getInstance()->getPassSerial();
+            _mergeGroup->pendingUses = _mergeGroup->memberCount - 1;
+        }
         proceed();
     }
 
@@ -282,6 +313,35 @@ void Filter::update(float frameTime) {
     _framebuffer = 0;
 }
 
+bool Filter::getMergeKey(std::string& key) const {
+    if (_filterClassName.empty()) return false;
+
+    key = str_format("%s|%d|%.9g|%d|%.9g,%.9g,%.9g,%.9g", _filterClassName.c_str(), _inputNum, _framebufferScale, _outputRotation,
+                     _backgroundColor.r, _backgroundColor.g, _backgroundColor.b, _backgroundColor.a);
+    for (auto const& it : _intProperties) {
+        key += str_format("|%s=%d", it.first.c_str(), it.second.value);
+    }
+    for (auto const& it : _floatProperties) {
+        key += str_format("|%s=%.9g", it.first.c_str(), it.second.value);
+    }
+    for (auto const& it : _stringProperties) {
+        key += str_format("|%s=%d:", it.first.c_str(), (int)it.second.value.size()) + it.second.value;
+    }
+    return true;
+}
+
+void Filter::_appendMergeState(std::string& key, std::initializer_list<float> values) {
+    for (float value : values) {
+        key += str_format("|%.9g", value);
+    }
+}
+
+void Filter::_appendMergeState(std::string& key, const float* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        key += str_format("|%.9g", values[i]);
+    }
+}
+
 bool Filter::registerProperty(const std::string& name, int defaultValue, const std::string& comment/* = ""*/, std::function<void(int&)> setCallback/* = 0*/) {
     if (hasProperty(name)) return false;
     IntProperty property;
@@ -328,6 +388,7 @@ bool Filter::setProperty(const std::string& name, int value) {
     property->value = value;
     if (property->setCallback)
         property->setCallback(value);
+    _notifyGraphChanged();
     return true;
 }
 
@@ -344,6 +405,7 @@ bool Filter::setProperty(const std::string& name, float value) {
     if (property->setCallback)
         property->setCallback(value);
     property->value = value;
+    _notifyGraphChanged();
 
     return true;
 }
@@ -361,6 +423,7 @@ bool Filter::setProperty(const std::string& name, std::string value) {
     property->value = value;
     if (property->setCallback)
         property->setCallback(value);
+    _notifyGraphChanged();
     return true;
 }
 
@@ -57,6 +57,7 @@ void GaussianBlurMonoFilter::setRadius(int radius) {
         _filterProgram = 0;
     }
     initWithShaderString(_generateOptimizedVertexShaderString(_radius, _sigma), _generateOptimizedFragmentShaderString(_radius, _sigma));
+    _notifyGraphChanged();
 }
 
 void GaussianBlurMonoFilter::setSigma(float sigma) {
@@ -79,6 +80,7 @@ void GaussianBlurMonoFilter::setSigma(float sigma) {
         _filterProgram = 0;
     }
     initWithShaderString(_generateOptimizedVertexShaderString(_radius, _sigma), _generateOptimizedFragmentShaderString(_radius, _sigma));
+    _notifyGraphChanged();
 }
 
 bool GaussianBlurMonoFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -326,4 +328,10 @@ std::string GaussianBlurMonoFilter::_generateOptimizedFragmentShaderString(int r
     return shaderStr;
 }
 
+bool GaussianBlurMonoFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {(float)_type, (float)_radius, _sigma});
+    return true;
+}
+
 NS_GI_END
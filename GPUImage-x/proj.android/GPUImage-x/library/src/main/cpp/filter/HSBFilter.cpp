@@ -86,13 +86,14 @@ void HSBFilter::adjustSaturation(float sat) {
     sMat.m[15] = 1.0;
     
     _colorMatrix = sMat * _colorMatrix;
+    _notifyGraphChanged();
 }
 
 void HSBFilter::adjustBrightness(float b) {
     Matrix4 scaleMatrix = Matrix4::IDENTITY;
     scaleMatrix *= b;
     _colorMatrix *= scaleMatrix;
-    
+    _notifyGraphChanged();
 }
 
 NS_GI_END
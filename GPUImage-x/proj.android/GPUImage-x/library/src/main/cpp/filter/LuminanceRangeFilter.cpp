@@ -64,6 +64,7 @@ void LuminanceRangeFilter::setRangeReductionFactor(float rangeReductionFactor) {
     _rangeReductionFactor = rangeReductionFactor;
     if (_rangeReductionFactor > 1.0) _rangeReductionFactor = 1.0;
     else if (_rangeReductionFactor < 0.0) _rangeReductionFactor = 0.0;
+    _notifyGraphChanged();
 }
 
 bool LuminanceRangeFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -71,3 +72,8 @@ bool LuminanceRangeFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool LuminanceRangeFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_rangeReductionFactor});
+    return true;
+}
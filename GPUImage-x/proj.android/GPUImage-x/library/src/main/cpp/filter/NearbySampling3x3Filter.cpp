@@ -103,6 +103,13 @@ bool NearbySampling3x3Filter::proceed(bool bUpdateTargets/* = true*/) {
 void NearbySampling3x3Filter::setTexelSizeMultiplier(float texelSizeMultiplier) {
     if (texelSizeMultiplier > 0)
         _texelSizeMultiplier = texelSizeMultiplier;
+    _notifyGraphChanged();
+}
+
+bool NearbySampling3x3Filter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_texelSizeMultiplier});
+    return true;
 }
 
 NS_GI_END
@@ -30,6 +30,7 @@ class NearbySampling3x3Filter : public Filter {
 public:
     virtual bool initWithFragmentShaderString(const std::string& fragmentShaderSource, int inputNumber = 1) override;
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
     void setTexelSizeMultiplier(float texelSizeMultiplier);
 protected:
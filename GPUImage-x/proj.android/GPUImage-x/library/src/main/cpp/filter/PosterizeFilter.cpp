@@ -61,6 +61,7 @@ void PosterizeFilter::setColorLevels(int colorLevels) {
     _colorLevels = colorLevels;
     if (_colorLevels > 256) _colorLevels = 256;
     else if (_colorLevels < 1) _colorLevels = 1;
+    _notifyGraphChanged();
 }
 
 bool PosterizeFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -68,3 +69,8 @@ bool PosterizeFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool PosterizeFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {(float)_colorLevels});
+    return true;
+}
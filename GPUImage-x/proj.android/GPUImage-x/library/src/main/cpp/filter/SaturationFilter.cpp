@@ -66,6 +66,7 @@ void SaturationFilter::setSaturation(float saturation) {
     _saturation = saturation;
     if (_saturation > 2.0) _saturation = 2.0;
     else if (_saturation < 0.0) _saturation = 0.0;
+    _notifyGraphChanged();
 }
 
 bool SaturationFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -73,3 +74,8 @@ bool SaturationFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool SaturationFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_saturation});
+    return true;
+}
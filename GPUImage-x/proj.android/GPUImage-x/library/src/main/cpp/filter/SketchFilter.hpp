@@ -50,6 +50,7 @@ public:
     static _SketchFilter* create();
     bool init();
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
     void setEdgeStrength(float edgeStrength);
     
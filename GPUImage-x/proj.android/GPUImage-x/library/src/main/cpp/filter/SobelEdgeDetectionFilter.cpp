@@ -125,6 +125,7 @@ bool _SobelEdgeDetectionFilter::init() {
 
 void _SobelEdgeDetectionFilter::setEdgeStrength(float edgeStrength) {
     _edgeStrength = edgeStrength;
+    _notifyGraphChanged();
 }
 
 bool _SobelEdgeDetectionFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -144,5 +145,10 @@ bool _SobelEdgeDetectionFilter::proceed(bool bUpdateTargets/* = true*/) {
     return NearbySampling3x3Filter::proceed(bUpdateTargets);
 }
 
+bool _SobelEdgeDetectionFilter::getMergeKey(std::string& key) const {
+    if (!NearbySampling3x3Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_edgeStrength});
+    return true;
+}
 
 NS_GI_END
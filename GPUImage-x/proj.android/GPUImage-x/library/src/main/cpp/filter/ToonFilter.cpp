@@ -93,10 +93,12 @@ bool ToonFilter::init() {
 
 void ToonFilter::setThreshold(float threshold) {
     _threshold = threshold;
+    _notifyGraphChanged();
 }
 
 void ToonFilter::setQuantizatinLevels(float quantizationLevels) {
     _quantizationLevels = quantizationLevels;
+    _notifyGraphChanged();
 }
 
 bool ToonFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -105,3 +107,8 @@ bool ToonFilter::proceed(bool bUpdateTargets/* = true*/) {
     return NearbySampling3x3Filter::proceed(bUpdateTargets);
 }
 
+bool ToonFilter::getMergeKey(std::string& key) const {
+    if (!NearbySampling3x3Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_threshold, _quantizationLevels});
+    return true;
+}
@@ -29,6 +29,7 @@ public:
     static ToonFilter* create();
     bool init();
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
     void setThreshold(float threshold);
     void setQuantizatinLevels(float quantizationLevels);
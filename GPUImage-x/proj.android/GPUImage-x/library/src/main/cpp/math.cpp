@@ -18,6 +18,7 @@
 
 #include "math.hpp"
 #include <string>
+#include <string.h>
 #include <assert.h>
 
 NS_GI_BEGIN
@@ -232,6 +233,21 @@ const Matrix4 Matrix4::IDENTITY = Matrix4(
                              0.0f, 0.0f, 1.0f, 0.0f,
                              0.0f, 0.0f, 0.0f, 1.0f);
 
+Vector3::Vector3()
+: x(0.0f), y(0.0f), z(0.0f)
+{
+}
+
+Vector3::Vector3(float xx, float yy, float zz)
+: x(xx), y(yy), z(zz)
+{
+}
+
+Vector3::Vector3(const float* array)
+: x(array[0]), y(array[1]), z(array[2])
+{
+}
+
 Matrix4::Matrix4() {
     *this = IDENTITY;
 }
@@ -19,6 +19,9 @@
 #include "Source.hpp"
 #include "../util.h"
 #include "../Context.hpp"
+#include "../GraphOptimizer.hpp"
+#include "../FramePipeline.hpp"
+#include "../filter/FilterGroup.hpp"
 
 #if PLATFORM == PLATFORM_IOS
 #include "IOSTarget.hpp"
@@ -26,16 +29,31 @@
 
 NS_GI_BEGIN
 
+std::atomic<unsigned int> Source::_graphRevision(0);
 
 Source::Source()
 :_framebuffer(0)
 ,_outputRotation(RotationMode::NoRotation)
 ,_framebufferScale(1.0)
+,_graphOptimizer(0)
+,_framePipeline(0)
+,_context(Context::getCurrent())
+,_frameStart(0)
+,_isPullEvaluationEnabled(false)
+,_skippedTargetCount(0)
 {
     
 }
 
 Source::~Source() {
+    if (_graphOptimizer) {
+        delete _graphOptimizer;
+        _graphOptimizer = 0;
+    }
+    if (_framePipeline) {
+        delete _framePipeline;
+        _framePipeline = 0;
+    }
     if (_framebuffer != 0) {
         _framebuffer->release();
         _framebuffer = 0;
@@ -52,6 +70,7 @@ Source* Source::addTarget(Target* target) {
 Source* Source::addTarget(Target* target, int texIdx) {
     if (!hasTarget(target)) {
         _targets[target] = texIdx;
+        _notifyGraphChanged();
         target->setInputFramebuffer(_framebuffer, RotationMode::NoRotation, texIdx);
 //        Ref *ref = dynamic_cast<Ref *>(target);
 //        if (ref) {
@@ -86,6 +105,7 @@ void Source::removeTarget(Target* target) {
             ref->release();
         }
         _targets.erase(itr);
+        _notifyGraphChanged();
     }
 }
 
@@ -97,27 +117,199 @@ void Source::removeAllTargets() {
         }
     }
     _targets.clear();
+    _notifyGraphChanged();
 }
 
 bool Source::proceed(bool bUpdateTargets/* = true*/) {
     if (bUpdateTargets)
-        updateTargets(0);
+        updateTargets(timestampToFrameTime(getFrameTimestamp()));
     return true;
 }
 
+void Source::setFramebufferScale(float framebufferScale) {
+    if (_framebufferScale != framebufferScale) {
+        _framebufferScale = framebufferScale;
+        _notifyGraphChanged();
+    }
+}
+
+void Source::setGraphOptimizationEnabled(bool enabled) {
+    if (enabled && !_graphOptimizer) {
+        _graphOptimizer = new GraphOptimizer(this);
+    } else if (!enabled && _graphOptimizer) {
+        delete _graphOptimizer;
+        _graphOptimizer = 0;
+    }
+}
+
+void Source::setFramesInFlight(int depth) {
+    if (depth > 0) {
+        if (!_framePipeline) {
+            _framePipeline = new FramePipeline(depth);
+        } else {
+            _framePipeline->setDepth(depth);
+        }
+    } else if (_framePipeline) {
+        _framePipeline->endFrame();
+        _framePipeline->finish();
+        delete _framePipeline;
+        _framePipeline = 0;
+    }
+}
+
+int Source::getFramesInFlight() const {
+    return _framePipeline ? _framePipeline->getDepth() : 0;
+}
+
+void Source::_beginPipelinedFrame() {
+    if (Context::getInstance()->getPassSource()) return;
+    if (_frameStart == 0) {
+        _frameStart = getMonotonicTimestamp();
+    }
+    // the GPU only shows in the frame time when a frame waits for the last one
+    if (!_framePipeline && Context::getInstance()->getQualityController()->isActive()) {
+        setFramesInFlight(1);
+    }
+    if (_framePipeline) {
+        _framePipeline->beginFrame();
+    }
+}
+
+int64_t Source::getFrameTimestamp() const {
+    return _framebuffer ? _framebuffer->getTimestamp() : 0;
+}
+
+void Source::setFrameTimestamp(int64_t timestamp) {
+    if (_framebuffer) {
+        _framebuffer->setTimestamp(timestamp);
+    }
+}
+
+Context* Source::getContext() const {
+    return _context ? _context : Context::getDefault();
+}
+
 void Source::updateTargets(float frameTime) {
+    // a pass runs in the context of the source that starts it
+    Context* previousContext = 0;
+    bool isContextSwitched = false;
+    if (_context && _context != Context::getInstance() && !Context::getInstance()->getPassSource()) {
+        previousContext = Context::setCurrent(_context);
+        isContextSwitched = true;
+    }
+
+    bool isRootPass = !Context::getInstance()->getPassSource();
+    if (isRootPass) {
+        _beginPipelinedFrame();
+    }
+    // merges and live targets are settled before the pass starts, not while it runs
+    if (isRootPass) {
+        if (_graphOptimizer) {
+            _graphOptimizer->update();
+        }
+        _liveTargets.clear();
+        if (_isPullEvaluationEnabled) {
+            std::map<Target*, bool> visited;
+            for (auto const& it : _targets) {
+                _findLiveTargets(it.first, visited);
+            }
+        }
+    }
+    Context::getInstance()->beginPass(this);
+    Source* passSource = Context::getInstance()->getPassSource();
     for(auto& it : _targets){
         Target* target = it.first;
+        if (passSource->_isPullEvaluationEnabled && passSource->_liveTargets.find(target) == passSource->_liveTargets.end()) {
+            ++passSource->_skippedTargetCount;
+            continue;
+        }
         target->setInputFramebuffer(_framebuffer, _outputRotation, _targets[target]);
-        if (target->isPrepared()) {
-            target->update(frameTime);
-            target->unPrepear();
+        target->runIfPrepared(frameTime);
+    }
+    Context::getInstance()->endPass();
+    if (isRootPass) {
+        if (_framePipeline) {
+            _framePipeline->endFrame();
+        }
+        // a capture runs the graph over a frame counted already
+        if (!Context::getInstance()->isCapturingFrame) {
+            FrameMetrics* frameMetrics = Context::getInstance()->getFrameMetrics();
+            frameMetrics->recordLatency(FrameMetrics::ProcessingLatency, getFrameTimestamp());
+            frameMetrics->recordPassEnd();
+            int64_t frameTime = (getMonotonicTimestamp() - _frameStart) / 1000;
+            frameMetrics->record(FrameMetrics::FrameTime, frameTime);
+            Context::getInstance()->getQualityController()->recordFrame(frameTime);
+        }
+        _frameStart = 0;
+    }
+
+    if (isContextSwitched) {
+        Context::setCurrent(previousContext);
+    }
+}
+
+bool Source::_findLiveTargets(Target* target, std::map<Target*, bool>& visited) {
+    std::map<Target*, bool>::iterator it = visited.find(target);
+    if (it != visited.end()) return it->second;
+    visited[target] = false;
+
+    bool isLive = false;
+    Source* source = dynamic_cast<Source*>(target);
+    if (!source) {
+        isLive = target->isActive();
+    } else {
+        Context* context = Context::getInstance();
+        isLive = context->isCapturingFrame && context->captureUpToFilter == source;
+        FilterGroup* filterGroup = dynamic_cast<FilterGroup*>(source);
+        if (!filterGroup || filterGroup->getTerminalFilter()) {
+            for (auto const& child : source->getTargets()) {
+                // visit every child, the live ones all need marking
+                if (_findLiveTargets(child.first, visited)) {
+                    isLive = true;
+                }
+            }
+        }
+    }
+
+    visited[target] = isLive;
+    if (isLive) {
+        _liveTargets.insert(target);
+        Filter* filter = dynamic_cast<Filter*>(target);
+        if (filter) {
+            _addLiveFilters(filter);
+        }
+    }
+    return isLive;
+}
+
+void Source::_addLiveFilters(Filter* filter) {
+    // The members of a group feed each other, a live group needs all of them.
+    // Only the first members are listed, the rest hang off their targets.
+    FilterGroup* filterGroup = dynamic_cast<FilterGroup*>(filter);
+    if (!filterGroup || !filterGroup->getTerminalFilter()) return;
+    for (auto const& member : filterGroup->getFilters()) {
+        _addLiveGroupMember(member, filterGroup->getTerminalFilter());
+    }
+}
+
+void Source::_addLiveGroupMember(Filter* member, Filter* terminalFilter) {
+    if (!_liveTargets.insert(member).second) return;
+    _addLiveFilters(member);
+    if (member == terminalFilter) return;
+
+    FilterGroup* filterGroup = dynamic_cast<FilterGroup*>(member);
+    if (filterGroup && !filterGroup->getTerminalFilter()) return;
+    for (auto const& it : member->getTargets()) {
+        Filter* filter = dynamic_cast<Filter*>(it.first);
+        if (filter) {
+            _addLiveGroupMember(filter, terminalFilter);
         }
     }
 }
 
 unsigned char* Source::captureAProcessedFrameData(Filter* upToFilter, int width/* = 0*/, int height/* = 0*/) {
-    if (Context::getInstance()->isCapturingFrame) return 0 ;
+    Context* context = getContext();
+    if (context->isCapturingFrame) return 0 ;
 
     if (width <= 0 || height <= 0) {
         if (!_framebuffer) return 0;
@@ -125,31 +317,119 @@ unsigned char* Source::captureAProcessedFrameData(Filter* upToFilter, int width/
         height = getRotatedFramebufferHeight();
     }
     
-    Context::getInstance()->isCapturingFrame = true;
-    Context::getInstance()->captureWidth = width;
-    Context::getInstance()->captureHeight = height;
-    Context::getInstance()->captureUpToFilter = upToFilter;
+    // the pass runs in the context of this source, so its capture state goes there too
+    Context* previousContext = Context::setCurrent(context);
+    context->isCapturingFrame = true;
+    context->captureWidth = width;
+    context->captureHeight = height;
+    context->captureUpToFilter = upToFilter;
 
     proceed(true);
-    unsigned char* processedFrameData = Context::getInstance()->capturedFrameData;
+    unsigned char* processedFrameData = context->capturedFrameData;
 
-    Context::getInstance()->capturedFrameData = 0;
-    Context::getInstance()->captureWidth = 0;
-    Context::getInstance()->captureHeight = 0;
-    Context::getInstance()->isCapturingFrame = false;
+    context->capturedFrameData = 0;
+    context->captureWidth = 0;
+    context->captureHeight = 0;
+    context->isCapturingFrame = false;
+    Context::setCurrent(previousContext);
     
     return processedFrameData;
 }
 
+bool Source::captureAProcessedFrameDataInto(Filter* upToFilter, unsigned char* pixels, int stride, int width/* = 0*/, int height/* = 0*/) {
+    Context* context = getContext();
+    if (context->isCapturingFrame || !pixels) return false;
+
+    if (width <= 0 || height <= 0) {
+        if (!_framebuffer) return false;
+        width = getRotatedFramebufferWidth();
+        height = getRotatedFramebufferHeight();
+    }
+    if (stride <= 0) stride = width * 4;
+    if (stride < width * 4) {
+        Log("WARNING", "Source: stride %d is too small for a %dx%d capture", stride, width, height);
+        return false;
+    }
+
+    Context* previousContext = Context::setCurrent(context);
+    context->isCapturingFrame = true;
+    context->captureWidth = width;
+    context->captureHeight = height;
+    context->captureUpToFilter = upToFilter;
+    context->captureDestination = pixels;
+    context->captureStride = stride;
+
+    proceed(true);
+    bool captured = context->capturedFrameData != 0;
+
+    context->capturedFrameData = 0;
+    context->captureDestination = 0;
+    context->captureStride = 0;
+    context->captureWidth = 0;
+    context->captureHeight = 0;
+    context->isCapturingFrame = false;
+    Context::setCurrent(previousContext);
+
+    return captured;
+}
+
+FrameData* Source::captureAProcessedFrameDataToPool(Filter* upToFilter, int width/* = 0*/, int height/* = 0*/) {
+    if (width <= 0 || height <= 0) {
+        if (!_framebuffer) return 0;
+        width = getRotatedFramebufferWidth();
+        height = getRotatedFramebufferHeight();
+    }
+
+    FrameData* frameData = getContext()->getFrameDataPool()->fetchFrameData(width, height);
+    if (!captureAProcessedFrameDataInto(upToFilter, frameData->getData(), frameData->getStride(), width, height)) {
+        frameData->release();
+        return 0;
+    }
+    return frameData;
+}
+
+bool Source::captureAProcessedFrameDataAsync(Filter* upToFilter, ReadbackQueue::Callback callback, int width/* = 0*/, int height/* = 0*/) {
+    Context* context = getContext();
+    if (context->isCapturingFrame || !callback) return false;
+
+    if (width <= 0 || height <= 0) {
+        if (!_framebuffer) return false;
+        width = getRotatedFramebufferWidth();
+        height = getRotatedFramebufferHeight();
+    }
+
+    Context* previousContext = Context::setCurrent(context);
+    // hand over what has completed before queueing more
+    context->getReadbackQueue()->poll();
+
+    context->isCapturingFrame = true;
+    context->captureWidth = width;
+    context->captureHeight = height;
+    context->captureUpToFilter = upToFilter;
+    context->captureCallback = callback;
+
+    proceed(true);
+
+    context->captureCallback = nullptr;
+    context->captureWidth = 0;
+    context->captureHeight = 0;
+    context->isCapturingFrame = false;
+    Context::setCurrent(previousContext);
+
+    return true;
+}
+
 void Source::setFramebuffer(Framebuffer* fb, RotationMode outputRotation/* = RotationMode::NoRotation*/) {
-    if (_framebuffer != fb && _framebuffer != 0) {
+    _outputRotation = outputRotation;
+    // held already, e.g. the same texture uploaded again
+    if (_framebuffer == fb) return;
+    if (_framebuffer != 0) {
         _framebuffer->release();
         _framebuffer = 0;
     }
     _framebuffer = fb;
     if (_framebuffer)
         _framebuffer->retain();
-    _outputRotation = outputRotation;
 }
 
 int Source::getRotatedFramebufferWidth() const {
@@ -21,8 +21,12 @@
 
 #include "../macros.h"
 #include "../target/Target.hpp"
+#include <atomic>
 #include <map>
+#include <set>
 #include <functional>
+#include "../ReadbackQueue.hpp"
+#include "../FrameDataPool.hpp"
 #include "../target/Target.hpp"
 
 #if PLATFORM == PLATFORM_IOS
@@ -32,6 +36,9 @@
 NS_GI_BEGIN
 
 class Filter;
+class GraphOptimizer;
+class FramePipeline;
+class Context;
 class Source : public virtual Ref {
 public:
     Source();
@@ -50,20 +57,83 @@ public:
     virtual Framebuffer* getFramebuffer() const;
     virtual void releaseFramebuffer(bool returnToCache = true);
     
-    void setFramebufferScale(float framebufferScale) { _framebufferScale = framebufferScale; }
+    virtual void setFramebufferScale(float framebufferScale);
+    float getFramebufferScale() const { return _framebufferScale; }
+    RotationMode getOutputRotation() const { return _outputRotation; }
     int getRotatedFramebufferWidth() const;
     int getRotatedFramebufferHeight() const;
     
+    // updates the targets with the frameTime of getFrameTimestamp()
     virtual bool proceed(bool bUpdateTargets = true);
     virtual void updateTargets(float frameTime);
+    // Timestamp of the frame in the framebuffer of the source, 0 if unknown.
+    // Sources stamp their frames when they get them, see
+    // getMonotonicTimestamp(); set one to replace it, e.g. of a decoded video frame.
+    int64_t getFrameTimestamp() const;
+    void setFrameTimestamp(int64_t timestamp);
+
+    // the context current when the source was made, its passes run in it
+    Context* getContext() const;
+
+    // Merge identical filters reachable from this source before each pass,
+    // re-evaluated whenever the graph changes. See GraphOptimizer.
+    void setGraphOptimizationEnabled(bool enabled);
+    // bumped whenever targets are added or removed or a filter property is set
+    static unsigned int getGraphRevision() { return _graphRevision; }
+
+    // Pull evaluation: each pass first works out which targets lead to an
+    // active sink (see Target::isActive) or to the filter of a pending capture,
+    // and updates only those. Off by default, every target is updated.
+    void setPullEvaluationEnabled(bool enabled) { _isPullEvaluationEnabled = enabled; }
+    bool isPullEvaluationEnabled() const { return _isPullEvaluationEnabled; }
+    // targets skipped by pull evaluation in the passes started by this source
+    unsigned int getSkippedTargetCount() const { return _skippedTargetCount; }
+
+    // Frame pipelining: let up to depth frames, 1 to 3, be in flight on the
+    // GPU, each pass started by this source is one frame. 0, the default,
+    // turns it off. See FramePipeline.
+    virtual void setFramesInFlight(int depth);
+    int getFramesInFlight() const;
+    FramePipeline* getFramePipeline() const { return _framePipeline; }
 
     virtual unsigned char* captureAProcessedFrameData(Filter* upToFilter, int width = 0, int height = 0);
+    // Capture into caller memory, rows stride bytes apart (0 for width * 4).
+    virtual bool captureAProcessedFrameDataInto(Filter* upToFilter, unsigned char* pixels, int stride, int width = 0, int height = 0);
+    // Capture into memory from the frame data pool of getContext(), release() it when done.
+    virtual FrameData* captureAProcessedFrameDataToPool(Filter* upToFilter, int width = 0, int height = 0);
+    // Like captureAProcessedFrameData but without waiting for the GPU. On GLES3 the
+    // callback runs from a later Context::getReadbackQueue()->poll(), on GLES2 before returning.
+    virtual bool captureAProcessedFrameDataAsync(Filter* upToFilter, ReadbackQueue::Callback callback, int width = 0, int height = 0);
     
 protected:
     Framebuffer* _framebuffer;
     RotationMode _outputRotation;
     std::map<Target*, int> _targets;
     float _framebufferScale;
+    GraphOptimizer* _graphOptimizer;
+    FramePipeline* _framePipeline;
+    // 0 for the default context
+    Context* _context;
+    // when the frame of the next root pass began, its upload included, 0
+    // until _beginPipelinedFrame()
+    int64_t _frameStart;
+
+    static void _notifyGraphChanged() { ++_graphRevision; }
+    // open the frame before uploading into it, so the upload waits for a free
+    // slot and the framebuffers it fetches join the frame, and its time is
+    // counted from there
+    void _beginPipelinedFrame();
+
+private:
+    static std::atomic<unsigned int> _graphRevision;
+
+    bool _isPullEvaluationEnabled;
+    std::set<Target*> _liveTargets;
+    unsigned int _skippedTargetCount;
+
+    bool _findLiveTargets(Target* target, std::map<Target*, bool>& visited);
+    void _addLiveFilters(Filter* filter);
+    void _addLiveGroupMember(Filter* member, Filter* terminalFilter);
 };
 
 
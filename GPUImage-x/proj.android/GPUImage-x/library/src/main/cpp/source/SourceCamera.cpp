@@ -19,10 +19,47 @@
 #include "SourceCamera.h"
 #include "../Context.hpp"
 #include "../util.h"
+#include "../filter/Filter.hpp"
 
 USING_NS_GI
 
-SourceCamera::SourceCamera() {
+// Converts a YUV 4:2:0 frame to RGBA. uMap is sampled from its red channel and
+// vMap from its alpha channel, so one shader serves both layouts: the planar
+// U and V planes are uploaded as luminance and alpha textures, and the
+// interleaved chroma plane is uploaded once as a luminance-alpha texture and
+// bound to both samplers.
+const std::string kYUVConversionFragmentShaderString = SHADER_STRING
+(
+ varying highp vec2 vTexCoord;
+ uniform sampler2D yMap;
+ uniform sampler2D uMap;
+ uniform sampler2D vMap;
+ uniform mediump mat3 colorConversionMatrix;
+ uniform mediump float lumaOffset;
+
+ void main()
+ {
+     mediump vec3 yuv;
+     yuv.x = texture2D(yMap, vTexCoord).r - lumaOffset;
+     yuv.y = texture2D(uMap, vTexCoord).r - 0.5;
+     yuv.z = texture2D(vMap, vTexCoord).a - 0.5;
+     gl_FragColor = vec4(colorConversionMatrix * yuv, 1.0);
+ }
+ );
+
+// the queue format of RGBA frames, YUV ones are queued with their YUVFormat
+static const int kRGBAFrameFormat = -1;
+
+SourceCamera::SourceCamera()
+:_inputTexture(2, true)
+,_lumaTexture(2, true)
+,_chromaTexture(2, true)
+,_secondChromaTexture(2, true)
+,_yuvColorSpace(BT601FullRange)
+,_yuvConversionProgram(0)
+,_yuvPositionAttribLocation(0)
+,_yuvTexCoordAttribLocation(0)
+{
 #if PLATFORM == PLATFORM_IOS
     _videoDataOutputSampleBufferDelegate = [[VideoDataOutputSampleBufferDelegate alloc] init];
     _videoDataOutputSampleBufferDelegate.sourceCamera = this;
@@ -37,6 +74,11 @@ SourceCamera::~SourceCamera() {
     stop();
     _videoDataOutputSampleBufferDelegate = 0;
 #endif
+    _frameQueue.close();
+    if (_yuvConversionProgram) {
+        delete _yuvConversionProgram;
+        _yuvConversionProgram = 0;
+    }
 }
 
 SourceCamera* SourceCamera::create() {
@@ -50,18 +92,149 @@ SourceCamera* SourceCamera::create() {
 }
 
 void SourceCamera::setFrameData(int width, int height, const void* pixels, RotationMode outputRotation/* = RotationMode::NoRotation*/) {
+    // a new frame means the asynchronous captures of earlier ones are likely done
+    Context::getInstance()->getReadbackQueue()->poll();
+    _beginPipelinedFrame();
+    TextureAttributes textureAttributes = Framebuffer::defaultTextureAttribures;
+#if PLATFORM == PLATFORM_IOS
+    textureAttributes.format = GL_BGRA;
+#endif
+    this->setFramebuffer(_inputTexture.upload(width, height, pixels, textureAttributes), outputRotation);
+    setFrameTimestamp(getMonotonicTimestamp());
+}
+
+void SourceCamera::setYUVFrameData(int width, int height, const void* yuvData, YUVFormat yuvFormat, RotationMode outputRotation/* = RotationMode::NoRotation*/) {
+    if (!_yuvConversionProgram && !_initYUVConversionProgram()) return;
+    Context::getInstance()->getReadbackQueue()->poll();
+    _beginPipelinedFrame();
+
+    static const GLfloat imageVertices[] = {
+        -1.0f, -1.0f,
+        1.0f, -1.0f,
+        -1.0f,  1.0f,
+        1.0f,  1.0f,
+    };
+
+    static const GLfloat textureCoordinates[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+    };
+
+    TextureAttributes lumaAttributes = Framebuffer::defaultTextureAttribures;
+    lumaAttributes.internalFormat = lumaAttributes.format = GL_LUMINANCE;
+    TextureAttributes chromaAttributes = Framebuffer::defaultTextureAttribures;
+    chromaAttributes.internalFormat = chromaAttributes.format = (yuvFormat == I420 ? GL_LUMINANCE : GL_LUMINANCE_ALPHA);
+    TextureAttributes secondChromaAttributes = Framebuffer::defaultTextureAttribures;
+    secondChromaAttributes.internalFormat = secondChromaAttributes.format = GL_ALPHA;
+
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    const unsigned char* yPlane = (const unsigned char*)yuvData;
+    const unsigned char* chromaPlane = yPlane + width * height;
+
+    Framebuffer* lumaTexture = _lumaTexture.upload(width, height, yPlane, lumaAttributes);
+    Framebuffer* chromaTexture = _chromaTexture.upload(chromaWidth, chromaHeight, chromaPlane, chromaAttributes);
+    Framebuffer* secondChromaTexture = 0;
+    if (yuvFormat == I420) {
+        secondChromaTexture = _secondChromaTexture.upload(chromaWidth, chromaHeight, chromaPlane + chromaWidth * chromaHeight, secondChromaAttributes);
+    }
+
     this->setFramebuffer(0);
-    Framebuffer* framebuffer = Context::getInstance()->getFramebufferCache()->fetchFramebuffer(width, height, true);
+    Framebuffer* framebuffer = Context::getInstance()->getFramebufferCache()->fetchFramebuffer(width, height);
     this->setFramebuffer(framebuffer, outputRotation);
     framebuffer->release();
+    setFrameTimestamp(getMonotonicTimestamp());
 
-    CHECK_GL(glBindTexture(GL_TEXTURE_2D, this->getFramebuffer()->getTexture()));
-#if PLATFORM == PLATFORM_IOS
-    CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, pixels));
-#elif PLATFORM == PLATFORM_ANDROID
-	CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-#endif
-    CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+    Context::getInstance()->setActiveShaderProgram(_yuvConversionProgram);
+    framebuffer->active();
+    CHECK_GL(glActiveTexture(GL_TEXTURE0));
+    CHECK_GL(glBindTexture(GL_TEXTURE_2D, lumaTexture->getTexture()));
+    _yuvConversionProgram->setUniformValue("yMap", 0);
+    CHECK_GL(glActiveTexture(GL_TEXTURE1));
+    CHECK_GL(glBindTexture(GL_TEXTURE_2D, chromaTexture->getTexture()));
+    _yuvConversionProgram->setUniformValue("uMap", 1);
+    CHECK_GL(glActiveTexture(GL_TEXTURE2));
+    CHECK_GL(glBindTexture(GL_TEXTURE_2D, secondChromaTexture ? secondChromaTexture->getTexture() : chromaTexture->getTexture()));
+    _yuvConversionProgram->setUniformValue("vMap", 2);
+    _yuvConversionProgram->setUniformValue("colorConversionMatrix", _getYUVConversionMatrix(yuvFormat));
+    bool isVideoRange = (_yuvColorSpace == BT601VideoRange || _yuvColorSpace == BT709VideoRange);
+    _yuvConversionProgram->setUniformValue("lumaOffset", isVideoRange ? 16.0f / 255.0f : 0.0f);
+    CHECK_GL(glEnableVertexAttribArray(_yuvPositionAttribLocation));
+    CHECK_GL(glEnableVertexAttribArray(_yuvTexCoordAttribLocation));
+    CHECK_GL(glVertexAttribPointer(_yuvPositionAttribLocation, 2, GL_FLOAT, 0, 0, imageVertices));
+    CHECK_GL(glVertexAttribPointer(_yuvTexCoordAttribLocation, 2, GL_FLOAT, 0, 0, textureCoordinates));
+    CHECK_GL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    framebuffer->inactive();
+    CHECK_GL(glActiveTexture(GL_TEXTURE0));
+}
+
+bool SourceCamera::queueFrameData(int width, int height, const void* pixels, RotationMode outputRotation/* = RotationMode::NoRotation*/) {
+    return _frameQueue.push(width, height, kRGBAFrameFormat, outputRotation, pixels, (size_t)width * height * 4);
+}
+
+bool SourceCamera::queueYUVFrameData(int width, int height, const void* yuvData, YUVFormat yuvFormat, RotationMode outputRotation/* = RotationMode::NoRotation*/) {
+    size_t chromaSize = (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    return _frameQueue.push(width, height, yuvFormat, outputRotation, yuvData, (size_t)width * height + chromaSize * 2);
+}
+
+bool SourceCamera::processQueuedFrame() {
+    if (!_frameQueue.pop(_queuedFrame)) return false;
+    if (_queuedFrame.format == kRGBAFrameFormat) {
+        setFrameData(_queuedFrame.width, _queuedFrame.height, _queuedFrame.pixels.data(), _queuedFrame.rotation);
+    } else {
+        setYUVFrameData(_queuedFrame.width, _queuedFrame.height, _queuedFrame.pixels.data(), (YUVFormat)_queuedFrame.format, _queuedFrame.rotation);
+    }
+    // the frame was taken when it was queued, not now
+    setFrameTimestamp(std::chrono::duration_cast<std::chrono::nanoseconds>(_queuedFrame.queueTime.time_since_epoch()).count());
+    proceed();
+    _frameQueue.processed(_queuedFrame);
+    return true;
+}
+
+void SourceCamera::setFramesInFlight(int depth) {
+    Source::setFramesInFlight(depth);
+    int bufferCount = depth > 1 ? depth + 1 : 2;
+    _inputTexture.setBufferCount(bufferCount);
+    _lumaTexture.setBufferCount(bufferCount);
+    _chromaTexture.setBufferCount(bufferCount);
+    _secondChromaTexture.setBufferCount(bufferCount);
+}
+
+bool SourceCamera::_initYUVConversionProgram() {
+    _yuvConversionProgram = GLProgram::createByShaderString(kDefaultVertexShader, kYUVConversionFragmentShaderString);
+    if (!_yuvConversionProgram) return false;
+    _yuvPositionAttribLocation = _yuvConversionProgram->getAttribLocation("position");
+    _yuvTexCoordAttribLocation = _yuvConversionProgram->getAttribLocation("texCoord");
+    return true;
+}
+
+Matrix3 SourceCamera::_getYUVConversionMatrix(YUVFormat yuvFormat) const {
+    // Kr/Kb derived coefficients of the YCbCr to RGB conversion
+    float rv, gu, gv, bu;
+    if (_yuvColorSpace == BT709FullRange || _yuvColorSpace == BT709VideoRange) {
+        rv = 1.5748; gu = -0.187324; gv = -0.468124; bu = 1.8556;
+    } else {
+        rv = 1.402; gu = -0.344136; gv = -0.714136; bu = 1.772;
+    }
+
+    // video range stores luma in [16, 235] and chroma in [16, 240]
+    float ys = 1.0, cs = 1.0;
+    if (_yuvColorSpace == BT601VideoRange || _yuvColorSpace == BT709VideoRange) {
+        ys = 255.0 / 219.0;
+        cs = 255.0 / 224.0;
+    }
+
+    if (yuvFormat == NV21) {
+        // the interleaved plane is VU, so the chroma columns are swapped
+        return Matrix3(ys, rv * cs, 0.0,
+                       ys, gv * cs, gu * cs,
+                       ys, 0.0, bu * cs);
+    }
+    return Matrix3(ys, 0.0, rv * cs,
+                   ys, gu * cs, gv * cs,
+                   ys, bu * cs, 0.0);
 }
 
 #if PLATFORM == PLATFORM_IOS
@@ -29,14 +29,8 @@ SourceImage* SourceImage::create(int width, int height, const void* pixels) {
 }
 
 SourceImage* SourceImage::setImage(int width, int height, const void* pixels) {
-    this->setFramebuffer(0);
-    Framebuffer* framebuffer = Context::getInstance()->getFramebufferCache()->fetchFramebuffer(width, height, true);
-    this->setFramebuffer(framebuffer);
-    framebuffer->release();
-
-    CHECK_GL(glBindTexture(GL_TEXTURE_2D, this->getFramebuffer()->getTexture()));
-    CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-    CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+    this->setFramebuffer(_inputTexture.upload(width, height, pixels));
+    setFrameTimestamp(getMonotonicTimestamp());
     return this;
 }
 
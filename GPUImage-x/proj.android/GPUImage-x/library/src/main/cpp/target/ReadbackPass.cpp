@@ -0,0 +1,191 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ReadbackPass.hpp"
+#include "../Context.hpp"
+#include "../util.h"
+#include "../filter/Filter.hpp"
+#include <string.h>
+
+NS_GI_BEGIN
+
+static const GLfloat kImageVertices[] = {
+    -1.0f, -1.0f,
+    1.0f, -1.0f,
+    -1.0f,  1.0f,
+    1.0f,  1.0f,
+};
+
+static const GLfloat kNoRotationTextureCoordinates[] = {
+    0.0f, 0.0f,
+    1.0f, 0.0f,
+    0.0f, 1.0f,
+    1.0f, 1.0f,
+};
+
+const std::string kReadbackPackVertexShaderString = SHADER_STRING
+(
+ attribute vec4 position;
+
+ void main()
+ {
+     gl_Position = position;
+ }
+);
+
+const std::string kReadbackPackHeaderShaderString = SHADER_STRING
+(
+ precision highp float;
+ uniform float rowBytes;
+);
+
+const std::string kReadbackPackBytewiseShaderString = SHADER_STRING
+(
+ vec4 packedTexel(float offset)
+ {
+     return vec4(packedByte(offset), packedByte(offset + 1.0), packedByte(offset + 2.0), packedByte(offset + 3.0));
+ }
+);
+
+// Every texel of the output holds four consecutive bytes of the packed rows.
+const std::string kReadbackPackMainShaderString = SHADER_STRING
+(
+ void main()
+ {
+     vec2 texel = floor(gl_FragCoord.xy);
+     gl_FragColor = packedTexel(texel.y * rowBytes + texel.x * 4.0);
+ }
+);
+
+bool ReadbackPass::isRepeatedPass() {
+    return Context::getInstance()->isCapturingFrame;
+}
+
+GLProgram* ReadbackPass::createPackProgram(const std::string& functions, bool isBytewise) {
+    return GLProgram::createByShaderString(kReadbackPackVertexShaderString,
+        kReadbackPackHeaderShaderString + functions + (isBytewise ? kReadbackPackBytewiseShaderString : "") + kReadbackPackMainShaderString);
+}
+
+Framebuffer* ReadbackPass::fetchPackFramebuffer(int rowBytes, int size) {
+    int framebufferWidth = (rowBytes + 3) / 4;
+    int framebufferHeight = (size + framebufferWidth * 4 - 1) / (framebufferWidth * 4);
+    return Context::getInstance()->getFramebufferCache()->fetchFramebuffer(framebufferWidth, framebufferHeight);
+}
+
+void ReadbackPass::drawPack(GLProgram* program, GLuint positionAttribLocation, Framebuffer* inputFramebuffer, Framebuffer* outputFramebuffer) {
+    Context::getInstance()->setActiveShaderProgram(program);
+    outputFramebuffer->active();
+    CHECK_GL(glActiveTexture(GL_TEXTURE0));
+    CHECK_GL(glBindTexture(GL_TEXTURE_2D, inputFramebuffer->getTexture()));
+    program->setUniformValue("colorMap", 0);
+    program->setUniformValue("rowBytes", (float)outputFramebuffer->getWidth() * 4);
+    CHECK_GL(glEnableVertexAttribArray(positionAttribLocation));
+    CHECK_GL(glVertexAttribPointer(positionAttribLocation, 2, GL_FLOAT, 0, 0, kImageVertices));
+    CHECK_GL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    outputFramebuffer->inactive();
+}
+
+void ReadbackPass::readPacked(Framebuffer* framebuffer, ReadbackQueue::Callback callback, int width, int height) {
+    if (framebuffer->getWidth() == width && framebuffer->getHeight() == height) {
+        Context::getInstance()->getReadbackQueue()->read(framebuffer, callback);
+        return;
+    }
+    // packed rows are the first bytes of the read, whatever the framebuffer size
+    Context::getInstance()->getReadbackQueue()->read(framebuffer, [callback, width, height](const unsigned char* pixels, int, int) {
+        callback(pixels, width, height);
+    });
+}
+
+void ReadbackPass::draw(GLProgram* program, Framebuffer* inputFramebuffer, Framebuffer* outputFramebuffer, const GLfloat* textureCoordinates) {
+    GLuint positionAttribLocation = program->getAttribLocation("position");
+    GLuint texCoordAttribLocation = program->getAttribLocation("texCoord");
+    Context::getInstance()->setActiveShaderProgram(program);
+    outputFramebuffer->active();
+    CHECK_GL(glActiveTexture(GL_TEXTURE0));
+    CHECK_GL(glBindTexture(GL_TEXTURE_2D, inputFramebuffer->getTexture()));
+    program->setUniformValue("colorMap", 0);
+    CHECK_GL(glEnableVertexAttribArray(positionAttribLocation));
+    CHECK_GL(glEnableVertexAttribArray(texCoordAttribLocation));
+    CHECK_GL(glVertexAttribPointer(positionAttribLocation, 2, GL_FLOAT, 0, 0, kImageVertices));
+    CHECK_GL(glVertexAttribPointer(texCoordAttribLocation, 2, GL_FLOAT, 0, 0, textureCoordinates));
+    CHECK_GL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    outputFramebuffer->inactive();
+}
+
+Framebuffer* ReadbackPass::downscale(GLProgram*& downscaleProgram, Framebuffer* inputFramebuffer, GLfloat* textureCoordinates,
+                                     float& regionWidth, float& regionHeight, float targetWidth, float targetHeight) {
+    Framebuffer* sourceFramebuffer = inputFramebuffer;
+    sourceFramebuffer->retain();
+    while (regionWidth > targetWidth * 2 || regionHeight > targetHeight * 2) {
+        if (!downscaleProgram) {
+            downscaleProgram = GLProgram::createByShaderString(kDefaultVertexShader, kDefaultFragmentShader);
+            if (!downscaleProgram) {
+                Log("ERROR", "ReadbackPass: failed to create the downscale program");
+                break;
+            }
+        }
+        int stepWidth = regionWidth > targetWidth * 2 ? (int)(regionWidth + 1) / 2 : (int)(targetWidth + 0.5);
+        int stepHeight = regionHeight > targetHeight * 2 ? (int)(regionHeight + 1) / 2 : (int)(targetHeight + 0.5);
+        if (stepWidth < 1) stepWidth = 1;
+        if (stepHeight < 1) stepHeight = 1;
+        Framebuffer* stepFramebuffer = Context::getInstance()->getFramebufferCache()->fetchFramebuffer(stepWidth, stepHeight);
+        draw(downscaleProgram, sourceFramebuffer, stepFramebuffer, textureCoordinates);
+        sourceFramebuffer->release();
+        sourceFramebuffer = stepFramebuffer;
+        regionWidth = stepWidth;
+        regionHeight = stepHeight;
+        memcpy(textureCoordinates, kNoRotationTextureCoordinates, sizeof(kNoRotationTextureCoordinates));
+    }
+    return sourceFramebuffer;
+}
+
+Matrix3 ReadbackPass::getTexCoordMatrix(RotationMode rotationMode, float scaleX/* = 1.0*/, float scaleY/* = 1.0*/, float offsetX/* = 0.0*/, float offsetY/* = 0.0*/) {
+    // origin and the directions of the rotated x and y axes in the input
+    float ox = 0, oy = 0, xx = 1, xy = 0, yx = 0, yy = 1;
+    switch (rotationMode) {
+        case RotateLeft:
+            ox = 1; oy = 0; xx = 0; xy = 1; yx = -1; yy = 0;
+            break;
+        case RotateRight:
+            ox = 0; oy = 1; xx = 0; xy = -1; yx = 1; yy = 0;
+            break;
+        case FlipVertical:
+            ox = 0; oy = 1; xx = 1; xy = 0; yx = 0; yy = -1;
+            break;
+        case FlipHorizontal:
+            ox = 1; oy = 0; xx = -1; xy = 0; yx = 0; yy = 1;
+            break;
+        case RotateRightFlipVertical:
+            ox = 0; oy = 0; xx = 0; xy = 1; yx = 1; yy = 0;
+            break;
+        case RotateRightFlipHorizontal:
+            ox = 1; oy = 1; xx = 0; xy = -1; yx = -1; yy = 0;
+            break;
+        case Rotate180:
+            ox = 1; oy = 1; xx = -1; xy = 0; yx = 0; yy = -1;
+            break;
+        case NoRotation:
+        default:
+            break;
+    }
+    return Matrix3(xx * scaleX, yx * scaleY, ox + xx * offsetX + yx * offsetY,
+                   xy * scaleX, yy * scaleY, oy + xy * offsetX + yy * offsetY,
+                   0, 0, 1);
+}
+
+NS_GI_END
@@ -0,0 +1,73 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ReadbackPass_hpp
+#define ReadbackPass_hpp
+
+#include "../macros.h"
+#include "Target.hpp"
+#include "../GLProgram.hpp"
+#include "../ReadbackQueue.hpp"
+
+NS_GI_BEGIN
+
+// The draws ReadbackTarget, YUVTarget and TensorTarget share to bring a frame
+// into the form it is read in. A packing program computes the bytes of the
+// output itself and writes them four to a texel of an RGBA framebuffer, so
+// only the bytes asked for cross the bus and the read returns them first.
+class ReadbackPass {
+public:
+    // A capture runs the graph over the same frame again, the frame was read
+    // in the pass that drew it already.
+    static bool isRepeatedPass();
+
+    // Creates a packing program from GLSL functions defining
+    // vec4 packedTexel(float offset), the four bytes from offset on, or with
+    // isBytewise float packedByte(float offset). They follow highp precision
+    // and the rowBytes uniform.
+    static GLProgram* createPackProgram(const std::string& functions, bool isBytewise);
+    // a framebuffer for size bytes in rows of rowBytes, four bytes to a texel
+    static Framebuffer* fetchPackFramebuffer(int rowBytes, int size);
+    // Draws the packing program into the framebuffer with the input bound as
+    // colorMap. Make the program active and set its other uniforms first.
+    static void drawPack(GLProgram* program, GLuint positionAttribLocation, Framebuffer* inputFramebuffer, Framebuffer* outputFramebuffer);
+    // reads width * height pixels of output, the callback gets their size
+    // whatever the size of the framebuffer
+    static void readPacked(Framebuffer* framebuffer, ReadbackQueue::Callback callback, int width, int height);
+
+    // Draws the input at the texture coordinates of the output corners with a
+    // program of kDefaultVertexShader.
+    static void draw(GLProgram* program, Framebuffer* inputFramebuffer, Framebuffer* outputFramebuffer, const GLfloat* textureCoordinates);
+    // Halves the region of the input at the texture coordinates, regionWidth
+    // by regionHeight pixels, a pass at a time until it is within twice the
+    // target size. A bilinear sample midway between four texels averages them
+    // all, so every input pixel counts towards the result. Returns a retained
+    // framebuffer, the input itself if small enough already, and the region in
+    // it. The downscale program is created on first use.
+    static Framebuffer* downscale(GLProgram*& downscaleProgram, Framebuffer* inputFramebuffer, GLfloat* textureCoordinates,
+                                  float& regionWidth, float& regionHeight, float targetWidth, float targetHeight);
+
+    // Maps a position in the output, from 0 to 1, to the input texture: first
+    // to the image after rotation with scale and offset, then through the
+    // texture coordinates Filter draws the rotation with.
+    static Matrix3 getTexCoordMatrix(RotationMode rotationMode, float scaleX = 1.0, float scaleY = 1.0, float offsetX = 0.0, float offsetY = 0.0);
+};
+
+NS_GI_END
+
+#endif /* ReadbackPass_hpp */
@@ -0,0 +1,358 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ReadbackTarget.hpp"
+#include "ReadbackPass.hpp"
+#include "../Context.hpp"
+#include "../util.h"
+#include "../filter/Filter.hpp"
+
+NS_GI_BEGIN
+
+const std::string kReadbackBGRAFragmentShaderString = SHADER_STRING
+(
+ varying highp vec2 vTexCoord;
+ uniform sampler2D colorMap;
+
+ void main()
+ {
+     gl_FragColor = texture2D(colorMap, vTexCoord).bgra;
+ }
+);
+
+// the bytes of the reduced formats, packed by ReadbackPass
+const std::string kReadbackPackShaderString = SHADER_STRING
+(
+ uniform sampler2D colorMap;
+ uniform mat3 texCoordMatrix;
+ uniform vec2 outputSize;
+ uniform float bytesPerPixel;
+
+ float packedByte(float offset)
+ {
+     float pixel = floor((offset + 0.5) / bytesPerPixel);
+     float channel = offset - pixel * bytesPerPixel;
+     float row = floor((pixel + 0.5) / outputSize.x);
+     float column = pixel - row * outputSize.x;
+     vec3 texCoord = texCoordMatrix * vec3(vec2(column + 0.5, row + 0.5) / outputSize, 1.0);
+     vec3 color = texture2D(colorMap, texCoord.xy).rgb;
+
+     if (bytesPerPixel < 1.5) {
+         return dot(color, vec3(0.299, 0.587, 0.114));
+     } else if (bytesPerPixel < 2.5) {
+         vec3 bits = floor(color * vec3(31.0, 63.0, 31.0) + 0.5);
+         float greenHigh = floor(bits.g / 8.0);
+         float greenLow = bits.g - greenHigh * 8.0;
+         return (channel < 0.5 ? greenLow * 32.0 + bits.b : bits.r * 8.0 + greenHigh) / 255.0;
+     }
+     return channel < 0.5 ? color.r : (channel < 1.5 ? color.g : color.b);
+ }
+);
+
+ReadbackTarget::ReadbackTarget()
+:_outputWidth(0)
+,_outputHeight(0)
+,_outputFormat(RGBA)
+,_cropX(0.0)
+,_cropY(0.0)
+,_cropWidth(1.0)
+,_cropHeight(1.0)
+,_deferred(false)
+,_pendingFramebuffer(0)
+,_pendingWidth(0)
+,_pendingHeight(0)
+,_conversionProgram(0)
+,_positionAttribLocation(0)
+,_downscaleProgram(0)
+{
+}
+
+ReadbackTarget::~ReadbackTarget() {
+    if (_pendingFramebuffer) {
+        _pendingFramebuffer->release();
+        _pendingFramebuffer = 0;
+    }
+    if (_conversionProgram) {
+        delete _conversionProgram;
+        _conversionProgram = 0;
+    }
+    if (_downscaleProgram) {
+        delete _downscaleProgram;
+        _downscaleProgram = 0;
+    }
+}
+
+ReadbackTarget* ReadbackTarget::create(ReadbackQueue::Callback callback/* = nullptr*/) {
+    ReadbackTarget* ret = new (std::nothrow) ReadbackTarget();
+    if (ret) {
+        ret->setCallback(callback);
+    }
+    return ret;
+}
+
+int ReadbackTarget::getBytesPerPixel(Format format) {
+    switch (format) {
+        case Luminance:
+            return 1;
+        case RGB565:
+            return 2;
+        case RGB888:
+            return 3;
+        case RGBA:
+        case BGRA:
+        default:
+            return 4;
+    }
+}
+
+void ReadbackTarget::setOutputSize(int width, int height) {
+    _outputWidth = width > 0 ? width : 0;
+    _outputHeight = height > 0 ? height : 0;
+}
+
+void ReadbackTarget::setOutputFormat(Format format) {
+    if (_outputFormat != format) {
+        _outputFormat = format;
+        if (_conversionProgram) {
+            delete _conversionProgram;
+            _conversionProgram = 0;
+        }
+    }
+}
+
+void ReadbackTarget::setCropRegion(float x, float y, float width, float height) {
+    _cropX = x < 0.0 ? 0.0 : (x > 1.0 ? 1.0 : x);
+    _cropY = y < 0.0 ? 0.0 : (y > 1.0 ? 1.0 : y);
+    _cropWidth = width > 1.0 - _cropX ? 1.0 - _cropX : width;
+    _cropHeight = height > 1.0 - _cropY ? 1.0 - _cropY : height;
+    if (_cropWidth <= 0.0 || _cropHeight <= 0.0) {
+        Log("WARNING", "ReadbackTarget: empty crop region, reading the whole frame");
+        _cropX = _cropY = 0.0;
+        _cropWidth = _cropHeight = 1.0;
+    }
+}
+
+void ReadbackTarget::update(float frameTime) {
+    if (!_callback) return;
+    // deferred targets are the ones capturing
+    if (ReadbackPass::isRepeatedPass() && !_deferred) return;
+
+    int width = 0, height = 0;
+    Framebuffer* framebuffer = _prepareFramebuffer(width, height);
+    if (!framebuffer) return;
+    // the read hands its timestamp on, see ReadbackQueue::getDeliveredTimestamp()
+    framebuffer->setTimestamp(getInputTimestamp());
+
+    if (_deferred) {
+        if (_pendingFramebuffer) {
+            _pendingFramebuffer->release();
+        }
+        _pendingFramebuffer = framebuffer;
+        _pendingWidth = width;
+        _pendingHeight = height;
+        return;
+    }
+    ReadbackPass::readPacked(framebuffer, _callback, width, height);
+    // the read is ordered before any later draw into the framebuffer, it can go back to the cache right away
+    framebuffer->release();
+}
+
+bool ReadbackTarget::flush() {
+    if (!_pendingFramebuffer) return false;
+    if (_callback) {
+        ReadbackPass::readPacked(_pendingFramebuffer, _callback, _pendingWidth, _pendingHeight);
+    }
+    _pendingFramebuffer->release();
+    _pendingFramebuffer = 0;
+    return true;
+}
+
+// Returns a retained framebuffer holding the frame as it is to be read, and
+// the size of the image in it.
+Framebuffer* ReadbackTarget::_prepareFramebuffer(int& width, int& height) {
+    if (_inputFramebuffers.find(0) == _inputFramebuffers.end() || _inputFramebuffers[0].frameBuffer == 0) return 0;
+
+    Framebuffer* inputFramebuffer = _inputFramebuffers[0].frameBuffer;
+    RotationMode inputRotation = _inputFramebuffers[0].rotationMode;
+
+    int rotatedFramebufferWidth = inputFramebuffer->getWidth();
+    int rotatedFramebufferHeight = inputFramebuffer->getHeight();
+    if (rotationSwapsSize(inputRotation)) {
+        rotatedFramebufferWidth = inputFramebuffer->getHeight();
+        rotatedFramebufferHeight = inputFramebuffer->getWidth();
+    }
+    bool isCropped = (_cropX > 0.0 || _cropY > 0.0 || _cropWidth < 1.0 || _cropHeight < 1.0);
+    float regionWidth = rotatedFramebufferWidth * _cropWidth;
+    float regionHeight = rotatedFramebufferHeight * _cropHeight;
+    width = _outputWidth > 0 ? _outputWidth : (int)(regionWidth + 0.5);
+    height = _outputHeight > 0 ? _outputHeight : (int)(regionHeight + 0.5);
+    if (width <= 0 || height <= 0) return 0;
+
+    if (inputRotation == NoRotation && !isCropped && _outputFormat == RGBA && inputFramebuffer->hasFramebuffer()
+        && width == inputFramebuffer->getWidth() && height == inputFramebuffer->getHeight()) {
+        // already laid out as requested, read it where it is
+        inputFramebuffer->retain();
+        return inputFramebuffer;
+    }
+
+    // the corners of the region in the input, in the order of the output corners
+    const GLfloat* rotatedTextureCoordinates = _getTexureCoordinate(inputRotation);
+    GLfloat textureCoordinates[8];
+    for (int i = 0; i < 4; ++i) {
+        float u = _cropX + (i % 2) * _cropWidth;
+        float v = _cropY + (i / 2) * _cropHeight;
+        for (int j = 0; j < 2; ++j) {
+            textureCoordinates[i * 2 + j] = rotatedTextureCoordinates[j]
+                + u * (rotatedTextureCoordinates[2 + j] - rotatedTextureCoordinates[j])
+                + v * (rotatedTextureCoordinates[4 + j] - rotatedTextureCoordinates[j]);
+        }
+    }
+
+    Framebuffer* sourceFramebuffer = ReadbackPass::downscale(_downscaleProgram, inputFramebuffer, textureCoordinates,
+                                                             regionWidth, regionHeight, width, height);
+
+    if (!_conversionProgram && !_initConversionProgram()) {
+        sourceFramebuffer->release();
+        return 0;
+    }
+
+    Framebuffer* framebuffer = 0;
+    if (getBytesPerPixel(_outputFormat) == 4) {
+        framebuffer = Context::getInstance()->getFramebufferCache()->fetchFramebuffer(width, height);
+        ReadbackPass::draw(_conversionProgram, sourceFramebuffer, framebuffer, textureCoordinates);
+    } else {
+        framebuffer = _pack(sourceFramebuffer, textureCoordinates, width, height);
+    }
+    sourceFramebuffer->release();
+    return framebuffer;
+}
+
+// Draws the region of the input into width * height pixels of the output format,
+// packed four bytes to a texel. Returns a retained framebuffer.
+Framebuffer* ReadbackTarget::_pack(Framebuffer* inputFramebuffer, const GLfloat* textureCoordinates, int width, int height) {
+    int bytesPerPixel = getBytesPerPixel(_outputFormat);
+
+    // maps a position in the output, from 0 to 1, to the input texture
+    Matrix3 texCoordMatrix(textureCoordinates[2] - textureCoordinates[0], textureCoordinates[4] - textureCoordinates[0], textureCoordinates[0],
+                           textureCoordinates[3] - textureCoordinates[1], textureCoordinates[5] - textureCoordinates[1], textureCoordinates[1],
+                           0, 0, 1);
+
+    Framebuffer* framebuffer = ReadbackPass::fetchPackFramebuffer(width * bytesPerPixel, width * height * bytesPerPixel);
+    Context::getInstance()->setActiveShaderProgram(_conversionProgram);
+    _conversionProgram->setUniformValue("texCoordMatrix", texCoordMatrix);
+    _conversionProgram->setUniformValue("outputSize", Vector2(width, height));
+    _conversionProgram->setUniformValue("bytesPerPixel", (float)bytesPerPixel);
+    ReadbackPass::drawPack(_conversionProgram, _positionAttribLocation, inputFramebuffer, framebuffer);
+    return framebuffer;
+}
+
+bool ReadbackTarget::_initConversionProgram() {
+    if (getBytesPerPixel(_outputFormat) != 4) {
+        _conversionProgram = ReadbackPass::createPackProgram(kReadbackPackShaderString, true);
+    } else {
+        _conversionProgram = GLProgram::createByShaderString(kDefaultVertexShader,
+            _outputFormat == BGRA ? kReadbackBGRAFragmentShaderString : kDefaultFragmentShader);
+    }
+    if (!_conversionProgram) {
+        Log("ERROR", "ReadbackTarget: failed to create the conversion program");
+        return false;
+    }
+    _positionAttribLocation = _conversionProgram->getAttribLocation("position");
+    return true;
+}
+
+// same orientation as Filter, the output is a framebuffer and not the screen
+const GLfloat* ReadbackTarget::_getTexureCoordinate(RotationMode rotationMode) const {
+    static const GLfloat noRotationTextureCoordinates[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+    };
+
+    static const GLfloat rotateLeftTextureCoordinates[] = {
+        1.0f, 0.0f,
+        1.0f, 1.0f,
+        0.0f, 0.0f,
+        0.0f, 1.0f,
+    };
+
+    static const GLfloat rotateRightTextureCoordinates[] = {
+        0.0f, 1.0f,
+        0.0f, 0.0f,
+        1.0f, 1.0f,
+        1.0f, 0.0f,
+    };
+
+    static const GLfloat verticalFlipTextureCoordinates[] = {
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+    };
+
+    static const GLfloat horizontalFlipTextureCoordinates[] = {
+        1.0f, 0.0f,
+        0.0f, 0.0f,
+        1.0f, 1.0f,
+        0.0f, 1.0f,
+    };
+
+    static const GLfloat rotateRightVerticalFlipTextureCoordinates[] = {
+        0.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 0.0f,
+        1.0f, 1.0f,
+    };
+
+    static const GLfloat rotateRightHorizontalFlipTextureCoordinates[] = {
+        1.0f, 1.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        0.0f, 0.0f,
+    };
+
+    static const GLfloat rotate180TextureCoordinates[] = {
+        1.0f, 1.0f,
+        0.0f, 1.0f,
+        1.0f, 0.0f,
+        0.0f, 0.0f,
+    };
+
+    switch (rotationMode) {
+        case RotateLeft:
+            return rotateLeftTextureCoordinates;
+        case RotateRight:
+            return rotateRightTextureCoordinates;
+        case FlipVertical:
+            return verticalFlipTextureCoordinates;
+        case FlipHorizontal:
+            return horizontalFlipTextureCoordinates;
+        case RotateRightFlipVertical:
+            return rotateRightVerticalFlipTextureCoordinates;
+        case RotateRightFlipHorizontal:
+            return rotateRightHorizontalFlipTextureCoordinates;
+        case Rotate180:
+            return rotate180TextureCoordinates;
+        case NoRotation:
+        default:
+            return noRotationTextureCoordinates;
+    }
+}
+
+NS_GI_END
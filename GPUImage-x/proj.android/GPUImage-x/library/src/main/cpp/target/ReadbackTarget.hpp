@@ -0,0 +1,107 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ReadbackTarget_hpp
+#define ReadbackTarget_hpp
+
+#include "../macros.h"
+#include "Target.hpp"
+#include "../GLProgram.hpp"
+#include "../ReadbackQueue.hpp"
+
+NS_GI_BEGIN
+
+// ReadbackTarget reads back the frames it receives during the normal pass of
+// the graph, so a frame that is both displayed and recorded is only processed
+// once. Attach it next to a view, or after any filter. The reads go through
+// the context's ReadbackQueue: on GLES3 the callback runs from a later poll,
+// on GLES2 during update.
+//
+// When neither a rotation, a crop, a resize nor a format conversion is needed
+// the input framebuffer is read as it is; otherwise it is first drawn into a
+// framebuffer of the output size. Outputs less than half the size of what they
+// are taken from are reached by halving the frame a pass at a time, so every
+// input pixel counts towards the result instead of one bilinear pass skipping
+// most of them. A deferred target only prepares the frame during update and
+// reads it on flush().
+//
+// The reduced formats are packed by a shader four bytes to a texel, so only
+// width * height * getBytesPerPixel(format) bytes cross the bus. The callback
+// always receives the output width and height, the rows are tightly packed.
+class ReadbackTarget : public Target {
+public:
+    enum Format {
+        RGBA = 0,
+        BGRA,
+        Luminance,  // BT.601 luma, one byte per pixel
+        RGB888,     // three bytes per pixel
+        RGB565      // 16-bit little-endian words, red in the high bits as Android's RGB_565
+    };
+
+    static int getBytesPerPixel(Format format);
+
+    static ReadbackTarget* create(ReadbackQueue::Callback callback = nullptr);
+    ~ReadbackTarget();
+
+    // no reads are issued without a callback
+    void setCallback(ReadbackQueue::Callback callback) { _callback = callback; }
+    // 0 keeps the input size after rotation
+    void setOutputSize(int width, int height);
+    void setOutputFormat(Format format);
+    Format getOutputFormat() const { return _outputFormat; }
+    // Read only a part of the frame, in 0 to 1 of the input after rotation.
+    // The output size defaults to the size of the region.
+    void setCropRegion(float x, float y, float width, float height);
+
+    // Hold the frame until flush() instead of reading it during update, so the
+    // reads of several targets can be issued together once the frame is drawn.
+    void setDeferred(bool deferred) { _deferred = deferred; }
+    // read the held frame, false if there is none
+    bool flush();
+
+    virtual void update(float frameTime) override;
+
+protected:
+    ReadbackTarget();
+
+private:
+    ReadbackQueue::Callback _callback;
+    int _outputWidth;
+    int _outputHeight;
+    Format _outputFormat;
+    float _cropX;
+    float _cropY;
+    float _cropWidth;
+    float _cropHeight;
+    bool _deferred;
+    Framebuffer* _pendingFramebuffer;
+    int _pendingWidth;
+    int _pendingHeight;
+    GLProgram* _conversionProgram;
+    GLuint _positionAttribLocation;
+    GLProgram* _downscaleProgram;
+
+    Framebuffer* _prepareFramebuffer(int& width, int& height);
+    Framebuffer* _pack(Framebuffer* inputFramebuffer, const GLfloat* textureCoordinates, int width, int height);
+    bool _initConversionProgram();
+    const GLfloat* _getTexureCoordinate(RotationMode rotationMode) const;
+};
+
+NS_GI_END
+
+#endif /* ReadbackTarget_hpp */
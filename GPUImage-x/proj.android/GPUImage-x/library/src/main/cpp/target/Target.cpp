@@ -18,16 +18,42 @@
 
 #include "Target.hpp"
 #include "../util.h"
+#include "../Context.hpp"
+#include <deque>
+#include <vector>
 
 NS_GI_BEGIN
 
+// at most this many frames are held per synchronised input
+static const int kMaxInputSyncDepth = 8;
+
+struct Target::InputSync {
+    struct Frame {
+        InputFrameBufferInfo info;
+        // given to a set already, only ReuseLatest inputs keep such a frame
+        bool used;
+    };
+    int64_t tolerance;
+    int depth;
+    std::map<int, InputSyncRule> rules;
+    std::map<int, std::deque<Frame>> frames;
+    InputSyncStats stats;
+};
+
 Target::Target(int inputNumber/* = 1*/)
 :_inputNum(inputNumber)
+,_runCount(0)
+,_redundantRunCount(0)
+,_lastRunPassSerial(0)
+,_inputTimestamp(0)
+,_inputSync(0)
 {
 }
 
 Target::~Target()
 {
+    _clearInputSync();
+    delete _inputSync;
     for (std::map<int, InputFrameBufferInfo>::iterator it = _inputFramebuffers.begin(); it != _inputFramebuffers.end(); ++it) {
         if (it->second.frameBuffer) {
             it->second.frameBuffer->release();
@@ -43,6 +69,27 @@ void Target::setInputFramebuffer(Framebuffer* framebuffer, RotationMode rotation
     inputFrameBufferInfo.rotationMode = rotationMode;
     inputFrameBufferInfo.texIndex = texIdx;
     inputFrameBufferInfo.ignoreForPrepare = false;
+    inputFrameBufferInfo.passSource = Context::getInstance()->getPassSource();
+    inputFrameBufferInfo.passSerial = Context::getInstance()->getPassSerial();
+    if (_inputSync) {
+        // the slot stays empty until a matching set runs, see _runSynchronized
+        if (_inputFramebuffers.find(texIdx) == _inputFramebuffers.end()) {
+            _inputFramebuffers[texIdx] = inputFrameBufferInfo;
+            _inputFramebuffers[texIdx].frameBuffer = 0;
+        }
+        if (!framebuffer) return;
+        framebuffer->retain();
+        std::deque<InputSync::Frame>& frames = _inputSync->frames[texIdx];
+        frames.push_back({inputFrameBufferInfo, false});
+        while ((int)frames.size() > _inputSync->depth) {
+            if (!frames.front().used) {
+                ++_inputSync->stats.droppedCount;
+            }
+            frames.front().info.frameBuffer->release();
+            frames.pop_front();
+        }
+        return;
+    }
     if (_inputFramebuffers.find(texIdx) != _inputFramebuffers.end() && _inputFramebuffers[texIdx].frameBuffer) {
         _inputFramebuffers[texIdx].frameBuffer->release();
         _inputFramebuffers[texIdx].frameBuffer = 0;
@@ -67,7 +114,7 @@ bool Target::isPrepared() const {
     for (std::map<int, InputFrameBufferInfo>::const_iterator it = _inputFramebuffers.begin(); it != _inputFramebuffers.end(); ++it) {
         if (it->second.ignoreForPrepare)
             ignoreForPrepareNum++;
-        else if (it->second.frameBuffer)
+        else if (it->second.frameBuffer && !_isStale(it->second))
             preparedNum++;
     }
     if (ignoreForPrepareNum + preparedNum >= _inputNum)
@@ -76,6 +123,200 @@ bool Target::isPrepared() const {
         return false;
 }
 
+// An input is stale when another one came from a later pass of the same
+// source: it holds an earlier frame, e.g. of a pass that stopped before it
+// reached the other branch, and must not be joined with the newer one.
+// Inputs of different sources are joined as they are.
+bool Target::_isStale(const InputFrameBufferInfo& inputFramebufferInfo) const {
+    if (!inputFramebufferInfo.passSource) return false;
+    for (std::map<int, InputFrameBufferInfo>::const_iterator it = _inputFramebuffers.begin(); it != _inputFramebuffers.end(); ++it) {
+        if (it->second.frameBuffer && it->second.passSource == inputFramebufferInfo.passSource
+            && it->second.passSerial > inputFramebufferInfo.passSerial)
+            return true;
+    }
+    return false;
+}
+
+bool Target::runIfPrepared(float frameTime) {
+    if (_inputSync) return _runSynchronized(frameTime);
+    if (!isPrepared()) return false;
+    _run(frameTime);
+    return true;
+}
+
+void Target::_run(float frameTime) {
+    unsigned int passSerial = Context::getInstance()->getPassSerial();
+    if (_runCount > 0 && _lastRunPassSerial == passSerial && Context::getInstance()->getPassSource()) {
+        ++_redundantRunCount;
+        Context::getInstance()->addRedundantRun();
+    }
+    ++_runCount;
+    _lastRunPassSerial = passSerial;
+
+    int64_t inputTimestamp = 0;
+    for (auto const& it : _inputFramebuffers) {
+        if (it.second.frameBuffer && it.second.frameBuffer->getTimestamp() > inputTimestamp) {
+            inputTimestamp = it.second.frameBuffer->getTimestamp();
+        }
+    }
+    if (inputTimestamp > 0) {
+        _inputTimestamp = inputTimestamp;
+        frameTime = timestampToFrameTime(inputTimestamp);
+    }
+
+    update(frameTime);
+    unPrepear();
+}
+
+void Target::setInputSynchronization(bool enabled, int64_t tolerance/* = 5000000*/, int depth/* = 3*/) {
+    if (!enabled) {
+        _clearInputSync();
+        delete _inputSync;
+        _inputSync = 0;
+        return;
+    }
+    if (!_inputSync) {
+        _inputSync = new (std::nothrow) InputSync();
+        if (!_inputSync) {
+            Log("ERROR", "Target::setInputSynchronization out of memory");
+            return;
+        }
+        _inputSync->stats = {0, 0, 0, 0};
+    }
+    _inputSync->tolerance = tolerance > 0 ? tolerance : 0;
+    _inputSync->depth = depth < 1 ? 1 : (depth > kMaxInputSyncDepth ? kMaxInputSyncDepth : depth);
+}
+
+void Target::setInputSyncRule(int texIdx, InputSyncRule rule) {
+    if (!_inputSync) {
+        Log("WARNING", "Target::setInputSyncRule the inputs are not synchronised");
+        return;
+    }
+    _inputSync->rules[texIdx] = rule;
+}
+
+Target::InputSyncStats Target::getInputSyncStats() const {
+    InputSyncStats stats = {0, 0, 0, 0};
+    if (!_inputSync) return stats;
+    stats = _inputSync->stats;
+    for (auto const& it : _inputSync->frames) {
+        for (auto const& frame : it.second) {
+            if (!frame.used) ++stats.pendingCount;
+        }
+    }
+    return stats;
+}
+
+void Target::_clearInputSync() {
+    if (!_inputSync) return;
+    for (auto& it : _inputSync->frames) {
+        for (auto& frame : it.second) {
+            frame.info.frameBuffer->release();
+        }
+    }
+    _inputSync->frames.clear();
+}
+
+// The inputs to match are lined up by their oldest frames: every frame older
+// than the newest of those by more than the tolerance can no longer be part of
+// a set and goes, until the oldest frames lie within the tolerance of each
+// other or an input runs out. A set is thereby made of the earliest frames that
+// match, each frame is used once and none waits behind a frame that is lost.
+bool Target::_runSynchronized(float frameTime) {
+    std::vector<int> matchInputs;
+    std::vector<int> reuseInputs;
+    for (int i = 0; i < _inputNum; ++i) {
+        std::map<int, InputFrameBufferInfo>::const_iterator slot = _inputFramebuffers.find(i);
+        if (slot != _inputFramebuffers.end() && slot->second.ignoreForPrepare) continue;
+        std::map<int, InputSyncRule>::const_iterator rule = _inputSync->rules.find(i);
+        if (rule != _inputSync->rules.end() && rule->second == ReuseLatest) {
+            reuseInputs.push_back(i);
+        } else {
+            matchInputs.push_back(i);
+        }
+    }
+
+    int64_t setTimestamp = 0;
+    bool hasNewFrame = !matchInputs.empty();
+    for (bool isMatched = matchInputs.empty(); !isMatched; ) {
+        for (int i : matchInputs) {
+            std::deque<InputSync::Frame>& frames = _inputSync->frames[i];
+            if (frames.empty()) return false;
+            if (i == matchInputs.front() || frames.front().info.frameBuffer->getTimestamp() > setTimestamp) {
+                setTimestamp = frames.front().info.frameBuffer->getTimestamp();
+            }
+        }
+        isMatched = true;
+        for (int i : matchInputs) {
+            std::deque<InputSync::Frame>& frames = _inputSync->frames[i];
+            while (!frames.empty() && frames.front().info.frameBuffer->getTimestamp() < setTimestamp - _inputSync->tolerance) {
+                frames.front().info.frameBuffer->release();
+                frames.pop_front();
+                ++_inputSync->stats.droppedCount;
+            }
+            if (frames.empty()) return false;
+            // a later frame came up, line the inputs up again
+            if (frames.front().info.frameBuffer->getTimestamp() > setTimestamp) {
+                isMatched = false;
+            }
+        }
+    }
+
+    // the newest frame of a reused input that is not ahead of the set
+    std::map<int, int> reuseFrames;
+    for (int i : reuseInputs) {
+        std::deque<InputSync::Frame>& frames = _inputSync->frames[i];
+        if (frames.empty()) return false;
+        int index = 0;
+        for (int j = 1; j < (int)frames.size(); ++j) {
+            if (!matchInputs.empty() && frames[j].info.frameBuffer->getTimestamp() > setTimestamp + _inputSync->tolerance) break;
+            index = j;
+        }
+        reuseFrames[i] = index;
+        if (!frames[index].used) {
+            hasNewFrame = true;
+        }
+    }
+    // nothing came since the last set
+    if (!hasNewFrame) return false;
+
+    for (int i : matchInputs) {
+        std::deque<InputSync::Frame>& frames = _inputSync->frames[i];
+        if (_inputFramebuffers[i].frameBuffer) {
+            _inputFramebuffers[i].frameBuffer->release();
+        }
+        _inputFramebuffers[i] = frames.front().info;
+        frames.pop_front();
+    }
+    bool isReused = false;
+    for (int i : reuseInputs) {
+        std::deque<InputSync::Frame>& frames = _inputSync->frames[i];
+        for (int j = 0; j < reuseFrames[i]; ++j) {
+            if (!frames.front().used) {
+                ++_inputSync->stats.droppedCount;
+            }
+            frames.front().info.frameBuffer->release();
+            frames.pop_front();
+        }
+        if (frames.front().used) {
+            isReused = true;
+        }
+        frames.front().used = true;
+        if (_inputFramebuffers[i].frameBuffer) {
+            _inputFramebuffers[i].frameBuffer->release();
+        }
+        // the queue keeps its reference for the next sets
+        _inputFramebuffers[i] = frames.front().info;
+        _inputFramebuffers[i].frameBuffer->retain();
+    }
+    ++_inputSync->stats.matchedCount;
+    if (isReused) {
+        ++_inputSync->stats.reusedCount;
+    }
+    _run(frameTime);
+    return true;
+}
+
 void Target::unPrepear() {
     for (std::map<int, InputFrameBufferInfo>::iterator it = _inputFramebuffers.begin(); it != _inputFramebuffers.end(); ++it) {
         if (!it->second.ignoreForPrepare) {
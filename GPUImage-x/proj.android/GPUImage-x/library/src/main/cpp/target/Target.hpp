@@ -26,6 +26,8 @@
 
 NS_GI_BEGIN
 
+class Source;
+
 enum RotationMode {
     NoRotation = 0,
     RotateLeft,
@@ -45,7 +47,44 @@ public:
     virtual bool isPrepared() const;
     virtual void unPrepear();
     virtual void update(float frameTime) {};
+    // Whether a sink consumes frames right now, e.g. a view that is on screen.
+    // Under pull evaluation, filters with no active sink behind them are skipped.
+    virtual bool isActive() const { return true; }
+    // The join of the graph: updates the target once every input holds the
+    // frame of the current pass, then lets the inputs go. Returns true if the
+    // target was updated.
+    bool runIfPrepared(float frameTime);
+    // Timestamp of the frame the target last ran on, the newest of its inputs,
+    // see Framebuffer::getTimestamp(). update() gets it as frameTime.
+    int64_t getInputTimestamp() const { return _inputTimestamp; }
+    // times the target was updated, and how many of those repeated a pass
+    unsigned int getRunCount() const { return _runCount; }
+    unsigned int getRedundantRunCount() const { return _redundantRunCount; }
     virtual int getNextAvailableTextureIndex() const;
+    int getInputNumber() const { return _inputNum; }
+
+    // Inputs of different sources, e.g. two cameras or a camera and an overlay,
+    // are joined as they are, whatever frame each one got last. A synchronised
+    // target keeps up to depth frames per input instead and runs on a set whose
+    // timestamps lie within tolerance (ns) of each other, dropping the frames
+    // too old to match any more. An input with the ReuseLatest rule does not
+    // wait: its newest frame is given to every set until a later one comes, for
+    // an overlay slower than the rest.
+    enum InputSyncRule {
+        MatchTimestamp = 0,
+        ReuseLatest
+    };
+    struct InputSyncStats {
+        unsigned int matchedCount;
+        // frames dropped unmatched, and sets that reused a frame
+        unsigned int droppedCount;
+        unsigned int reusedCount;
+        int pendingCount;
+    };
+    virtual void setInputSynchronization(bool enabled, int64_t tolerance = 5000000, int depth = 3);
+    bool isInputSynchronized() const { return _inputSync != 0; }
+    virtual void setInputSyncRule(int texIdx, InputSyncRule rule);
+    InputSyncStats getInputSyncStats() const;
     //virtual void setInputSizeWithIdx(int width, int height, int textureIdx) {};
 protected:
     struct InputFrameBufferInfo {
@@ -53,10 +92,26 @@ protected:
         RotationMode rotationMode;
         int texIndex;
         bool ignoreForPrepare;
+        // the pass the framebuffer arrived in, no source if outside of one
+        Source* passSource;
+        unsigned int passSerial;
     };
     
     std::map<int, InputFrameBufferInfo> _inputFramebuffers;
     int _inputNum;
+
+private:
+    unsigned int _runCount;
+    unsigned int _redundantRunCount;
+    unsigned int _lastRunPassSerial;
+    int64_t _inputTimestamp;
+    struct InputSync;
+    InputSync* _inputSync;
+
+    bool _isStale(const InputFrameBufferInfo& inputFramebufferInfo) const;
+    void _run(float frameTime);
+    bool _runSynchronized(float frameTime);
+    void _clearInputSync();
 };
 
 NS_GI_END
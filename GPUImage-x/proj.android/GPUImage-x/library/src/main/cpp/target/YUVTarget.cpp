@@ -0,0 +1,171 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "YUVTarget.hpp"
+#include "ReadbackPass.hpp"
+#include "../Context.hpp"
+#include "../util.h"
+
+NS_GI_BEGIN
+
+// the bytes of the planes, packed by ReadbackPass
+const std::string kYUVTargetPackShaderString = SHADER_STRING
+(
+ uniform sampler2D colorMap;
+ uniform mat4 colorMatrix;
+ uniform mat3 texCoordMatrix;
+ uniform vec2 outputSize;
+ uniform float planar;
+
+ vec4 yuvAt(vec2 position)
+ {
+     vec3 texCoord = texCoordMatrix * vec3(position / outputSize, 1.0);
+     return colorMatrix * vec4(texture2D(colorMap, texCoord.xy).rgb, 1.0);
+ }
+
+ float packedByte(float offset)
+ {
+     float lumaSize = outputSize.x * outputSize.y;
+     if (offset < lumaSize) {
+         float row = floor((offset + 0.5) / outputSize.x);
+         float column = offset - row * outputSize.x;
+         return yuvAt(vec2(column + 0.5, row + 0.5)).x;
+     }
+     offset -= lumaSize;
+
+     float chromaWidth = outputSize.x * 0.5;
+     float chromaSize = chromaWidth * outputSize.y * 0.5;
+     float isV;
+     if (planar > 0.5) {
+         isV = step(chromaSize, offset);
+         offset -= isV * chromaSize;
+     } else {
+         float pair = floor((offset + 0.5) * 0.5);
+         isV = offset - pair * 2.0;
+         offset = pair;
+     }
+     float row = floor((offset + 0.5) / chromaWidth);
+     float column = offset - row * chromaWidth;
+     vec4 yuv = yuvAt(vec2(column * 2.0 + 1.0, row * 2.0 + 1.0));
+     return mix(yuv.y, yuv.z, isV);
+ }
+);
+
+YUVTarget::YUVTarget()
+:_layout(NV12)
+,_yuvColorSpace(BT601VideoRange)
+,_outputWidth(0)
+,_outputHeight(0)
+,_conversionProgram(0)
+,_positionAttribLocation(0)
+{
+}
+
+YUVTarget::~YUVTarget() {
+    if (_conversionProgram) {
+        delete _conversionProgram;
+        _conversionProgram = 0;
+    }
+}
+
+YUVTarget* YUVTarget::create(Layout layout/* = NV12*/, ReadbackQueue::Callback callback/* = nullptr*/) {
+    YUVTarget* ret = new (std::nothrow) YUVTarget();
+    if (ret) {
+        ret->setLayout(layout);
+        ret->setCallback(callback);
+    }
+    return ret;
+}
+
+void YUVTarget::setOutputSize(int width, int height) {
+    _outputWidth = width > 0 ? width : 0;
+    _outputHeight = height > 0 ? height : 0;
+}
+
+void YUVTarget::update(float frameTime) {
+    if (!_callback || ReadbackPass::isRepeatedPass()) return;
+    if (_inputFramebuffers.find(0) == _inputFramebuffers.end() || _inputFramebuffers[0].frameBuffer == 0) return;
+
+    Framebuffer* inputFramebuffer = _inputFramebuffers[0].frameBuffer;
+    RotationMode inputRotation = _inputFramebuffers[0].rotationMode;
+
+    int width = _outputWidth;
+    int height = _outputHeight;
+    if (width <= 0 || height <= 0) {
+        width = inputFramebuffer->getWidth();
+        height = inputFramebuffer->getHeight();
+        if (rotationSwapsSize(inputRotation)) {
+            width = inputFramebuffer->getHeight();
+            height = inputFramebuffer->getWidth();
+        }
+    }
+    // 4:2:0 chroma covers 2x2 pixels
+    width &= ~1;
+    height &= ~1;
+    if (width <= 0 || height <= 0) return;
+
+    if (!_conversionProgram && !_initConversionProgram()) return;
+
+    Framebuffer* framebuffer = ReadbackPass::fetchPackFramebuffer(width, width * height * 3 / 2);
+    framebuffer->setTimestamp(getInputTimestamp());
+    Context::getInstance()->setActiveShaderProgram(_conversionProgram);
+    _conversionProgram->setUniformValue("colorMatrix", _getColorMatrix());
+    _conversionProgram->setUniformValue("texCoordMatrix", ReadbackPass::getTexCoordMatrix(inputRotation));
+    _conversionProgram->setUniformValue("outputSize", Vector2(width, height));
+    _conversionProgram->setUniformValue("planar", _layout == I420 ? 1.0f : 0.0f);
+    ReadbackPass::drawPack(_conversionProgram, _positionAttribLocation, inputFramebuffer, framebuffer);
+
+    ReadbackPass::readPacked(framebuffer, _callback, width, height);
+    framebuffer->release();
+}
+
+bool YUVTarget::_initConversionProgram() {
+    _conversionProgram = ReadbackPass::createPackProgram(kYUVTargetPackShaderString, true);
+    if (!_conversionProgram) {
+        Log("ERROR", "YUVTarget: failed to create the conversion program");
+        return false;
+    }
+    _positionAttribLocation = _conversionProgram->getAttribLocation("position");
+    return true;
+}
+
+Matrix4 YUVTarget::_getColorMatrix() const {
+    float kr, kb;
+    if (_yuvColorSpace == BT709FullRange || _yuvColorSpace == BT709VideoRange) {
+        kr = 0.2126; kb = 0.0722;
+    } else {
+        kr = 0.299; kb = 0.114;
+    }
+    float kg = 1.0 - kr - kb;
+
+    // video range keeps luma in [16, 235] and chroma in [16, 240]
+    bool isVideoRange = (_yuvColorSpace == BT601VideoRange || _yuvColorSpace == BT709VideoRange);
+    float lumaScale = isVideoRange ? 219.0 / 255.0 : 1.0;
+    float lumaOffset = isVideoRange ? 16.0 / 255.0 : 0.0;
+    float chromaScale = isVideoRange ? 224.0 / 255.0 : 1.0;
+    float chromaOffset = 128.0 / 255.0;
+
+    float cb = chromaScale * 0.5 / (1.0 - kb);
+    float cr = chromaScale * 0.5 / (1.0 - kr);
+    return Matrix4(lumaScale * kr, lumaScale * kg, lumaScale * kb, lumaOffset,
+                   -cb * kr, -cb * kg, cb * (1.0 - kb), chromaOffset,
+                   cr * (1.0 - kr), -cr * kg, -cr * kb, chromaOffset,
+                   0.0, 0.0, 0.0, 1.0);
+}
+
+NS_GI_END
@@ -193,6 +193,7 @@
         glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
         
         [self presentFramebuffer];
+        GPUImage::Context::getInstance()->getFrameMetrics()->recordLatency(GPUImage::FrameMetrics::DisplayLatency, inputFramebuffer->getTimestamp());
     });
 }
 
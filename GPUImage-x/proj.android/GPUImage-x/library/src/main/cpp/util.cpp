@@ -17,6 +17,10 @@
  */
 
 #include "util.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
 
 #if PLATFORM == PLATFORM_ANDROID
 #include <android/log.h>
@@ -67,8 +71,23 @@ NS_GI_BEGIN
         __android_log_print(ANDROID_LOG_INFO, tag.c_str(), "%s", buffer);
 #elif PLATFORM == PLATFORM_IOS
         NSLog(@"%s", buffer);
+#else
+        fprintf(stderr, "%s: %s\n", tag.c_str(), buffer);
 #endif
         
     }
 
+    int64_t getMonotonicTimestamp() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // taken when the library is loaded, before any frame
+    static const int64_t _timeOrigin = getMonotonicTimestamp();
+
+    float timestampToFrameTime(int64_t timestamp) {
+        // relative to an origin near start-up, a float keeps sub-millisecond steps for hours
+        if (timestamp <= 0) return 0;
+        return (float)((timestamp - _timeOrigin) / 1e9);
+    }
+
 NS_GI_END
@@ -20,6 +20,7 @@
 #define util_h
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string>
 #include "macros.h"
 
@@ -28,6 +29,12 @@ NS_GI_BEGIN
     std::string str_format(const char *fmt,...);
     void Log(const std::string& tag, const std::string& format, ...);
 
+    // Nanoseconds on the monotonic clock, CLOCK_MONOTONIC on Android like
+    // System.nanoTime() and SurfaceTexture timestamps. Frames carry these.
+    int64_t getMonotonicTimestamp();
+    // a timestamp as the frameTime update() gets, seconds since the library was loaded
+    float timestampToFrameTime(int64_t timestamp);
+
 #define rotationSwapsSize(rotation) ((rotation) == GPUImage::RotateLeft || (rotation) == GPUImage::RotateRight || (rotation) == GPUImage::RotateRightFlipVertical || (rotation) == GPUImage::RotateRightFlipHorizontal)
 
 NS_GI_END
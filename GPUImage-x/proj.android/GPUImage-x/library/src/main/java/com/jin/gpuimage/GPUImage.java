@@ -22,6 +22,7 @@ import android.graphics.Bitmap;
 import android.opengl.GLSurfaceView;
 import android.graphics.PixelFormat;
 import android.os.Build;
+import java.nio.ByteBuffer;
 
 public class GPUImage {
     public static final int NoRotation = 0;
@@ -160,6 +161,9 @@ public class GPUImage {
     public static native void nativeFilterSetPropertyFloat(long classID, String property, float value);
     public static native void nativeFilterSetPropertyInt(long classID, String property, int value);
     public static native void nativeFilterSetPropertyString(long classID, String prooerty, String value);
+    public static native void nativeFilterSetInputSynchronization(long classID, boolean enabled, double toleranceMs, int depth);
+    public static native void nativeFilterSetInputSyncRule(long classID, int texIdx, int rule);
+    public static native double[] nativeFilterGetInputSyncStats(long classID);
 
     // SourceImage
     public static native long nativeSourceImageNew();
@@ -172,27 +176,89 @@ public class GPUImage {
     public static native void nativeSourceCameraDestroy(final long classID);
     public static native void nativeSourceCameraFinalize(final long classID);
     public static native void nativeSourceCameraSetFrame(final long classID, final int width, final int height, final int[] data, final int rotation);
+    public static native void nativeSourceCameraSetYUVFrame(final long classID, final int width, final int height, final byte[] data, final int yuvFormat, final int rotation);
+    public static native void nativeSourceCameraSetYUVColorSpace(final long classID, final int yuvColorSpace);
+    public static native boolean nativeSourceCameraQueueYUVFrame(final long classID, final int width, final int height, final byte[] data, final int yuvFormat, final int rotation);
+    // processes the oldest queued frame and returns how many are still waiting
+    public static native int nativeSourceCameraProcessQueuedFrame(final long classID);
+    public static native void nativeSourceCameraSetFramePolicy(final long classID, final int policy, final int capacity);
+    public static native double[] nativeSourceCameraGetFrameCounters(final long classID);
 
     // Source
     public static native long nativeSourceAddTarget(final long classID, final long targetClassID, final int texID, final boolean isFilter);
     public static native boolean nativeSourceRemoveTarget(final long classID, final long targetClassID, final boolean isFilter);
     public static native boolean nativeSourceRemoveAllTargets(final long classID);
+    public static native void nativeSourceSetGraphOptimizationEnabled(final long classID, final boolean enabled);
+    public static native void nativeSourceSetPullEvaluationEnabled(final long classID, final boolean enabled);
+    public static native void nativeSourceSetFramesInFlight(final long classID, final int depth);
+    public static native double[] nativeSourceGetFramePipelineStats(final long classID, final int depth);
     public static native boolean nativeSourceProceed(final long classID, final boolean bUpdateTargets);
     public static native int nativeSourceGetRotatedFramebuferWidth(final long classID);
     public static native int nativeSourceGetRotatedFramebuferHeight(final long classID);
     public static native byte[] nativeSourceCaptureAProcessedFrameData(final long classId, final long upToFilterClassId, final int width, final int height);
+    public static native boolean nativeSourceCaptureAProcessedFrameDataToBuffer(final long classId, final long upToFilterClassId, final int width, final int height, final ByteBuffer buffer, final int stride);
+    public static native long nativeSourceCaptureAProcessedFrameDataToPool(final long classId, final long upToFilterClassId, final int width, final int height);
+    public static native boolean nativeSourceCaptureAProcessedFrameDataAsync(final long classId, final long upToFilterClassId, final int width, final int height, final GPUImageSource.FrameDataCallback callback);
 
     // view
     public static native long nativeTargetViewNew();
     public static native void nativeTargetViewFinalize(final long classID);
     public static native void nativeTargetViewOnSizeChanged(final long classID, final int width, final int height);
     public static native void nativeTargetViewSetFillMode(final long classID, final int fillMode);
+    // readback target
+    public static native long nativeReadbackTargetNew(final GPUImageSource.FrameDataCallback callback);
+    public static native void nativeReadbackTargetFinalize(final long classID);
+    public static native void nativeReadbackTargetSetOutputSize(final long classID, final int width, final int height);
+    public static native void nativeReadbackTargetSetOutputFormat(final long classID, final int format, final GPUImageSource.FrameDataCallback callback);
+    public static native void nativeReadbackTargetSetCropRegion(final long classID, final float x, final float y, final float width, final float height);
+    // yuv target
+    public static native long nativeYUVTargetNew(final int layout, final GPUImageSource.FrameDataCallback callback);
+    public static native void nativeYUVTargetFinalize(final long classID);
+    public static native void nativeYUVTargetSetOutputSize(final long classID, final int width, final int height);
+    public static native void nativeYUVTargetSetYUVColorSpace(final long classID, final int yuvColorSpace);
+    public static native long nativeTensorTargetNew(final int width, final int height, final int dataType, final GPUImageSource.FrameDataCallback callback);
+    public static native void nativeTensorTargetFinalize(final long classID);
+    public static native void nativeTensorTargetSetOutputSize(final long classID, final int width, final int height);
+    public static native void nativeTensorTargetSetDataType(final long classID, final int dataType, final GPUImageSource.FrameDataCallback callback);
+    public static native void nativeTensorTargetSetLayout(final long classID, final int layout);
+    public static native void nativeTensorTargetSetFillMode(final long classID, final int fillMode);
+    public static native void nativeTensorTargetSetPaddingColor(final long classID, final float r, final float g, final float b);
+    public static native void nativeTensorTargetSetNormalization(final long classID, final float[] mean, final float[] std);
+    // multi capture
+    public static native long nativeMultiCaptureNew();
+    public static native void nativeMultiCaptureFinalize(final long classID);
+    public static native int nativeMultiCaptureAddCapturePoint(final long classID, final long filterClassID, final int width, final int height, final int format);
+    public static native void nativeMultiCaptureSetCapturePointCropRegion(final long classID, final int index, final float x, final float y, final float width, final float height);
+    public static native void nativeMultiCaptureRemoveAllCapturePoints(final long classID);
+    public static native boolean nativeMultiCaptureCapture(final long classID, final long sourceClassID, final GPUImageMultiCapture.MultiFrameDataCallback callback);
+    // frame data
+    public static native ByteBuffer nativeFrameDataGetBuffer(final long classID);
+    public static native int nativeFrameDataGetStride(final long classID);
+    public static native void nativeFrameDataRelease(final long classID);
     // context
     public static native void nativeContextInit();
     public static native void nativeContextDestroy();
     public static native void nativeContextPurge();
+    // delivers the finished asynchronous captures and returns how many are still in flight
+    public static native int nativeContextPollReadbacks();
+    // timestamp, on the clock of System.nanoTime(), of the frame a FrameDataCallback is handed; call it from the callback
+    public static native long nativeContextGetDeliveredTimestamp();
+    // frame metrics
+    public static native double[] nativeFrameMetricsGetStats(final int metric);
+    public static native void nativeFrameMetricsReset();
+    public static native void nativeFrameMetricsSetWindow(final double windowSeconds);
+    public static native void nativeFrameMetricsSetEnabled(final boolean enabled);
+
+    public static native void nativeQualityControllerSetFrameBudget(final double budgetMs);
+    public static native void nativeQualityControllerSetHysteresis(final int downgradeFrames, final int upgradeFrames, final double upgradeFraction);
+    public static native void nativeQualityControllerAddFramebufferScaleKnob(final long sourceClassID, final float[] scales);
+    public static native void nativeQualityControllerAddPropertyKnob(final long filterClassID, final String property, final float[] values);
+    public static native void nativeQualityControllerRemoveAllKnobs();
+    public static native double[] nativeQualityControllerGetStats();
 
     // utils
     public static native void nativeYUVtoRBGA(byte[] yuv, int width, int height, int[] out);
+    // converts a synthetic frame, checks it against the scalar reference and returns ms per frame, -1 on mismatch
+    public static native float nativeYUVConverterBenchmark(int width, int height, int yuvFormat, int iterations);
 
 }
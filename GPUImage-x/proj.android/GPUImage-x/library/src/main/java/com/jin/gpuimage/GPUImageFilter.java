@@ -77,6 +77,55 @@ public class GPUImageFilter extends GPUImageSource implements GPUImageTarget {
         });
     }
 
+    // rules of setInputSyncRule
+    public static final int SYNC_MATCH_TIMESTAMP = 0;
+    public static final int SYNC_REUSE_LATEST = 1;
+
+    // Join the inputs of a multi-input filter fed by several sources by their
+    // frame timestamps: each input keeps up to depth frames and the filter runs
+    // on frames that lie within toleranceMs of each other.
+    public void setInputSynchronization(final boolean enabled, final double toleranceMs, final int depth) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeFilterSetInputSynchronization(mNativeClassID, enabled, toleranceMs, depth);
+                }
+            }
+        });
+    }
+
+    public void setInputSyncRule(final int texIdx, final int rule) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeFilterSetInputSyncRule(mNativeClassID, texIdx, rule);
+                }
+            }
+        });
+    }
+
+    // to be called on the draw thread, e.g. from a runOnDraw Runnable
+    public InputSyncStats getInputSyncStats() {
+        if (mNativeClassID == 0) return null;
+        return new InputSyncStats(GPUImage.nativeFilterGetInputSyncStats(mNativeClassID));
+    }
+
+    public static class InputSyncStats {
+        public final long matchedCount;
+        public final long droppedCount;
+        public final long reusedCount;
+        public final int pendingCount;
+
+        InputSyncStats(double[] values) {
+            matchedCount = (long) values[0];
+            droppedCount = (long) values[1];
+            reusedCount = (long) values[2];
+            pendingCount = (int) values[3];
+        }
+    }
+
     public void destroy() {
         destroy(true);
     }
@@ -0,0 +1,61 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.jin.gpuimage;
+
+import java.nio.ByteBuffer;
+
+// A captured frame, RGBA rows getStride() bytes apart. Frames taken from the
+// native pool have to be given back with release(), frames captured into a
+// caller's buffer only wrap it.
+public class GPUImageFrameData {
+    private long mNativeClassID = 0;
+    private ByteBuffer mBuffer;
+    private final int mWidth;
+    private final int mHeight;
+    private final int mStride;
+
+    GPUImageFrameData(ByteBuffer buffer, int width, int height, int stride) {
+        mBuffer = buffer;
+        mWidth = width;
+        mHeight = height;
+        mStride = stride;
+    }
+
+    GPUImageFrameData(long nativeClassID, int width, int height) {
+        mNativeClassID = nativeClassID;
+        mBuffer = GPUImage.nativeFrameDataGetBuffer(nativeClassID);
+        mWidth = width;
+        mHeight = height;
+        mStride = GPUImage.nativeFrameDataGetStride(nativeClassID);
+    }
+
+    public ByteBuffer getBuffer() { return mBuffer; }
+    public int getWidth() { return mWidth; }
+    public int getHeight() { return mHeight; }
+    public int getStride() { return mStride; }
+
+    // hands pooled memory back for the next capture, the buffer must not be used afterwards
+    public void release() {
+        if (mNativeClassID != 0) {
+            GPUImage.nativeFrameDataRelease(mNativeClassID);
+            mNativeClassID = 0;
+            mBuffer = null;
+        }
+    }
+}
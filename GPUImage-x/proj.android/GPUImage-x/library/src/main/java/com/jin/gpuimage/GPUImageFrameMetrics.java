@@ -0,0 +1,70 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.jin.gpuimage;
+
+// Rolling latency and frame pacing histograms of the library context, covering
+// the last one to two windows (10 seconds by default). Latencies run from the
+// time a frame was taken at its source; the values are in milliseconds.
+public class GPUImageFrameMetrics {
+    // to the end of the pass that processed the frame
+    public static final int ProcessingLatency = 0;
+    // to the frame being drawn into a view
+    public static final int DisplayLatency = 1;
+    // to the frame being handed to a capture or readback callback
+    public static final int CaptureLatency = 2;
+    // between the ends of consecutive passes
+    public static final int FrameInterval = 3;
+    // between consecutive frame intervals
+    public static final int FrameJitter = 4;
+    // from the upload of a frame to the end of its pass, waiting for the GPU included
+    public static final int FrameTime = 5;
+
+    public final long count;
+    public final double p50;
+    public final double p95;
+    public final double p99;
+    public final double max;
+    public final double mean;
+
+    private GPUImageFrameMetrics(double[] values) {
+        count = (long) values[0];
+        p50 = values[1];
+        p95 = values[2];
+        p99 = values[3];
+        max = values[4];
+        mean = values[5];
+    }
+
+    // may be called on any thread
+    public static GPUImageFrameMetrics get(int metric) {
+        return new GPUImageFrameMetrics(GPUImage.nativeFrameMetricsGetStats(metric));
+    }
+
+    public static void reset() {
+        GPUImage.nativeFrameMetricsReset();
+    }
+
+    public static void setWindow(double windowSeconds) {
+        GPUImage.nativeFrameMetricsSetWindow(windowSeconds);
+    }
+
+    public static void setEnabled(boolean enabled) {
+        GPUImage.nativeFrameMetricsSetEnabled(enabled);
+    }
+}
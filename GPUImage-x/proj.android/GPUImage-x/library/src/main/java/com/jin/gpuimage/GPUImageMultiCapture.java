@@ -0,0 +1,109 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.jin.gpuimage;
+
+// Captures the outputs of several filters from a single run of the graph.
+// Results arrive on the GL thread in the order the points were added, on
+// GLES3 devices with one of the following frames.
+public class GPUImageMultiCapture {
+    protected long mNativeClassID = 0;
+
+    public GPUImageMultiCapture() {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                mNativeClassID = GPUImage.nativeMultiCaptureNew();
+            }
+        });
+    }
+
+    // width and height of 0 keep the size of the filter output, format is one of GPUImageReadbackTarget.FORMAT_*
+    public void addCapturePoint(final GPUImageFilter filter, final int width, final int height, final int format) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeMultiCaptureAddCapturePoint(mNativeClassID, filter.getNativeClassID(), width, height, format);
+                }
+            }
+        });
+    }
+
+    // index is the position of the capture point in the order it was added,
+    // the region is in 0 to 1 of the filter output
+    public void setCapturePointCropRegion(final int index, final float x, final float y, final float width, final float height) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeMultiCaptureSetCapturePointCropRegion(mNativeClassID, index, x, y, width, height);
+                }
+            }
+        });
+    }
+
+    public void removeAllCapturePoints() {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeMultiCaptureRemoveAllCapturePoints(mNativeClassID);
+                }
+            }
+        });
+    }
+
+    public void capture(final GPUImageSource source, final MultiFrameDataCallback callback) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0 && source.getNativeClassID() != 0) {
+                    GPUImage.nativeMultiCaptureCapture(mNativeClassID, source.getNativeClassID(), callback);
+                }
+            }
+        });
+        GPUImage.getInstance().requestRender();
+    }
+
+    public void destroy() {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeMultiCaptureFinalize(mNativeClassID);
+                    mNativeClassID = 0;
+                }
+            }
+        });
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        try {
+            destroy();
+        } finally {
+            super.finalize();
+        }
+    }
+
+    // pointIndex is the position of the capture point in the order it was added
+    public interface MultiFrameDataCallback {
+        void onResult(int pointIndex, byte[] data, int width, int height);
+    }
+}
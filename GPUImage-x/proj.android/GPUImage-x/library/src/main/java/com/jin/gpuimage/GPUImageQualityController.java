@@ -0,0 +1,98 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.jin.gpuimage;
+
+// Holds the frames of the library context to a time budget by stepping
+// registered quality knobs down when frames take too long and back up once
+// they have been fast for a while. Knobs are given up in the order they are
+// added, the first value of each is its full quality.
+public class GPUImageQualityController {
+    public final double budgetMs;
+    // the smoothed time of a frame from its upload, waiting for the GPU included
+    public final double frameTimeMs;
+    // steps down from the full quality, of maxLevel
+    public final int level;
+    public final int maxLevel;
+    public final long downgradeCount;
+    public final long upgradeCount;
+
+    private GPUImageQualityController(double[] values) {
+        budgetMs = values[0];
+        frameTimeMs = values[1];
+        level = (int) values[2];
+        maxLevel = (int) values[3];
+        downgradeCount = (long) values[4];
+        upgradeCount = (long) values[5];
+    }
+
+    // may be called on any thread
+    public static GPUImageQualityController getStats() {
+        return new GPUImageQualityController(GPUImage.nativeQualityControllerGetStats());
+    }
+
+    // 0 stops the controller and restores the full quality
+    public static void setFrameBudget(final double budgetMs) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                GPUImage.nativeQualityControllerSetFrameBudget(budgetMs);
+            }
+        });
+    }
+
+    public static void setHysteresis(final int downgradeFrames, final int upgradeFrames, final double upgradeFraction) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                GPUImage.nativeQualityControllerSetHysteresis(downgradeFrames, upgradeFrames, upgradeFraction);
+            }
+        });
+    }
+
+    public static void addFramebufferScaleKnob(final GPUImageSource source, final float[] scales) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (source.getNativeClassID() != 0) {
+                    GPUImage.nativeQualityControllerAddFramebufferScaleKnob(source.getNativeClassID(), scales);
+                }
+            }
+        });
+    }
+
+    public static void addPropertyKnob(final GPUImageFilter filter, final String property, final float[] values) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (filter.getNativeClassID() != 0) {
+                    GPUImage.nativeQualityControllerAddPropertyKnob(filter.getNativeClassID(), property, values);
+                }
+            }
+        });
+    }
+
+    public static void removeAllKnobs() {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                GPUImage.nativeQualityControllerRemoveAllKnobs();
+            }
+        });
+    }
+}
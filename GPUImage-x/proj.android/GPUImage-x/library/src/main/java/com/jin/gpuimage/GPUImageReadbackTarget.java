@@ -0,0 +1,103 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.jin.gpuimage;
+
+// Reads back the frames it receives while the graph renders, e.g. to record
+// what is being previewed without processing every frame a second time.
+// Frames arrive on the GL thread as tightly packed rows of the output format,
+// on GLES3 devices a frame or two after they were drawn.
+public class GPUImageReadbackTarget implements GPUImageTarget {
+    public static final int FORMAT_RGBA = 0;
+    public static final int FORMAT_BGRA = 1;
+    public static final int FORMAT_LUMINANCE = 2;
+    public static final int FORMAT_RGB888 = 3;
+    // little-endian 16-bit words as Bitmap.Config.RGB_565 stores them
+    public static final int FORMAT_RGB565 = 4;
+
+    protected long mNativeClassID = 0;
+    private final GPUImageSource.FrameDataCallback mCallback;
+
+    public GPUImageReadbackTarget(final GPUImageSource.FrameDataCallback callback) {
+        mCallback = callback;
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                mNativeClassID = GPUImage.nativeReadbackTargetNew(callback);
+            }
+        });
+    }
+
+    public long getNativeClassID() { return mNativeClassID; }
+
+    // 0 keeps the size of the frames it receives
+    public void setOutputSize(final int width, final int height) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeReadbackTargetSetOutputSize(mNativeClassID, width, height);
+                }
+            }
+        });
+    }
+
+    public void setOutputFormat(final int format) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeReadbackTargetSetOutputFormat(mNativeClassID, format, mCallback);
+                }
+            }
+        });
+    }
+
+    // the region is in 0 to 1 of the frames received, the output size defaults to its size
+    public void setCropRegion(final float x, final float y, final float width, final float height) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeReadbackTargetSetCropRegion(mNativeClassID, x, y, width, height);
+                }
+            }
+        });
+    }
+
+    public void destroy() {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeReadbackTargetFinalize(mNativeClassID);
+                    mNativeClassID = 0;
+                }
+            }
+        });
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        try {
+            destroy();
+        } finally {
+            super.finalize();
+        }
+    }
+}
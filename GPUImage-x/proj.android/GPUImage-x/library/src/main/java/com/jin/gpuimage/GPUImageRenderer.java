@@ -58,6 +58,10 @@ public class GPUImageRenderer implements Renderer{
         runAll(mPreDrawQueue);
         runAll(mDrawQueue);
         runAll(mPostDrawQueue);
+        // keep rendering until the asynchronous captures have been delivered
+        if (GPUImage.nativeContextPollReadbacks() > 0) {
+            GPUImage.getInstance().requestRender();
+        }
     }
 
     private void runAll(Queue<Runnable> queue) {
@@ -64,6 +64,46 @@ public abstract class GPUImageSource {
         });
     }
 
+    // compute filters of the same type, parameters and inputs only once per frame
+    public final void setGraphOptimizationEnabled(final boolean enabled) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0)
+                    GPUImage.nativeSourceSetGraphOptimizationEnabled(mNativeClassID, enabled);
+            }
+        });
+    }
+
+    // only update filters that lead to a visible view or a pending capture
+    public final void setPullEvaluationEnabled(final boolean enabled) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0)
+                    GPUImage.nativeSourceSetPullEvaluationEnabled(mNativeClassID, enabled);
+            }
+        });
+    }
+
+    // Let up to depth frames, 1 to 3, be in flight on the GPU, 0 turns it off.
+    public final void setFramesInFlight(final int depth) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0)
+                    GPUImage.nativeSourceSetFramesInFlight(mNativeClassID, depth);
+            }
+        });
+    }
+
+    // stats of the frames run at depth, 0 for the current one; null while pipelining is off
+    public FramePipelineStats getFramePipelineStats(final int depth) {
+        if (mNativeClassID == 0) return null;
+        double[] values = GPUImage.nativeSourceGetFramePipelineStats(mNativeClassID, depth);
+        return values == null ? null : new FramePipelineStats(values);
+    }
+
     public void proceed() {
         proceed(true, true);
     }
@@ -110,7 +150,93 @@ public abstract class GPUImageSource {
         GPUImage.getInstance().requestRender();
     }
 
+    // Capture into a direct buffer owned by the caller, rows stride bytes apart (0 for width * 4).
+    public void captureAProcessedFrameData(final GPUImageFilter upToFilter, final int width, final int height, final ByteBuffer buffer, final int stride, final ProcessedFrameBufferCallback proceedResult) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    if (GPUImage.nativeSourceCaptureAProcessedFrameDataToBuffer(mNativeClassID, upToFilter.getNativeClassID(), width, height, buffer, stride)) {
+                        proceedResult.onResult(new GPUImageFrameData(buffer, width, height, stride > 0 ? stride : width * 4));
+                    }
+                }
+            }
+        });
+        GPUImage.getInstance().requestRender();
+    }
+
+    // Capture into recycled native memory, release() the frame data once done with it.
+    public void captureAProcessedFrameDataToPool(final GPUImageFilter upToFilter, final int width, final int height, final ProcessedFrameBufferCallback proceedResult) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    long frameData = GPUImage.nativeSourceCaptureAProcessedFrameDataToPool(mNativeClassID, upToFilter.getNativeClassID(), width, height);
+                    if (frameData != 0) {
+                        proceedResult.onResult(new GPUImageFrameData(frameData, width, height));
+                    }
+                }
+            }
+        });
+        GPUImage.getInstance().requestRender();
+    }
+
+    public void captureAProcessedFrameDataAsync(final GPUImageFilter upToFilter, final ProcessedFrameDataCallback proceedResult) {
+        captureAProcessedFrameDataAsync(upToFilter, getRotatedFramebufferWidth(), getRotatedFramebufferHeight(), proceedResult);
+    }
+
+    // Does not stall the GL thread for the read back; on GLES3 devices the result
+    // arrives with one of the following frames, on GLES2 devices right away.
+    public void captureAProcessedFrameDataAsync(final GPUImageFilter upToFilter, final int width, final int height, final ProcessedFrameDataCallback proceedResult) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeSourceCaptureAProcessedFrameDataAsync(mNativeClassID, upToFilter.getNativeClassID(), width, height, new FrameDataCallback() {
+                        @Override
+                        public void onResult(byte[] data, int width, int height) {
+                            Bitmap bmp = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888);
+                            bmp.copyPixelsFromBuffer(ByteBuffer.wrap(data));
+                            proceedResult.onResult(bmp);
+                        }
+                    });
+                }
+            }
+        });
+        GPUImage.getInstance().requestRender();
+    }
+
     public interface ProcessedFrameDataCallback{
         void onResult(Bitmap result);
     }
+
+    public interface ProcessedFrameBufferCallback{
+        void onResult(GPUImageFrameData frameData);
+    }
+
+    public static class FramePipelineStats {
+        public final int depth;
+        public final int frameCount;
+        public final double averageLatencyMs;
+        public final double averageStallMs;
+        public final double framesPerSecond;
+        // against depth 1, both 0 until depth 1 has been measured
+        public final double addedLatencyMs;
+        public final double throughputGain;
+
+        FramePipelineStats(double[] values) {
+            depth = (int) values[0];
+            frameCount = (int) values[1];
+            averageLatencyMs = values[2];
+            averageStallMs = values[3];
+            framesPerSecond = values[4];
+            addedLatencyMs = values[5];
+            throughputGain = values[6];
+        }
+    }
+
+    // called from native code with the RGBA rows of a captured frame
+    public interface FrameDataCallback{
+        void onResult(byte[] data, int width, int height);
+    }
 }
@@ -27,16 +27,41 @@ import android.os.Build;
 import android.view.Surface;
 import android.view.WindowManager;
 import java.io.IOException;
-import java.nio.IntBuffer;
+import java.util.concurrent.atomic.AtomicBoolean;
 
 
 public class GPUImageSourceCamera extends GPUImageSource implements Camera.PreviewCallback {
+    // yuv formats
+    public static final int NV21 = 0;
+    public static final int NV12 = 1;
+    public static final int I420 = 2;
+
+    // yuv color spaces
+    public static final int BT601FullRange = 0;
+    public static final int BT601VideoRange = 1;
+    public static final int BT709FullRange = 2;
+    public static final int BT709VideoRange = 3;
+
+    // frame policies, what happens to preview frames while processing falls behind
+    public static final int LatestFrameWins = 0;
+    public static final int BoundedQueue = 1;
+    public static final int Block = 2;
+
     private Camera mCamera;
     private int mCurrentCameraId = 0;
-    private IntBuffer mRGBABuffer;
     private int mRotation = GPUImage.NoRotation;
     private Context mContext;
     private SurfaceTexture mSurfaceTexture = null;
+    private final AtomicBoolean mIsProcessPosted = new AtomicBoolean(false);
+    private final Runnable mProcessQueuedFrame = new Runnable() {
+        @Override
+        public void run() {
+            mIsProcessPosted.set(false);
+            if (mNativeClassID != 0 && GPUImage.nativeSourceCameraProcessQueuedFrame(mNativeClassID) > 0) {
+                postProcessQueuedFrame();
+            }
+        }
+    };
 
     public GPUImageSourceCamera(Context context) {
         mContext = context;
@@ -52,21 +77,69 @@ public class GPUImageSourceCamera extends GPUImageSource implements Camera.Previ
     @Override
     public void onPreviewFrame(final byte[] data, Camera camera) {
         final Camera.Size previewSize = camera.getParameters().getPreviewSize();
-        if (mRGBABuffer == null) {
-            mRGBABuffer = IntBuffer.allocate(previewSize.width * previewSize.height);
+        if (mNativeClassID != 0) {
+            // copied into the native frame queue, which drops or holds it by the
+            // frame policy; the NV21 frame is converted to RGBA on the GPU later
+            GPUImage.nativeSourceCameraQueueYUVFrame(mNativeClassID, previewSize.width, previewSize.height, data, NV21, mRotation);
         }
-        final Camera cam = camera;
+        camera.addCallbackBuffer(data);
+        postProcessQueuedFrame();
+    }
+
+    // at most one draw is posted at a time, it takes whatever is queued by then
+    private void postProcessQueuedFrame() {
+        if (!mIsProcessPosted.getAndSet(true)) {
+            GPUImage.getInstance().runOnDraw(mProcessQueuedFrame);
+            GPUImage.getInstance().requestRender();
+        }
+    }
+
+    // Set what happens to preview frames while the filters are slower than the
+    // camera: LatestFrameWins keeps only the newest, BoundedQueue keeps up to
+    // capacity and drops the oldest, Block holds the camera thread until there is room.
+    public void setFramePolicy(final int policy, final int capacity) {
         GPUImage.getInstance().runOnDraw(new Runnable() {
             @Override
             public void run() {
-                if (mNativeClassID != 0) {
-                    GPUImage.nativeYUVtoRBGA(data, previewSize.width, previewSize.height, mRGBABuffer.array());
-                    cam.addCallbackBuffer(data);
-                    GPUImage.nativeSourceCameraSetFrame(mNativeClassID, previewSize.width, previewSize.height, mRGBABuffer.array(), mRotation);
-                }
+                if (mNativeClassID != 0)
+                    GPUImage.nativeSourceCameraSetFramePolicy(mNativeClassID, policy, capacity);
+            }
+        });
+    }
+
+    // null until the native camera source exists
+    public FrameCounters getFrameCounters() {
+        if (mNativeClassID == 0) return null;
+        return new FrameCounters(GPUImage.nativeSourceCameraGetFrameCounters(mNativeClassID));
+    }
+
+    public static class FrameCounters {
+        public final long queuedCount;
+        public final long droppedCount;
+        public final long processedCount;
+        public final int pendingCount;
+        // from the preview callback to the end of processing
+        public final double averageLatencyMs;
+        public final double maxLatencyMs;
+
+        FrameCounters(double[] values) {
+            queuedCount = (long) values[0];
+            droppedCount = (long) values[1];
+            processedCount = (long) values[2];
+            pendingCount = (int) values[3];
+            averageLatencyMs = values[4];
+            maxLatencyMs = values[5];
+        }
+    }
+
+    public void setYUVColorSpace(final int yuvColorSpace) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0)
+                    GPUImage.nativeSourceCameraSetYUVColorSpace(mNativeClassID, yuvColorSpace);
             }
         });
-        proceed(true, true);
     }
 
     public void onResume() {
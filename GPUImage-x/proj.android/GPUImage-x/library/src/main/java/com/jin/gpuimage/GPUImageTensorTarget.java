@@ -0,0 +1,144 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.jin.gpuimage;
+
+// Turns the frames it receives into the input tensor of a model: resized or
+// letterboxed, normalized as (x - mean) / std with x from 0 to 1, and laid out
+// as NCHW or NHWC uint8, float16 or float32 in little-endian order. Tensors
+// arrive on the GL thread as width * height * 3 elements, on GLES3 devices a
+// frame or two after they were drawn.
+public class GPUImageTensorTarget implements GPUImageTarget {
+    // layouts
+    public static final int NCHW = 0;
+    public static final int NHWC = 1;
+
+    // data types
+    public static final int UINT8 = 0;
+    public static final int FLOAT16 = 1;
+    public static final int FLOAT32 = 2;
+
+    // fill modes
+    public static final int STRETCH = 0;
+    public static final int LETTERBOX = 1;
+    public static final int CENTER_CROP = 2;
+
+    protected long mNativeClassID = 0;
+    private final GPUImageSource.FrameDataCallback mCallback;
+
+    public GPUImageTensorTarget(final int width, final int height, final int dataType, final GPUImageSource.FrameDataCallback callback) {
+        mCallback = callback;
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                mNativeClassID = GPUImage.nativeTensorTargetNew(width, height, dataType, callback);
+            }
+        });
+    }
+
+    public long getNativeClassID() { return mNativeClassID; }
+
+    public void setOutputSize(final int width, final int height) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeTensorTargetSetOutputSize(mNativeClassID, width, height);
+                }
+            }
+        });
+    }
+
+    public void setDataType(final int dataType) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeTensorTargetSetDataType(mNativeClassID, dataType, mCallback);
+                }
+            }
+        });
+    }
+
+    public void setLayout(final int layout) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeTensorTargetSetLayout(mNativeClassID, layout);
+                }
+            }
+        });
+    }
+
+    public void setFillMode(final int fillMode) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeTensorTargetSetFillMode(mNativeClassID, fillMode);
+                }
+            }
+        });
+    }
+
+    // the color of the letterbox bars, from 0 to 1 before normalization
+    public void setPaddingColor(final float r, final float g, final float b) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeTensorTargetSetPaddingColor(mNativeClassID, r, g, b);
+                }
+            }
+        });
+    }
+
+    // per channel in R, G, B order, e.g. {0.485f, 0.456f, 0.406f} and {0.229f, 0.224f, 0.225f}
+    public void setNormalization(final float[] mean, final float[] std) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeTensorTargetSetNormalization(mNativeClassID, mean, std);
+                }
+            }
+        });
+    }
+
+    public void destroy() {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeTensorTargetFinalize(mNativeClassID);
+                    mNativeClassID = 0;
+                }
+            }
+        });
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        try {
+            destroy();
+        } finally {
+            super.finalize();
+        }
+    }
+}
@@ -136,6 +136,8 @@ public class GPUImageView extends FrameLayout implements GPUImageTarget {
         @Override
         public void surfaceDestroyed(SurfaceHolder holder) {
             super.surfaceDestroyed(holder);
+            // nothing is shown until the surface is back, see Target::isActive
+            host.onSurfaceSizeChanged(0, 0);
         }
     }
 
@@ -0,0 +1,91 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.jin.gpuimage;
+
+// Converts the frames it receives to NV12 or I420 on the GPU for an encoder.
+// Frames arrive on the GL thread as width * height * 3 / 2 bytes of planes,
+// on GLES3 devices a frame or two after they were drawn.
+public class GPUImageYUVTarget implements GPUImageTarget {
+    // layouts
+    public static final int NV12 = 0;
+    public static final int I420 = 1;
+
+    // yuv color spaces
+    public static final int BT601FullRange = 0;
+    public static final int BT601VideoRange = 1;
+    public static final int BT709FullRange = 2;
+    public static final int BT709VideoRange = 3;
+
+    protected long mNativeClassID = 0;
+
+    public GPUImageYUVTarget(final int layout, final GPUImageSource.FrameDataCallback callback) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                mNativeClassID = GPUImage.nativeYUVTargetNew(layout, callback);
+            }
+        });
+    }
+
+    public long getNativeClassID() { return mNativeClassID; }
+
+    // 0 keeps the size of the frames it receives, odd sizes are rounded down
+    public void setOutputSize(final int width, final int height) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeYUVTargetSetOutputSize(mNativeClassID, width, height);
+                }
+            }
+        });
+    }
+
+    public void setYUVColorSpace(final int yuvColorSpace) {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeYUVTargetSetYUVColorSpace(mNativeClassID, yuvColorSpace);
+                }
+            }
+        });
+    }
+
+    public void destroy() {
+        GPUImage.getInstance().runOnDraw(new Runnable() {
+            @Override
+            public void run() {
+                if (mNativeClassID != 0) {
+                    GPUImage.nativeYUVTargetFinalize(mNativeClassID);
+                    mNativeClassID = 0;
+                }
+            }
+        });
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        try {
+            destroy();
+        } finally {
+            super.finalize();
+        }
+    }
+}
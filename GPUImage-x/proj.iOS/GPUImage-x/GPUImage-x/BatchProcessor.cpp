@@ -0,0 +1,249 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BatchProcessor.hpp"
+#include "RenderThread.hpp"
+#include "util.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+NS_GI_BEGIN
+
+BatchProcessor::BatchProcessor()
+:_images(0)
+,_activeWorkerCount(0)
+,_stealCount(0)
+{
+    _stats.imageCount = 0;
+    _stats.seconds = 0;
+    _stats.imagesPerSecond = 0;
+    _stats.stealCount = 0;
+}
+
+BatchProcessor::~BatchProcessor() {
+    for (auto const& worker : _workers) {
+        if (worker->context->getRenderThread() && worker->context->getRenderThread()->isRunning()) {
+            worker->context->runSync([worker]() {
+                // the graph goes with the input, its edges hold the filters
+                if (worker->input) worker->input->release();
+                if (worker->output) worker->output->release();
+            });
+        }
+        delete worker->context;
+        delete worker;
+    }
+    _workers.clear();
+}
+
+BatchProcessor* BatchProcessor::create(PipelineBuilder builder, int workerCount/* = 0*/) {
+    BatchProcessor* ret = new (std::nothrow) BatchProcessor();
+    if (ret && !ret->_init(builder, workerCount)) {
+        delete ret;
+        ret = 0;
+    }
+    return ret;
+}
+
+bool BatchProcessor::_init(PipelineBuilder builder, int workerCount) {
+    if (!builder) {
+        Log("ERROR", "BatchProcessor: no pipeline builder");
+        return false;
+    }
+    if (workerCount <= 0) {
+        workerCount = (int)std::thread::hardware_concurrency();
+        if (workerCount <= 0) workerCount = 1;
+    }
+
+    for (int i = 0; i < workerCount; ++i) {
+        Worker* worker = new Worker();
+        worker->context = new Context();
+        worker->input = 0;
+        worker->output = 0;
+        worker->result = 0;
+        worker->busySeconds = 0;
+        worker->imageCount = 0;
+        _workers.push_back(worker);
+
+        if (!worker->context->startRenderThread()) {
+            Log("ERROR", "BatchProcessor: worker %d has no GL context", i);
+            return false;
+        }
+        bool isBuilt = false;
+        worker->context->runSync([worker, &builder, &isBuilt]() {
+            worker->input = new (std::nothrow) SourceImage();
+            worker->output = ReadbackTarget::create([worker](const unsigned char* pixels, int width, int height) {
+                if (!worker->result) return;
+                worker->result->width = width;
+                worker->result->height = height;
+                worker->result->pixels.assign(pixels, pixels + width * height * 4);
+            });
+            isBuilt = worker->input && worker->output && builder(worker->input, worker->output);
+        });
+        if (!isBuilt) {
+            Log("ERROR", "BatchProcessor: building the pipeline of worker %d failed", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BatchProcessor::process(const std::vector<Image>& images, std::vector<Image>& results) {
+    results.clear();
+    results.resize(images.size());
+    return process(images, [&results](int index, Image& result) {
+        results[index] = std::move(result);
+    });
+}
+
+bool BatchProcessor::process(const std::vector<Image>& images, ResultCallback callback) {
+    int imageCount = (int)images.size();
+    int workerCount = (int)_workers.size();
+
+    _images = &images;
+    _results.clear();
+    _results.resize(imageCount);
+    _isReady.assign(imageCount, 0);
+    _stealCount = 0;
+    // dealt out in turn, so the workers start on the first images together
+    for (int i = 0; i < imageCount; ++i) {
+        _workers[i % workerCount]->jobs.push_back(i);
+    }
+    for (auto const& worker : _workers) {
+        worker->busySeconds = 0;
+        worker->imageCount = 0;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    _activeWorkerCount = workerCount;
+    for (int i = 0; i < workerCount; ++i) {
+        _workers[i]->context->runAsync([this, i]() { _work(i); });
+    }
+
+    bool isSucceeded = true;
+    for (int i = 0; i < imageCount; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(_resultsMutex);
+            _resultReady.wait(lock, [this, i]() { return _isReady[i] != 0; });
+        }
+        Image& result = _results[i];
+        if (result.pixels.empty()) {
+            isSucceeded = false;
+        }
+        if (callback) {
+            callback(i, result);
+        }
+        // handed over, do not hold the memory for the rest of the batch
+        std::vector<unsigned char>().swap(result.pixels);
+    }
+    {
+        std::unique_lock<std::mutex> lock(_resultsMutex);
+        _resultReady.wait(lock, [this]() { return _activeWorkerCount == 0; });
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    _stats.imageCount = imageCount;
+    _stats.seconds = seconds;
+    _stats.imagesPerSecond = seconds > 0 ? imageCount / seconds : 0;
+    _stats.stealCount = _stealCount;
+    _stats.workerImageCounts.clear();
+    _stats.workerUtilization.clear();
+    for (auto const& worker : _workers) {
+        _stats.workerImageCounts.push_back(worker->imageCount);
+        _stats.workerUtilization.push_back(seconds > 0 ? std::min(1.0, worker->busySeconds / seconds) : 0);
+    }
+
+    _images = 0;
+    _results.clear();
+    _isReady.clear();
+    return isSucceeded;
+}
+
+bool BatchProcessor::_takeJob(int workerIndex, int& job) {
+    Worker* worker = _workers[workerIndex];
+    {
+        std::lock_guard<std::mutex> lock(worker->jobsMutex);
+        if (!worker->jobs.empty()) {
+            job = worker->jobs.front();
+            worker->jobs.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the back of the fullest queue, the images furthest from
+    // being handed back. Queues only shrink during a batch, so an empty
+    // look everywhere means the batch is done.
+    for (;;) {
+        Worker* victim = 0;
+        size_t victimSize = 0;
+        for (auto const& other : _workers) {
+            if (other == worker) continue;
+            std::lock_guard<std::mutex> lock(other->jobsMutex);
+            if (other->jobs.size() > victimSize) {
+                victim = other;
+                victimSize = other->jobs.size();
+            }
+        }
+        if (!victim) return false;
+
+        std::lock_guard<std::mutex> lock(victim->jobsMutex);
+        if (!victim->jobs.empty()) {
+            job = victim->jobs.back();
+            victim->jobs.pop_back();
+            std::lock_guard<std::mutex> resultsLock(_resultsMutex);
+            ++_stealCount;
+            return true;
+        }
+    }
+}
+
+void BatchProcessor::_work(int workerIndex) {
+    Worker* worker = _workers[workerIndex];
+    int job;
+    while (_takeJob(workerIndex, job)) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const Image& image = (*_images)[job];
+        Image result;
+        if (image.width <= 0 || image.height <= 0 || (int)image.pixels.size() < image.width * image.height * 4) {
+            Log("WARNING", "BatchProcessor: image %d is not a valid %dx%d RGBA image", job, image.width, image.height);
+        } else {
+            worker->result = &result;
+            worker->input->setImage(image.width, image.height, image.pixels.data());
+            worker->input->proceed();
+            worker->context->getReadbackQueue()->finish();
+            worker->result = 0;
+        }
+        worker->busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++worker->imageCount;
+
+        {
+            std::lock_guard<std::mutex> lock(_resultsMutex);
+            _results[job] = std::move(result);
+            _isReady[job] = 1;
+        }
+        _resultReady.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_resultsMutex);
+        --_activeWorkerCount;
+    }
+    _resultReady.notify_all();
+}
+
+NS_GI_END
@@ -25,6 +25,14 @@
 #include <pthread.h>
 #include "GLProgram.hpp"
 #include "filter/Filter.hpp"
+#include "ReadbackQueue.hpp"
+#include "FrameDataPool.hpp"
+#include "FrameMetrics.hpp"
+#include "QualityController.hpp"
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
 
 #if PLATFORM == PLATFORM_IOS
 #import <OpenGLES/EAGL.h>
@@ -33,6 +41,19 @@
 
 NS_GI_BEGIN
 
+class RenderThread;
+
+// A Context holds everything a pipeline shares while it runs: the framebuffer
+// cache, the readback queue and frame data pool, the active program and the
+// pass and capture state. Contexts are independent of each other, so pipelines
+// in different contexts can run at the same time on their own threads and GL
+// contexts (a render thread each, or the context queue on iOS).
+//
+// The default context is made on first use and managed by init() and
+// destroy(). Other contexts are made with new and deleted by their owner once
+// the objects made in them are gone. Sources, framebuffers, frame data and
+// programs belong to the context current when they are made; a pass runs in
+// the context of the source that starts it.
 class Context {
 public:
     Context();
@@ -41,15 +62,65 @@ public:
     static void init();
     static void destroy();
 
+    // the context current on the calling thread, the default one if none is
     static Context* getInstance();
+    static Context* getDefault();
+    // 0 while the default context is in use
+    static Context* getCurrent() { return _current; }
+    // Make context current on the calling thread, 0 for the default one, and
+    // return the one that was. Commands run by the render thread or the iOS
+    // context queue of a context have it current already.
+    static Context* setCurrent(Context* context);
+    void makeCurrent() { setCurrent(this); }
+    // true on the thread the context was last made current or ran a pass on
+    bool isContextThread() const { return _threadId.load() == std::this_thread::get_id(); }
+
+    // Run deletion, which deletes GL objects of context (0 for the default
+    // one), on the thread of the context: at once when called there, posted to
+    // the render thread if it has one, and otherwise queued until the next pass
+    // or purge() there. Lets a reference go on any thread, a Java finalizer
+    // included.
+    static void deferDeletion(Context* context, std::function<void(void)> deletion);
+    int getDeferredDeletionCount();
 
     FramebufferCache* getFramebufferCache() const;
+    ReadbackQueue* getReadbackQueue() const;
+    FrameDataPool* getFrameDataPool() const;
+    // latency and frame pacing of the passes run in the context
+    FrameMetrics* getFrameMetrics() { return &_frameMetrics; }
+    // holds the passes run in the context to a frame time budget
+    QualityController* getQualityController() { return &_qualityController; }
     void setActiveShaderProgram(GLProgram* shaderProgram);
     void purge();
+
+    // A pass starts when a source updates its targets without being updated by
+    // another source itself; everything it reaches before returning belongs to
+    // the same frame. Passes nest, only the outermost one counts.
+    void beginPass(Source* source);
+    void endPass();
+    unsigned int getPassSerial() const { return _passSerial; }
+    Source* getPassSource() const { return _passSource; }
+    // times a target was updated more than once in the same pass, 0 for a graph
+    // where every node joins its inputs correctly
+    unsigned int getRedundantRunCount() const { return _redundantRunCount; }
+    void addRedundantRun() { ++_redundantRunCount; }
     
-#if PLATFORM == PLATFORM_IOS
+    // Run func where the GL context of the library is current: on iOS the
+    // context queue, elsewhere the render thread once it has been started, and
+    // in place before that, the caller then owns the context (GLSurfaceView).
     void runSync(std::function<void(void)> func);
     void runAsync(std::function<void(void)> func);
+
+#if PLATFORM != PLATFORM_IOS
+    // Start a render thread with a GL context of its own, sharing objects with
+    // sharedContext (an EGLContext) if given, see RenderThread.
+    bool startRenderThread(void* sharedContext = 0);
+    // runs what was posted, frees the cached GL objects and stops the thread
+    void stopRenderThread();
+    RenderThread* getRenderThread() const { return _renderThread; }
+#endif
+
+#if PLATFORM == PLATFORM_IOS
     void useAsCurrent(void);
     dispatch_queue_t getContextQueue() const { return _contextQueue; };
     EAGLContext* getEglContext() const { return _eglContext; };
@@ -60,15 +131,39 @@ public:
     bool isCapturingFrame;
     Filter* captureUpToFilter;
     unsigned char* capturedFrameData;
+    // set when capturing into caller memory
+    unsigned char* captureDestination;
+    int captureStride;
     int captureWidth;
     int captureHeight;
+    // timestamp of the frame last captured
+    int64_t captureTimestamp;
+    // set for an asynchronous capture, the read is queued instead of waited for
+    ReadbackQueue::Callback captureCallback;
 
 private:
-    static Context* _instance;
+    static std::atomic<Context*> _instance;
     static std::mutex _mutex;
+    static thread_local Context* _current;
     FramebufferCache* _framebufferCache;
+    ReadbackQueue* _readbackQueue;
+    FrameDataPool* _frameDataPool;
+    FrameMetrics _frameMetrics;
+    QualityController _qualityController;
     GLProgram* _curShaderProgram;
+    Source* _passSource;
+    unsigned int _passSerial;
+    int _passDepth;
+    unsigned int _redundantRunCount;
+    std::atomic<std::thread::id> _threadId;
+    std::mutex _deferredDeletionsMutex;
+    std::vector<std::function<void(void)>> _deferredDeletions;
+
+    void _runDeferredDeletions();
     
+#if PLATFORM != PLATFORM_IOS
+    RenderThread* _renderThread;
+#endif
 #if PLATFORM == PLATFORM_IOS
     dispatch_queue_t _contextQueue;
     EAGLContext* _eglContext;
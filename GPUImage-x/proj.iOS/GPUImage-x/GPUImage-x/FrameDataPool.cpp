@@ -0,0 +1,96 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameDataPool.hpp"
+#include <assert.h>
+#include "Context.hpp"
+
+NS_GI_BEGIN
+
+FrameData::FrameData(int width, int height, int stride/* = 0*/)
+:_context(Context::getCurrent())
+,_width(width)
+,_height(height)
+,_stride(stride < width * 4 ? width * 4 : stride)
+{
+    _data = new unsigned char[_stride * _height];
+}
+
+FrameData::~FrameData() {
+    delete[] _data;
+    _data = 0;
+}
+
+void FrameData::release(bool returnToPool/* = true*/) {
+    if (returnToPool) {
+        unsigned int count = _referenceCount.fetch_sub(1, std::memory_order_acq_rel);
+        assert(count > 0);
+        if (count == 1) {
+            Context* context = _context ? _context : Context::getDefault();
+            context->getFrameDataPool()->returnFrameData(this);
+        }
+    } else {
+        Ref::release();
+    }
+}
+
+FrameDataPool::FrameDataPool(int capacity/* = 4*/)
+:_capacity(capacity)
+{
+}
+
+FrameDataPool::~FrameDataPool() {
+    purge();
+}
+
+FrameData* FrameDataPool::fetchFrameData(int width, int height, int stride/* = 0*/) {
+    if (stride < width * 4) stride = width * 4;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (auto it = _frameDatas.begin(); it != _frameDatas.end(); ++it) {
+            FrameData* frameData = *it;
+            if (frameData->getWidth() == width && frameData->getHeight() == height && frameData->getStride() == stride) {
+                _frameDatas.erase(it);
+                frameData->resetRefenceCount();
+                return frameData;
+            }
+        }
+    }
+    return new FrameData(width, height, stride);
+}
+
+void FrameDataPool::returnFrameData(FrameData* frameData) {
+    if (frameData == 0) return;
+    std::unique_lock<std::mutex> lock(_mutex);
+    if ((int)_frameDatas.size() >= _capacity) {
+        // the oldest one is least likely to match the next capture
+        delete _frameDatas.front();
+        _frameDatas.erase(_frameDatas.begin());
+    }
+    _frameDatas.push_back(frameData);
+}
+
+void FrameDataPool::purge() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (auto frameData : _frameDatas) {
+        delete frameData;
+    }
+    _frameDatas.clear();
+}
+
+NS_GI_END
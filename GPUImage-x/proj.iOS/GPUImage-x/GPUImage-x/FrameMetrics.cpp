@@ -0,0 +1,192 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameMetrics.hpp"
+#include "util.h"
+#include <algorithm>
+#include <math.h>
+#include <utility>
+
+NS_GI_BEGIN
+
+Histogram::Histogram()
+:_counts(kBucketCount, 0)
+,_count(0)
+,_sum(0)
+,_max(0)
+{
+}
+
+void Histogram::record(int64_t valueUs) {
+    if (valueUs < 0) valueUs = 0;
+    ++_counts[_getIndex(valueUs)];
+    ++_count;
+    _sum += valueUs;
+    if (valueUs > _max) {
+        _max = valueUs;
+    }
+}
+
+void Histogram::add(const Histogram& histogram) {
+    for (int i = 0; i < kBucketCount; ++i) {
+        _counts[i] += histogram._counts[i];
+    }
+    _count += histogram._count;
+    _sum += histogram._sum;
+    if (histogram._max > _max) {
+        _max = histogram._max;
+    }
+}
+
+void Histogram::reset() {
+    std::fill(_counts.begin(), _counts.end(), 0);
+    _count = 0;
+    _sum = 0;
+    _max = 0;
+}
+
+int64_t Histogram::getPercentile(double percentile) const {
+    if (_count == 0) return 0;
+    uint64_t rank = (uint64_t)ceil(percentile / 100.0 * _count);
+    if (rank < 1) rank = 1;
+    uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        total += _counts[i];
+        if (total >= rank) {
+            int64_t value = _getValue(i);
+            return value < _max ? value : _max;
+        }
+    }
+    return _max;
+}
+
+// Values below 2 * kSubBucketCount have a bucket each. Above, the power of two
+// a value falls in picks kSubBucketCount buckets and its next bits one of them.
+int Histogram::_getIndex(int64_t valueUs) {
+    if (valueUs < 2 * kSubBucketCount) return (int)valueUs;
+    int magnitude = 63 - __builtin_clzll((unsigned long long)valueUs);
+    int shift = magnitude - 4;
+    int index = 2 * kSubBucketCount + (magnitude - 5) * kSubBucketCount + (int)((valueUs >> shift) - kSubBucketCount);
+    return index < kBucketCount ? index : kBucketCount - 1;
+}
+
+// the middle of the bucket
+int64_t Histogram::_getValue(int index) {
+    if (index < 2 * kSubBucketCount) return index;
+    int magnitude = 5 + (index - 2 * kSubBucketCount) / kSubBucketCount;
+    int subBucket = (index - 2 * kSubBucketCount) % kSubBucketCount;
+    int shift = magnitude - 4;
+    return ((int64_t)(kSubBucketCount + subBucket) << shift) + ((int64_t)1 << shift) / 2;
+}
+
+FrameMetrics::FrameMetrics(double windowSeconds/* = 10*/)
+:_isEnabled(true)
+,_window(0)
+,_windowStart(0)
+,_lastPassEnd(0)
+,_lastInterval(-1)
+{
+    setWindow(windowSeconds);
+}
+
+void FrameMetrics::setWindow(double windowSeconds) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _window = (int64_t)(windowSeconds * 1e9);
+    if (_window < 1000000) _window = 1000000;
+}
+
+void FrameMetrics::recordLatency(Metric metric, int64_t timestamp) {
+    if (!_isEnabled || timestamp <= 0) return;
+    record(metric, (getMonotonicTimestamp() - timestamp) / 1000);
+}
+
+void FrameMetrics::recordPassEnd() {
+    if (!_isEnabled) return;
+    int64_t now = getMonotonicTimestamp();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _roll(now);
+    if (_lastPassEnd > 0) {
+        int64_t interval = (now - _lastPassEnd) / 1000;
+        _current[FrameInterval].record(interval);
+        if (_lastInterval >= 0) {
+            _current[FrameJitter].record(interval > _lastInterval ? interval - _lastInterval : _lastInterval - interval);
+        }
+        _lastInterval = interval;
+    }
+    _lastPassEnd = now;
+}
+
+void FrameMetrics::record(Metric metric, int64_t valueUs) {
+    if (!_isEnabled || metric < 0 || metric >= MetricCount) return;
+    int64_t now = getMonotonicTimestamp();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _roll(now);
+    _current[metric].record(valueUs);
+}
+
+FrameMetrics::Stats FrameMetrics::getStats(Metric metric) const {
+    Histogram histogram = getHistogram(metric);
+    Stats stats;
+    stats.count = histogram.getCount();
+    stats.p50 = histogram.getPercentile(50) / 1000.0;
+    stats.p95 = histogram.getPercentile(95) / 1000.0;
+    stats.p99 = histogram.getPercentile(99) / 1000.0;
+    stats.max = histogram.getMax() / 1000.0;
+    stats.mean = histogram.getMean() / 1000.0;
+    return stats;
+}
+
+Histogram FrameMetrics::getHistogram(Metric metric) const {
+    Histogram histogram;
+    if (metric < 0 || metric >= MetricCount) return histogram;
+    std::lock_guard<std::mutex> lock(_mutex);
+    histogram.add(_previous[metric]);
+    histogram.add(_current[metric]);
+    return histogram;
+}
+
+void FrameMetrics::reset() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (int i = 0; i < MetricCount; ++i) {
+        _current[i].reset();
+        _previous[i].reset();
+    }
+    _windowStart = 0;
+    _lastPassEnd = 0;
+    _lastInterval = -1;
+}
+
+void FrameMetrics::_roll(int64_t now) {
+    if (_windowStart == 0) {
+        _windowStart = now;
+    } else if (now - _windowStart >= _window) {
+        // a gap of more than two windows leaves nothing worth keeping
+        bool isIdle = now - _windowStart >= 2 * _window;
+        for (int i = 0; i < MetricCount; ++i) {
+            if (isIdle) {
+                _previous[i].reset();
+            } else {
+                std::swap(_previous[i], _current[i]);
+            }
+            _current[i].reset();
+        }
+        _windowStart = now;
+    }
+}
+
+NS_GI_END
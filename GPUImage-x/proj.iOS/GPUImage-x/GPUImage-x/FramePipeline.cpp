@@ -0,0 +1,185 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FramePipeline.hpp"
+#include "GLES3.hpp"
+#include "Context.hpp"
+#include "util.h"
+
+NS_GI_BEGIN
+
+static const GLuint64 kFrameTimeout = 1000000000;
+
+FramePipeline::FramePipeline(int depth/* = 2*/)
+:_context(Context::getCurrent())
+,_depth(1)
+,_isFrameOpen(false)
+{
+    setDepth(depth);
+    resetStats();
+}
+
+FramePipeline::~FramePipeline() {
+    if (_isFrameOpen) {
+        Context* context = _context ? _context : Context::getDefault();
+        context->getFramebufferCache()->setFrameSet(0);
+        _releaseFrame(_openFrame, _context);
+    }
+    for (auto& frame : _frames) {
+        _releaseFrame(frame, _context);
+    }
+    _frames.clear();
+}
+
+void FramePipeline::setDepth(int depth) {
+    // a smaller depth takes effect as the frames in flight retire
+    _depth = depth < 1 ? 1 : (depth > kMaxDepth ? kMaxDepth : depth);
+}
+
+void FramePipeline::beginFrame() {
+    if (_isFrameOpen) return;
+
+    Clock::time_point beginTime = Clock::now();
+    poll();
+    while ((int)_frames.size() >= _depth) {
+        _retire(_frames.front(), true);
+        _frames.pop_front();
+    }
+
+    _openFrame.fence = 0;
+    _openFrame.framebuffers.clear();
+    _openFrame.beginTime = Clock::now();
+    _openFrame.stallMs = std::chrono::duration<double, std::milli>(_openFrame.beginTime - beginTime).count();
+    _openFrame.depth = _depth;
+    _isFrameOpen = true;
+    Context::getInstance()->getFramebufferCache()->setFrameSet(&_openFrame.framebuffers);
+}
+
+void FramePipeline::endFrame() {
+    if (!_isFrameOpen) return;
+    Context::getInstance()->getFramebufferCache()->setFrameSet(0);
+    _isFrameOpen = false;
+
+    if (GLES3::isAvailable()) {
+        _openFrame.fence = GLES3::fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    // hand the frame to the GPU now rather than when the next one blocks
+    CHECK_GL(glFlush());
+    _frames.push_back(_openFrame);
+    _openFrame.framebuffers.clear();
+}
+
+void FramePipeline::poll() {
+    while (!_frames.empty() && _frames.front().fence && GLES3::isSignaled(_frames.front().fence)) {
+        _retire(_frames.front(), false);
+        _frames.pop_front();
+    }
+    // reads queued by the retired frames are likely done too
+    Context::getInstance()->getReadbackQueue()->poll();
+}
+
+void FramePipeline::finish() {
+    while (!_frames.empty()) {
+        _retire(_frames.front(), true);
+        _frames.pop_front();
+    }
+}
+
+void FramePipeline::_retire(Frame& frame, bool wait) {
+    if (frame.fence && wait) {
+        GLenum result = GLES3::clientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFrameTimeout);
+        if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+            Log("WARNING", "FramePipeline: waiting for a frame failed (0x%04X)", result);
+        }
+    }
+
+    Clock::time_point retireTime = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        DepthStats& stats = _depthStats[frame.depth];
+        if (stats.frameCount == 0) {
+            stats.firstRetireTime = retireTime;
+        }
+        ++stats.frameCount;
+        stats.latencyMs += std::chrono::duration<double, std::milli>(retireTime - frame.beginTime).count();
+        stats.stallMs += frame.stallMs;
+        stats.lastRetireTime = retireTime;
+    }
+    _releaseFrame(frame, _context);
+}
+
+void FramePipeline::_releaseFrame(Frame& frame, Context* context) {
+    // back to the cache, the next frames may render into them again
+    for (auto framebuffer : frame.framebuffers) {
+        framebuffer->release();
+    }
+    frame.framebuffers.clear();
+    GLsync fence = frame.fence;
+    if (fence) {
+        Context::deferDeletion(context, [fence]() {
+            GLES3::deleteSync(fence);
+        });
+        frame.fence = 0;
+    }
+}
+
+FramePipeline::Stats FramePipeline::getStats(int depth/* = 0*/) const {
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    Stats stats = _getStats(depth == 0 ? _depth : depth);
+    Stats serialStats = _getStats(1);
+    if (stats.depth != 1 && stats.frameCount > 0 && serialStats.frameCount > 0) {
+        stats.addedLatencyMs = stats.averageLatencyMs - serialStats.averageLatencyMs;
+        if (serialStats.framesPerSecond > 0) {
+            stats.throughputGain = stats.framesPerSecond / serialStats.framesPerSecond;
+        }
+    }
+    return stats;
+}
+
+FramePipeline::Stats FramePipeline::_getStats(int depth) const {
+    Stats stats;
+    stats.depth = depth < 1 ? 1 : (depth > kMaxDepth ? kMaxDepth : depth);
+    stats.frameCount = 0;
+    stats.averageLatencyMs = 0;
+    stats.averageStallMs = 0;
+    stats.framesPerSecond = 0;
+    stats.addedLatencyMs = 0;
+    stats.throughputGain = 0;
+
+    const DepthStats& depthStats = _depthStats[stats.depth];
+    if (depthStats.frameCount == 0) return stats;
+    stats.frameCount = depthStats.frameCount;
+    stats.averageLatencyMs = depthStats.latencyMs / depthStats.frameCount;
+    stats.averageStallMs = depthStats.stallMs / depthStats.frameCount;
+    double seconds = std::chrono::duration<double>(depthStats.lastRetireTime - depthStats.firstRetireTime).count();
+    if (depthStats.frameCount > 1 && seconds > 0) {
+        stats.framesPerSecond = (depthStats.frameCount - 1) / seconds;
+    }
+    return stats;
+}
+
+void FramePipeline::resetStats() {
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    for (int i = 0; i <= kMaxDepth; ++i) {
+        _depthStats[i].frameCount = 0;
+        _depthStats[i].latencyMs = 0;
+        _depthStats[i].stallMs = 0;
+    }
+}
+
+NS_GI_END
@@ -0,0 +1,168 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameQueue.hpp"
+#include <string.h>
+
+NS_GI_BEGIN
+
+// copies kept around for reuse, beyond the frames waiting
+static const size_t kMaxFreeBuffers = 2;
+
+FrameQueue::FrameQueue(Policy policy/* = LatestFrameWins*/, int capacity/* = 1*/)
+:_policy(LatestFrameWins)
+,_capacity(1)
+,_isClosed(false)
+,_queuedCount(0)
+,_droppedCount(0)
+,_processedCount(0)
+,_latencyMs(0)
+,_maxLatencyMs(0)
+{
+    setPolicy(policy, capacity);
+}
+
+FrameQueue::~FrameQueue() {
+    close();
+}
+
+void FrameQueue::setPolicy(Policy policy, int capacity/* = 1*/) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _policy = policy;
+    _capacity = (policy == LatestFrameWins || capacity < 1) ? 1 : capacity;
+    while ((int)_frames.size() > _capacity) {
+        _dropFront();
+    }
+    _spaceAvailable.notify_all();
+}
+
+FrameQueue::Policy FrameQueue::getPolicy() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _policy;
+}
+
+int FrameQueue::getCapacity() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity;
+}
+
+bool FrameQueue::push(int width, int height, int format, RotationMode rotation, const void* pixels, size_t size) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    ++_queuedCount;
+    if (_policy == Block) {
+        _spaceAvailable.wait(lock, [this]() { return _isClosed || (int)_frames.size() < _capacity; });
+    }
+    if (_isClosed) {
+        ++_droppedCount;
+        return false;
+    }
+    while ((int)_frames.size() >= _capacity) {
+        _dropFront();
+    }
+
+    _frames.push_back(Frame());
+    Frame& frame = _frames.back();
+    if (!_freeBuffers.empty()) {
+        frame.pixels.swap(_freeBuffers.back());
+        _freeBuffers.pop_back();
+    }
+    frame.width = width;
+    frame.height = height;
+    frame.format = format;
+    frame.rotation = rotation;
+    frame.queueTime = Clock::now();
+    // copied under the lock, a recycled buffer is normally the right size already
+    frame.pixels.resize(size);
+    memcpy(frame.pixels.data(), pixels, size);
+    return true;
+}
+
+bool FrameQueue::pop(Frame& frame) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_frames.empty()) return false;
+    Frame& front = _frames.front();
+    frame.width = front.width;
+    frame.height = front.height;
+    frame.format = front.format;
+    frame.rotation = front.rotation;
+    frame.queueTime = front.queueTime;
+    frame.pixels.swap(front.pixels);
+    _frames.pop_front();
+    _spaceAvailable.notify_one();
+    return true;
+}
+
+void FrameQueue::processed(Frame& frame) {
+    double latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - frame.queueTime).count();
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_processedCount;
+    _latencyMs += latencyMs;
+    if (latencyMs > _maxLatencyMs) {
+        _maxLatencyMs = latencyMs;
+    }
+    if (_freeBuffers.size() < kMaxFreeBuffers) {
+        _freeBuffers.push_back(std::vector<unsigned char>());
+        _freeBuffers.back().swap(frame.pixels);
+    }
+}
+
+void FrameQueue::close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isClosed = true;
+    while (!_frames.empty()) {
+        _dropFront();
+    }
+    _spaceAvailable.notify_all();
+}
+
+void FrameQueue::open() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isClosed = false;
+}
+
+FrameQueue::Counters FrameQueue::getCounters() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Counters counters;
+    counters.queuedCount = _queuedCount;
+    counters.droppedCount = _droppedCount;
+    counters.processedCount = _processedCount;
+    counters.pendingCount = (int)_frames.size();
+    counters.averageLatencyMs = _processedCount > 0 ? _latencyMs / _processedCount : 0;
+    counters.maxLatencyMs = _maxLatencyMs;
+    return counters;
+}
+
+void FrameQueue::resetCounters() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queuedCount = 0;
+    _droppedCount = 0;
+    _processedCount = 0;
+    _latencyMs = 0;
+    _maxLatencyMs = 0;
+}
+
+void FrameQueue::_dropFront() {
+    ++_droppedCount;
+    if (_freeBuffers.size() < kMaxFreeBuffers) {
+        _freeBuffers.push_back(std::vector<unsigned char>());
+        _freeBuffers.back().swap(_frames.front().pixels);
+    }
+    _frames.pop_front();
+}
+
+NS_GI_END
@@ -26,6 +26,7 @@
 NS_GI_BEGIN
 
 std::vector<Framebuffer*> Framebuffer::_framebuffers;
+std::mutex Framebuffer::_framebuffersMutex;
 
 TextureAttributes Framebuffer::defaultTextureAttribures = {
     .minFilter = GL_LINEAR,
@@ -38,8 +39,10 @@ TextureAttributes Framebuffer::defaultTextureAttribures = {
 };
 
 Framebuffer::Framebuffer(int width, int height, bool onlyGenerateTexture/* = false*/, const TextureAttributes textureAttributes/* = defaultTextureAttribures*/)
-:_texture(-1)
+:_context(Context::getCurrent())
+,_texture(-1)
 ,_framebuffer(-1)
+,_timestamp(0)
 {
     _width = width;
     _height = height;
@@ -52,11 +55,13 @@ Framebuffer::Framebuffer(int width, int height, bool onlyGenerateTexture/* = fal
         _generateTexture();
     }
 
+    std::lock_guard<std::mutex> lock(_framebuffersMutex);
     _framebuffers.push_back(this);
 }
 
 Framebuffer::~Framebuffer() {
     // todo
+    std::unique_lock<std::mutex> lock(_framebuffersMutex);
     std::vector<Framebuffer*>::iterator itr = std::find(_framebuffers.begin(), _framebuffers.end(), this);
     if (itr != _framebuffers.end()) {
         _framebuffers.erase(itr);
@@ -66,6 +71,8 @@ Framebuffer::~Framebuffer() {
     bool bDeleteFB = (_framebuffer != -1);
 
     for (auto const& framebuffer : _framebuffers ) {
+        // object names are only unique within a context
+        if (framebuffer->_context != _context) continue;
         if (bDeleteTex) {
             if (_texture == framebuffer->getTexture()) {
                 bDeleteTex = false;
@@ -78,23 +85,31 @@ Framebuffer::~Framebuffer() {
             }
         }
     }
-
-    if (bDeleteTex) {
-        CHECK_GL(glDeleteTextures(1, &_texture));
-        _texture = -1;
-    }
-    if (bDeleteFB) {
-        CHECK_GL(glDeleteFramebuffers(1, &_framebuffer));
-        _framebuffer = -1;
+    lock.unlock();
+
+    if (bDeleteTex || bDeleteFB) {
+        GLuint texture = _texture;
+        GLuint framebuffer = _framebuffer;
+        Context::deferDeletion(_context, [bDeleteTex, texture, bDeleteFB, framebuffer]() {
+            if (bDeleteTex) {
+                CHECK_GL(glDeleteTextures(1, &texture));
+            }
+            if (bDeleteFB) {
+                CHECK_GL(glDeleteFramebuffers(1, &framebuffer));
+            }
+        });
     }
+    _texture = -1;
+    _framebuffer = -1;
 }
 
 void Framebuffer::release(bool returnToCache/* = true*/) {
     if (returnToCache) {
-        assert(_referenceCount > 0);
-        --_referenceCount;
-        if (_referenceCount == 0) {
-            Context::getInstance()->getFramebufferCache()->returnFramebuffer(this);
+        unsigned int count = _referenceCount.fetch_sub(1, std::memory_order_acq_rel);
+        assert(count > 0);
+        if (count == 1) {
+            Context* context = _context ? _context : Context::getDefault();
+            context->getFramebufferCache()->returnFramebuffer(this);
         }
     } else {
         Ref::release();
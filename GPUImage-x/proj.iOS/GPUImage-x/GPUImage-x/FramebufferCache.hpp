@@ -23,9 +23,13 @@
 #include "Framebuffer.hpp"
 #include <string>
 #include <map>
+#include <mutex>
+#include <vector>
 
 NS_GI_BEGIN
 
+// Framebuffers are fetched on the thread of the context, but may come back
+// from any thread the last reference goes on, so the cache is locked.
 class FramebufferCache {
 public:
     FramebufferCache();
@@ -33,6 +37,9 @@ public:
     Framebuffer* fetchFramebuffer(int width, int height, bool onlyTexture = false, const TextureAttributes textureAttributes = Framebuffer::defaultTextureAttribures );
     void returnFramebuffer(Framebuffer* framebuffer);
     void purge();
+    // While a frame set is given, every fetched framebuffer is retained into it
+    // and stays out of the cache until its owner releases it, see FramePipeline.
+    void setFrameSet(std::vector<Framebuffer*>* frameSet) { _frameSet = frameSet; }
     
     
 private:
@@ -41,6 +48,8 @@ private:
     
     std::map<std::string, Framebuffer*> _framebuffers;
     std::map<std::string, int> _framebufferTypeCounts;
+    std::mutex _mutex;
+    std::vector<Framebuffer*>* _frameSet;
     
 };
 
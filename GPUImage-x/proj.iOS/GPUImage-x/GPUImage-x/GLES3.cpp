@@ -0,0 +1,119 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GLES3.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include "util.h"
+
+#if PLATFORM == PLATFORM_ANDROID && !ENABLE_GL_MOCK
+#include <dlfcn.h>
+#endif
+
+NS_GI_BEGIN
+
+typedef void* (*MapBufferRangeFunc)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (*UnmapBufferFunc)(GLenum target);
+typedef GLsync (*FenceSyncFunc)(GLenum condition, GLbitfield flags);
+typedef GLenum (*ClientWaitSyncFunc)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (*DeleteSyncFunc)(GLsync sync);
+
+static MapBufferRangeFunc _mapBufferRange = 0;
+static UnmapBufferFunc _unmapBuffer = 0;
+static FenceSyncFunc _fenceSync = 0;
+static ClientWaitSyncFunc _clientWaitSync = 0;
+static DeleteSyncFunc _deleteSync = 0;
+
+static bool _loadEntryPoints() {
+#if ENABLE_GL_MOCK
+    _mapBufferRange = GLMock::mapBufferRange;
+    _unmapBuffer = GLMock::unmapBuffer;
+    _fenceSync = GLMock::fenceSync;
+    _clientWaitSync = GLMock::clientWaitSync;
+    _deleteSync = GLMock::deleteSync;
+#elif PLATFORM == PLATFORM_ANDROID
+    // libGLESv3 only exists from API 18 on, linking it would break older devices
+    void* library = dlopen("libGLESv3.so", RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        Log("WARNING", "GLES3: libGLESv3.so not found");
+        return false;
+    }
+    _mapBufferRange = (MapBufferRangeFunc)dlsym(library, "glMapBufferRange");
+    _unmapBuffer = (UnmapBufferFunc)dlsym(library, "glUnmapBuffer");
+    _fenceSync = (FenceSyncFunc)dlsym(library, "glFenceSync");
+    _clientWaitSync = (ClientWaitSyncFunc)dlsym(library, "glClientWaitSync");
+    _deleteSync = (DeleteSyncFunc)dlsym(library, "glDeleteSync");
+#endif
+    return _mapBufferRange && _unmapBuffer && _fenceSync && _clientWaitSync && _deleteSync;
+}
+
+bool GLES3::isAvailable() {
+    // asked once per thread, each thread has its own context current
+    static thread_local bool available = false;
+#if !ENABLE_GL_MOCK
+    static thread_local bool loaded = false;
+    // GLMock can switch between GLES2 and GLES3, so only a real driver is asked once
+    if (loaded) return available;
+#endif
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (!version) return false;     // no current context yet, ask again later
+
+    // the entry points are the same for every context
+    static std::once_flag entryPointsFlag;
+    static bool hasEntryPoints = false;
+    std::call_once(entryPointsFlag, []() { hasEntryPoints = _loadEntryPoints(); });
+
+    if (strncmp(version, "OpenGL ES ", 10) != 0 || atoi(version + 10) < 3) {
+        available = false;
+    } else {
+        available = hasEntryPoints;
+    }
+#if !ENABLE_GL_MOCK
+    loaded = true;
+#endif
+    return available;
+}
+
+void* GLES3::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    return _mapBufferRange(target, offset, length, access);
+}
+
+GLboolean GLES3::unmapBuffer(GLenum target) {
+    return _unmapBuffer(target);
+}
+
+GLsync GLES3::fenceSync(GLenum condition, GLbitfield flags) {
+    return _fenceSync(condition, flags);
+}
+
+GLenum GLES3::clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    return _clientWaitSync(sync, flags, timeout);
+}
+
+void GLES3::deleteSync(GLsync sync) {
+    _deleteSync(sync);
+}
+
+bool GLES3::isSignaled(GLsync sync) {
+    if (!sync) return true;
+    GLenum result = _clientWaitSync(sync, 0, 0);
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+NS_GI_END
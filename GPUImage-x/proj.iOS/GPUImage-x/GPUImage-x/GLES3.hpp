@@ -0,0 +1,91 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLES3_hpp
+#define GLES3_hpp
+
+#include "macros.h"
+#include "Framebuffer.hpp"
+
+// GLES3 enums, the GLES2 headers the library is built against do not have them
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER                0x88EB
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER              0x88EC
+#endif
+#ifndef GL_PACK_ROW_LENGTH
+#define GL_PACK_ROW_LENGTH                  0x0D02
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ                      0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT                     0x0001
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT                    0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+#define GL_MAP_INVALIDATE_BUFFER_BIT        0x0008
+#endif
+#ifndef GL_MAP_UNSYNCHRONIZED_BIT
+#define GL_MAP_UNSYNCHRONIZED_BIT           0x0020
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE       0x9117
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED                 0x911A
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED                  0x911B
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED              0x911C
+#endif
+#ifndef GL_WAIT_FAILED
+#define GL_WAIT_FAILED                      0x911D
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT          0x00000001
+#endif
+
+NS_GI_BEGIN
+
+// GLES3 entry points used by the streaming paths. The library still creates
+// and links against GLES2, so these are resolved at run time and only used
+// when the current context reports GLES 3.0 or later.
+class GLES3 {
+public:
+    // true if the current context is GLES 3.0 or later and every entry point was found
+    static bool isAvailable();
+
+    static void* mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    static GLboolean unmapBuffer(GLenum target);
+    static GLsync fenceSync(GLenum condition, GLbitfield flags);
+    static GLenum clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+    static void deleteSync(GLsync sync);
+
+    // true if the commands before the fence have completed, never blocks
+    static bool isSignaled(GLsync sync);
+};
+
+NS_GI_END
+
+#endif /* GLES3_hpp */
@@ -0,0 +1,440 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GLMock.hpp"
+
+#if ENABLE_GL_MOCK
+
+#include <map>
+#include <string>
+#include <vector>
+#include <string.h>
+#include "util.h"
+#include "GLES3.hpp"
+
+NS_GI_BEGIN
+
+thread_local GLMock::Stats GLMock::_frameStats;
+thread_local GLMock::Stats GLMock::_totalStats;
+GLMock::Stats GLMock::_frameBudget = GLMock::unlimitedBudget();
+thread_local int GLMock::_frameCount = 0;
+bool GLMock::_gles3Available = true;
+
+// bound state of the mocked driver
+static thread_local GLuint _nextObjectName = 1;
+static thread_local GLuint _curProgram = 0;
+static thread_local GLuint _curFramebuffer = 0;
+static thread_local GLenum _curTextureUnit = GL_TEXTURE0;
+static thread_local GLint _viewport[4] = {0, 0, 0, 0};
+static thread_local std::map<GLenum, GLuint> _boundTextures;
+static thread_local std::map<GLenum, GLuint> _boundBuffers;
+static thread_local GLint _packRowLength = 0;
+static thread_local std::map<GLuint, std::vector<unsigned char> > _bufferStorage;
+static thread_local std::map<std::pair<GLuint, std::string>, GLint> _locations;
+static thread_local std::map<std::pair<GLuint, GLint>, std::vector<unsigned char> > _uniformValues;
+
+GLMock::Stats::Stats() {
+    reset();
+}
+
+void GLMock::Stats::reset(int value/* = 0*/) {
+    totalCalls = value;
+    drawCalls = value;
+    clears = value;
+    programSwitches = value;
+    redundantProgramSwitches = value;
+    framebufferBinds = value;
+    textureBinds = value;
+    redundantBinds = value;
+    uniformUploads = value;
+    redundantUniformUploads = value;
+    viewportChanges = value;
+    textureUploads = value;
+    readbacks = value;
+}
+
+GLMock::Stats GLMock::unlimitedBudget() {
+    Stats budget;
+    budget.reset(-1);
+    return budget;
+}
+
+void GLMock::beginFrame() {
+    _frameStats.reset();
+}
+
+bool GLMock::endFrame() {
+    ++_frameCount;
+
+    static const struct {
+        const char* name;
+        int Stats::* counter;
+    } counters[] = {
+        { "totalCalls", &Stats::totalCalls },
+        { "drawCalls", &Stats::drawCalls },
+        { "clears", &Stats::clears },
+        { "programSwitches", &Stats::programSwitches },
+        { "redundantProgramSwitches", &Stats::redundantProgramSwitches },
+        { "framebufferBinds", &Stats::framebufferBinds },
+        { "textureBinds", &Stats::textureBinds },
+        { "redundantBinds", &Stats::redundantBinds },
+        { "uniformUploads", &Stats::uniformUploads },
+        { "redundantUniformUploads", &Stats::redundantUniformUploads },
+        { "viewportChanges", &Stats::viewportChanges },
+        { "textureUploads", &Stats::textureUploads },
+        { "readbacks", &Stats::readbacks },
+    };
+
+    bool withinBudget = true;
+    for (const auto& it : counters) {
+        int budget = _frameBudget.*(it.counter);
+        int value = _frameStats.*(it.counter);
+        if (budget >= 0 && value > budget) {
+            Log("ERROR", "GLMock frame %d: %s = %d exceeds budget %d", _frameCount, it.name, value, budget);
+            withinBudget = false;
+        }
+    }
+    return withinBudget;
+}
+
+void GLMock::reset() {
+    _frameStats.reset();
+    _totalStats.reset();
+    _frameCount = 0;
+    _nextObjectName = 1;
+    _curProgram = 0;
+    _curFramebuffer = 0;
+    _curTextureUnit = GL_TEXTURE0;
+    memset(_viewport, 0, sizeof(_viewport));
+    _boundTextures.clear();
+    _boundBuffers.clear();
+    _packRowLength = 0;
+    _bufferStorage.clear();
+    _locations.clear();
+    _uniformValues.clear();
+}
+
+void GLMock::_count(int Stats::* counter, int n/* = 1*/) {
+    _frameStats.*counter += n;
+    _totalStats.*counter += n;
+}
+
+void GLMock::_uniform(GLint location, const void* value, int size) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::uniformUploads);
+    std::vector<unsigned char>& lastValue = _uniformValues[std::make_pair(_curProgram, location)];
+    if ((int)lastValue.size() == size && memcmp(&lastValue[0], value, size) == 0) {
+        _count(&Stats::redundantUniformUploads);
+    } else {
+        lastValue.assign((const unsigned char*)value, (const unsigned char*)value + size);
+    }
+}
+
+void GLMock::activeTexture(GLenum texture) {
+    _count(&Stats::totalCalls);
+    _curTextureUnit = texture;
+}
+
+void GLMock::attachShader(GLuint program, GLuint shader) {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::bindBuffer(GLenum target, GLuint buffer) {
+    _count(&Stats::totalCalls);
+    _boundBuffers[target] = buffer;
+}
+
+void GLMock::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::framebufferBinds);
+    if (framebuffer == _curFramebuffer)
+        _count(&Stats::redundantBinds);
+    _curFramebuffer = framebuffer;
+}
+
+void GLMock::bindTexture(GLenum target, GLuint texture) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::textureBinds);
+    std::map<GLenum, GLuint>::iterator it = _boundTextures.find(_curTextureUnit);
+    if (it != _boundTextures.end() && it->second == texture)
+        _count(&Stats::redundantBinds);
+    _boundTextures[_curTextureUnit] = texture;
+}
+
+void GLMock::bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    _count(&Stats::totalCalls);
+    std::vector<unsigned char>& storage = _bufferStorage[_boundBuffers[target]];
+    storage.assign(size, 0);
+    if (data && size > 0)
+        memcpy(&storage[0], data, size);
+}
+
+void GLMock::clear(GLbitfield mask) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::clears);
+}
+
+void GLMock::clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::compileShader(GLuint shader) {
+    _count(&Stats::totalCalls);
+}
+
+GLuint GLMock::createProgram() {
+    _count(&Stats::totalCalls);
+    return _nextObjectName++;
+}
+
+GLuint GLMock::createShader(GLenum type) {
+    _count(&Stats::totalCalls);
+    return _nextObjectName++;
+}
+
+GLenum GLMock::clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    _count(&Stats::totalCalls);
+    // the mocked GPU finishes every command immediately
+    return GL_ALREADY_SIGNALED;
+}
+
+void GLMock::deleteBuffers(GLsizei n, const GLuint* buffers) {
+    _count(&Stats::totalCalls);
+    for (int i = 0; i < n; ++i) {
+        _bufferStorage.erase(buffers[i]);
+        for (auto& it : _boundBuffers) {
+            if (it.second == buffers[i])
+                it.second = 0;
+        }
+    }
+}
+
+void GLMock::deleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+    _count(&Stats::totalCalls);
+    for (int i = 0; i < n; ++i) {
+        if (framebuffers[i] == _curFramebuffer)
+            _curFramebuffer = 0;
+    }
+}
+
+void GLMock::deleteProgram(GLuint program) {
+    _count(&Stats::totalCalls);
+    if (program == _curProgram)
+        _curProgram = 0;
+}
+
+void GLMock::deleteShader(GLuint shader) {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::deleteSync(GLsync sync) {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::deleteTextures(GLsizei n, const GLuint* textures) {
+    _count(&Stats::totalCalls);
+    for (int i = 0; i < n; ++i) {
+        for (auto& it : _boundTextures) {
+            if (it.second == textures[i])
+                it.second = 0;
+        }
+    }
+}
+
+void GLMock::drawArrays(GLenum mode, GLint first, GLsizei count) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::drawCalls);
+}
+
+void GLMock::enableVertexAttribArray(GLuint index) {
+    _count(&Stats::totalCalls);
+}
+
+GLsync GLMock::fenceSync(GLenum condition, GLbitfield flags) {
+    _count(&Stats::totalCalls);
+    return (GLsync)(uintptr_t)(_nextObjectName++);
+}
+
+void GLMock::flush() {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::framebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::genBuffers(GLsizei n, GLuint* buffers) {
+    _count(&Stats::totalCalls);
+    for (int i = 0; i < n; ++i)
+        buffers[i] = _nextObjectName++;
+}
+
+void GLMock::genFramebuffers(GLsizei n, GLuint* framebuffers) {
+    _count(&Stats::totalCalls);
+    for (int i = 0; i < n; ++i)
+        framebuffers[i] = _nextObjectName++;
+}
+
+void GLMock::genTextures(GLsizei n, GLuint* textures) {
+    _count(&Stats::totalCalls);
+    for (int i = 0; i < n; ++i)
+        textures[i] = _nextObjectName++;
+}
+
+GLint GLMock::getAttribLocation(GLuint program, const GLchar* name) {
+    _count(&Stats::totalCalls);
+    std::pair<GLuint, std::string> key = std::make_pair(program, std::string("attribute ") + name);
+    if (_locations.find(key) == _locations.end()) {
+        _locations[key] = (GLint)_locations.size();
+    }
+    return _locations[key];
+}
+
+GLenum GLMock::getError() {
+    return GL_NO_ERROR;
+}
+
+const GLubyte* GLMock::getString(GLenum name) {
+    if (name == GL_VERSION)
+        return (const GLubyte*)(_gles3Available ? "OpenGL ES 3.0 GLMock" : "OpenGL ES 2.0 GLMock");
+    return (const GLubyte*)"GLMock";
+}
+
+GLint GLMock::getUniformLocation(GLuint program, const GLchar* name) {
+    _count(&Stats::totalCalls);
+    std::pair<GLuint, std::string> key = std::make_pair(program, std::string(name));
+    if (_locations.find(key) == _locations.end()) {
+        _locations[key] = (GLint)_locations.size();
+    }
+    return _locations[key];
+}
+
+void GLMock::linkProgram(GLuint program) {
+    _count(&Stats::totalCalls);
+}
+
+void* GLMock::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    _count(&Stats::totalCalls);
+    std::vector<unsigned char>& storage = _bufferStorage[_boundBuffers[target]];
+    if (offset + length > (GLintptr)storage.size())
+        return 0;
+    return &storage[offset];
+}
+
+void GLMock::pixelStorei(GLenum pname, GLint param) {
+    _count(&Stats::totalCalls);
+    if (pname == GL_PACK_ROW_LENGTH)
+        _packRowLength = param;
+}
+
+void GLMock::readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::readbacks);
+    int pixelSize = format == GL_RGB ? 3 : 4;
+    size_t rowSize = width * pixelSize;
+    size_t stride = (_packRowLength > 0 ? _packRowLength : width) * pixelSize;
+    size_t size = stride * (height - 1) + rowSize;
+    GLuint packBuffer = _boundBuffers[GL_PIXEL_PACK_BUFFER];
+    unsigned char* dst = (unsigned char*)pixels;
+    if (packBuffer) {
+        // pixels is an offset into the bound pixel pack buffer
+        std::vector<unsigned char>& storage = _bufferStorage[packBuffer];
+        size_t offset = (size_t)pixels;
+        dst = offset + size <= storage.size() ? &storage[offset] : 0;
+    }
+    if (dst && height > 0) {
+        for (int row = 0; row < height; ++row)
+            memset(dst + row * stride, 0, rowSize);
+    }
+}
+
+void GLMock::shaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::texImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::textureUploads);
+}
+
+void GLMock::texParameteri(GLenum target, GLenum pname, GLint param) {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::textureUploads);
+}
+
+void GLMock::uniform1f(GLint location, GLfloat v0) {
+    _uniform(location, &v0, sizeof(v0));
+}
+
+void GLMock::uniform1i(GLint location, GLint v0) {
+    _uniform(location, &v0, sizeof(v0));
+}
+
+void GLMock::uniform2f(GLint location, GLfloat v0, GLfloat v1) {
+    GLfloat value[2] = {v0, v1};
+    _uniform(location, value, sizeof(value));
+}
+
+void GLMock::uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+    GLfloat value[3] = {v0, v1, v2};
+    _uniform(location, value, sizeof(value));
+}
+
+void GLMock::uniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    _uniform(location, value, sizeof(GLfloat) * 9 * count);
+}
+
+void GLMock::uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    _uniform(location, value, sizeof(GLfloat) * 16 * count);
+}
+
+GLboolean GLMock::unmapBuffer(GLenum target) {
+    _count(&Stats::totalCalls);
+    return GL_TRUE;
+}
+
+void GLMock::useProgram(GLuint program) {
+    _count(&Stats::totalCalls);
+    _count(&Stats::programSwitches);
+    if (program == _curProgram)
+        _count(&Stats::redundantProgramSwitches);
+    _curProgram = program;
+}
+
+void GLMock::vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
+    _count(&Stats::totalCalls);
+}
+
+void GLMock::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    _count(&Stats::totalCalls);
+    if (_viewport[0] == x && _viewport[1] == y && _viewport[2] == width && _viewport[3] == height)
+        return;
+    _count(&Stats::viewportChanges);
+    _viewport[0] = x;
+    _viewport[1] = y;
+    _viewport[2] = width;
+    _viewport[3] = height;
+}
+
+NS_GI_END
+
+#endif // ENABLE_GL_MOCK
@@ -0,0 +1,192 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLMock_hpp
+#define GLMock_hpp
+
+#include "macros.h"
+
+#if ENABLE_GL_MOCK
+
+#if PLATFORM == PLATFORM_IOS
+#import <OpenGLES/ES2/gl.h>
+#import <OpenGLES/ES2/glext.h>
+#else
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#endif
+
+NS_GI_BEGIN
+
+// GLMock replaces the GL driver with recording stubs. It never touches a GPU,
+// hands out deterministic object names and counts the calls made per frame,
+// so the CPU overhead of the graph can be measured on a machine without GL.
+// Objects, bindings and counters are per thread, as if every thread had a GL
+// context of its own current.
+// The GPUImage-x-benchmark executable of the GPUIMAGE_GL_MOCK CMake build
+// runs typical graphs on it and checks every frame against a budget.
+class GLMock {
+public:
+    struct Stats {
+        int totalCalls;
+        int drawCalls;
+        int clears;
+        int programSwitches;
+        int redundantProgramSwitches;
+        int framebufferBinds;
+        int textureBinds;
+        int redundantBinds;
+        int uniformUploads;
+        int redundantUniformUploads;
+        int viewportChanges;
+        int textureUploads;
+        int readbacks;
+
+        Stats();
+        void reset(int value = 0);
+    };
+
+    // begin a new frame, counters of the current frame are cleared
+    static void beginFrame();
+    // end the current frame, return false if any counter exceeds the frame budget
+    static bool endFrame();
+
+    static const Stats& getFrameStats() { return _frameStats; }
+    static const Stats& getTotalStats() { return _totalStats; }
+    static int getFrameCount() { return _frameCount; }
+
+    // A counter set to -1 in the budget is not checked.
+    static void setFrameBudget(const Stats& budget) { _frameBudget = budget; }
+    static Stats unlimitedBudget();
+
+    // forget all GL objects and bindings, and clear the counters
+    static void reset();
+
+    // report a GLES 3.0 context from glGetString(GL_VERSION), on by default
+    static void setGLES3Available(bool available) { _gles3Available = available; }
+
+    // recording stubs
+    static void activeTexture(GLenum texture);
+    static void attachShader(GLuint program, GLuint shader);
+    static void bindBuffer(GLenum target, GLuint buffer);
+    static void bindFramebuffer(GLenum target, GLuint framebuffer);
+    static void bindTexture(GLenum target, GLuint texture);
+    static void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+    static void clear(GLbitfield mask);
+    static void clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+    static void compileShader(GLuint shader);
+    static GLuint createProgram();
+    static GLuint createShader(GLenum type);
+    static GLenum clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+    static void deleteBuffers(GLsizei n, const GLuint* buffers);
+    static void deleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+    static void deleteProgram(GLuint program);
+    static void deleteShader(GLuint shader);
+    static void deleteSync(GLsync sync);
+    static void deleteTextures(GLsizei n, const GLuint* textures);
+    static void drawArrays(GLenum mode, GLint first, GLsizei count);
+    static void enableVertexAttribArray(GLuint index);
+    static GLsync fenceSync(GLenum condition, GLbitfield flags);
+    static void flush();
+    static void framebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+    static void genBuffers(GLsizei n, GLuint* buffers);
+    static void genFramebuffers(GLsizei n, GLuint* framebuffers);
+    static void genTextures(GLsizei n, GLuint* textures);
+    static GLint getAttribLocation(GLuint program, const GLchar* name);
+    static GLenum getError();
+    static const GLubyte* getString(GLenum name);
+    static GLint getUniformLocation(GLuint program, const GLchar* name);
+    static void linkProgram(GLuint program);
+    static void* mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    static void pixelStorei(GLenum pname, GLint param);
+    static void readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels);
+    static void shaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+    static void texImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+    static void texParameteri(GLenum target, GLenum pname, GLint param);
+    static void texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+    static void uniform1f(GLint location, GLfloat v0);
+    static void uniform1i(GLint location, GLint v0);
+    static void uniform2f(GLint location, GLfloat v0, GLfloat v1);
+    static void uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+    static void uniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+    static void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+    static GLboolean unmapBuffer(GLenum target);
+    static void useProgram(GLuint program);
+    static void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+private:
+    static thread_local Stats _frameStats;
+    static thread_local Stats _totalStats;
+    static Stats _frameBudget;
+    static thread_local int _frameCount;
+    static bool _gles3Available;
+
+    static void _count(int Stats::* counter, int n = 1);
+    static void _uniform(GLint location, const void* value, int size);
+};
+
+NS_GI_END
+
+#define glActiveTexture             GPUImage::GLMock::activeTexture
+#define glAttachShader              GPUImage::GLMock::attachShader
+#define glBindBuffer                GPUImage::GLMock::bindBuffer
+#define glBindFramebuffer           GPUImage::GLMock::bindFramebuffer
+#define glBindTexture               GPUImage::GLMock::bindTexture
+#define glBufferData                GPUImage::GLMock::bufferData
+#define glClear                     GPUImage::GLMock::clear
+#define glClearColor                GPUImage::GLMock::clearColor
+#define glCompileShader             GPUImage::GLMock::compileShader
+#define glCreateProgram             GPUImage::GLMock::createProgram
+#define glCreateShader              GPUImage::GLMock::createShader
+#define glDeleteBuffers             GPUImage::GLMock::deleteBuffers
+#define glDeleteFramebuffers        GPUImage::GLMock::deleteFramebuffers
+#define glDeleteProgram             GPUImage::GLMock::deleteProgram
+#define glDeleteShader              GPUImage::GLMock::deleteShader
+#define glDeleteTextures            GPUImage::GLMock::deleteTextures
+#define glDrawArrays                GPUImage::GLMock::drawArrays
+#define glEnableVertexAttribArray   GPUImage::GLMock::enableVertexAttribArray
+#define glFlush                     GPUImage::GLMock::flush
+#define glFramebufferTexture2D      GPUImage::GLMock::framebufferTexture2D
+#define glGenBuffers                GPUImage::GLMock::genBuffers
+#define glGenFramebuffers           GPUImage::GLMock::genFramebuffers
+#define glGenTextures               GPUImage::GLMock::genTextures
+#define glGetAttribLocation         GPUImage::GLMock::getAttribLocation
+#define glGetError                  GPUImage::GLMock::getError
+#define glGetString                 GPUImage::GLMock::getString
+#define glGetUniformLocation        GPUImage::GLMock::getUniformLocation
+#define glLinkProgram               GPUImage::GLMock::linkProgram
+#define glPixelStorei               GPUImage::GLMock::pixelStorei
+#define glReadPixels                GPUImage::GLMock::readPixels
+#define glShaderSource              GPUImage::GLMock::shaderSource
+#define glTexImage2D                GPUImage::GLMock::texImage2D
+#define glTexParameteri             GPUImage::GLMock::texParameteri
+#define glTexSubImage2D             GPUImage::GLMock::texSubImage2D
+#define glUniform1f                 GPUImage::GLMock::uniform1f
+#define glUniform1i                 GPUImage::GLMock::uniform1i
+#define glUniform2f                 GPUImage::GLMock::uniform2f
+#define glUniform3f                 GPUImage::GLMock::uniform3f
+#define glUniformMatrix3fv          GPUImage::GLMock::uniformMatrix3fv
+#define glUniformMatrix4fv          GPUImage::GLMock::uniformMatrix4fv
+#define glUseProgram                GPUImage::GLMock::useProgram
+#define glVertexAttribPointer       GPUImage::GLMock::vertexAttribPointer
+#define glViewport                  GPUImage::GLMock::viewport
+
+#endif // ENABLE_GL_MOCK
+
+#endif /* GLMock_hpp */
@@ -24,14 +24,18 @@
 NS_GI_BEGIN
 
 std::vector<GLProgram*> GLProgram::_programs;
+std::mutex GLProgram::_programsMutex;
 
 GLProgram::GLProgram()
-:_program(-1)
+:_context(Context::getCurrent())
+,_program(-1)
 {
+    std::lock_guard<std::mutex> lock(_programsMutex);
     _programs.push_back(this);
 }
 
 GLProgram::~GLProgram() {
+    std::unique_lock<std::mutex> lock(_programsMutex);
     std::vector<GLProgram*>::iterator itr = std::find(_programs.begin(), _programs.end(), this);
     if (itr != _programs.end()) {
         _programs.erase(itr);
@@ -40,6 +44,8 @@ GLProgram::~GLProgram() {
     bool bDeleteProgram = (_program != -1);
 
     for (auto const& program : _programs ) {
+        // object names are only unique within a context
+        if (program->_context != _context) continue;
         if (bDeleteProgram) {
             if (_program == program->getID()) {
                 bDeleteProgram = false;
@@ -47,9 +53,11 @@ GLProgram::~GLProgram() {
             }
         }
     }
+    lock.unlock();
 
     if (bDeleteProgram) {
-        glDeleteProgram(_program);
+        GLuint program = _program;
+        Context::deferDeletion(_context, [program]() { glDeleteProgram(program); });
         _program = -1;
     }
 }
@@ -96,6 +104,10 @@ bool GLProgram::_initWithShaderString(const std::string& vertexShaderSource, con
     return true;
 }
 
+Context* GLProgram::_getContext() const {
+    return _context ? _context : Context::getDefault();
+}
+
 void GLProgram::use() {
     CHECK_GL(glUseProgram(_program));
 }
@@ -110,52 +122,62 @@ GLuint GLProgram::getUniformLocation(const std::string& uniformName) {
 
 
 void GLProgram::setUniformValue(const std::string& uniformName, int value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     setUniformValue(getUniformLocation(uniformName), value);
 }
 
 void GLProgram::setUniformValue(const std::string& uniformName, float value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     setUniformValue(getUniformLocation(uniformName), value);
 }
 
 void GLProgram::setUniformValue(const std::string& uniformName, Matrix4 value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     setUniformValue(getUniformLocation(uniformName), value);
 }
 
 void GLProgram::setUniformValue(const std::string& uniformName, Vector2 value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
+    setUniformValue(getUniformLocation(uniformName), value);
+}
+
+void GLProgram::setUniformValue(const std::string& uniformName, Vector3 value) {
+    _getContext()->setActiveShaderProgram(this);
     setUniformValue(getUniformLocation(uniformName), value);
 }
 
 void GLProgram::setUniformValue(const std::string& uniformName, Matrix3 value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     setUniformValue(getUniformLocation(uniformName), value);
 }
 
 void GLProgram::setUniformValue(int uniformLocation, int value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     CHECK_GL(glUniform1i(uniformLocation, value));
 }
 
 void GLProgram::setUniformValue(int uniformLocation, float value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     CHECK_GL(glUniform1f(uniformLocation, value));
 }
 
 void GLProgram::setUniformValue(int uniformLocation, Matrix4 value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     CHECK_GL(glUniformMatrix4fv(uniformLocation, 1, GL_FALSE, (GLfloat *)&value));
 }
 
 void GLProgram::setUniformValue(int uniformLocation, Vector2 value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     CHECK_GL(glUniform2f(uniformLocation, value.x, value.y));
 }
 
+void GLProgram::setUniformValue(int uniformLocation, Vector3 value) {
+    _getContext()->setActiveShaderProgram(this);
+    CHECK_GL(glUniform3f(uniformLocation, value.x, value.y, value.z));
+}
+
 void GLProgram::setUniformValue(int uniformLocation, Matrix3 value) {
-    Context::getInstance()->setActiveShaderProgram(this);
+    _getContext()->setActiveShaderProgram(this);
     CHECK_GL(glUniformMatrix3fv(uniformLocation, 1, GL_FALSE, (GLfloat *)&value));
 }
 
@@ -28,11 +28,14 @@
 #import <OpenGLES/ES2/gl.h>
 #import <OpenGLES/ES2/glext.h>
 #endif
+#include "GLMock.hpp"
+#include <mutex>
 #include <vector>
 #include "math.hpp"
 
 NS_GI_BEGIN
 
+class Context;
 class GLProgram{
 public:
     GLProgram();
@@ -48,18 +51,24 @@ public:
     void setUniformValue(const std::string& uniformName, int value);
     void setUniformValue(const std::string& uniformName, float value);
     void setUniformValue(const std::string& uniformName, Vector2 value);
+    void setUniformValue(const std::string& uniformName, Vector3 value);
     void setUniformValue(const std::string& uniformName, Matrix3 value);
     void setUniformValue(const std::string& uniformName, Matrix4 value);
     
     void setUniformValue(int uniformLocation, int value);
     void setUniformValue(int uniformLocation, float value);
     void setUniformValue(int uniformLocation, Vector2 value);
+    void setUniformValue(int uniformLocation, Vector3 value);
     void setUniformValue(int uniformLocation, Matrix3 value);
     void setUniformValue(int uniformLocation, Matrix4 value);
     
 private:
     static std::vector<GLProgram*> _programs;
+    static std::mutex _programsMutex;
+    // the context it was made in, 0 for the default one
+    Context* _context;
     GLuint _program;
+    Context* _getContext() const;
     bool _initWithShaderString(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
 };
 
@@ -2,15 +2,81 @@
 
 #include <jni.h>
 #include <string>
+#include <memory>
+#include <vector>
 #include <android/bitmap.h>
 #include "source/SourceImage.h"
 #include "source/SourceCamera.h"
 #include "target/TargetView.h"
 #include "filter/Filter.hpp"
 #include "Context.hpp"
+#include "YUVConverter.hpp"
+#include "target/ReadbackTarget.hpp"
+#include "target/YUVTarget.hpp"
+#include "target/TensorTarget.hpp"
+#include "MultiCapture.hpp"
+#include "FramePipeline.hpp"
 
 USING_NS_GI
 
+// A global reference to a Java callback, deleted with the last copy of the
+// native callback holding it, even if a queued read is dropped.
+static std::shared_ptr<_jobject> _newCallbackRef(JNIEnv* env, jobject jCallback, JavaVM*& vm) {
+    env->GetJavaVM(&vm);
+    JavaVM* javaVM = vm;
+    return std::shared_ptr<_jobject>(env->NewGlobalRef(jCallback), [javaVM](jobject ref) {
+        JNIEnv* env = 0;
+        if (javaVM->GetEnv((void**)&env, JNI_VERSION_1_6) == JNI_OK) {
+            env->DeleteGlobalRef(ref);
+        }
+    });
+}
+
+// Wraps a GPUImageSource.FrameDataCallback for the readback queue. A frame
+// holds width * height * sizeNumerator / sizeDenominator bytes, RGBA by default.
+static ReadbackQueue::Callback _frameDataCallback(JNIEnv* env, jobject jCallback, int sizeNumerator = 4, int sizeDenominator = 1) {
+    JavaVM* vm = 0;
+    std::shared_ptr<_jobject> callback = _newCallbackRef(env, jCallback, vm);
+
+    return [vm, callback, sizeNumerator, sizeDenominator](const unsigned char* pixels, int width, int height) {
+        // delivered on the GL thread, which is attached by GLSurfaceView
+        JNIEnv* env = 0;
+        if (vm->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK) return;
+
+        int frameSize = width * height * sizeNumerator / sizeDenominator;
+        jbyteArray jdata = env->NewByteArray(frameSize);
+        env->SetByteArrayRegion(jdata, 0, frameSize, (const jbyte*)pixels);
+
+        jclass callbackClass = env->GetObjectClass(callback.get());
+        jmethodID onResult = env->GetMethodID(callbackClass, "onResult", "([BII)V");
+        env->CallVoidMethod(callback.get(), onResult, jdata, width, height);
+        env->DeleteLocalRef(callbackClass);
+        env->DeleteLocalRef(jdata);
+    };
+}
+
+// Wraps a GPUImageMultiCapture.MultiFrameDataCallback, with the bytes per pixel
+// of every capture point.
+static MultiCapture::Callback _multiFrameDataCallback(JNIEnv* env, jobject jCallback, const std::vector<int>& bytesPerPixel) {
+    JavaVM* vm = 0;
+    std::shared_ptr<_jobject> callback = _newCallbackRef(env, jCallback, vm);
+
+    return [vm, callback, bytesPerPixel](int pointIndex, const unsigned char* pixels, int width, int height) {
+        JNIEnv* env = 0;
+        if (vm->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK) return;
+
+        int frameSize = width * height * bytesPerPixel[pointIndex];
+        jbyteArray jdata = env->NewByteArray(frameSize);
+        env->SetByteArrayRegion(jdata, 0, frameSize, (const jbyte*)pixels);
+
+        jclass callbackClass = env->GetObjectClass(callback.get());
+        jmethodID onResult = env->GetMethodID(callbackClass, "onResult", "(I[BII)V");
+        env->CallVoidMethod(callback.get(), onResult, pointIndex, jdata, width, height);
+        env->DeleteLocalRef(callbackClass);
+        env->DeleteLocalRef(jdata);
+    };
+}
+
 extern "C"
 jlong Java_com_jin_gpuimage_GPUImage_nativeSourceImageNew(
         JNIEnv *env,
@@ -102,6 +168,93 @@ void Java_com_jin_gpuimage_GPUImage_nativeSourceCameraSetFrame(
     env->ReleasePrimitiveArrayCritical(jdata, data, 0);
 };
 
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeSourceCameraSetYUVFrame(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jint width,
+        jint height,
+        jbyteArray jdata,
+        jint yuvFormat,
+        jint rotation)
+{
+    jbyte* data = (jbyte*) (env->GetPrimitiveArrayCritical(jdata, 0));
+    ((SourceCamera*)classId)->setYUVFrameData(width, height, data, (SourceCamera::YUVFormat)yuvFormat, (RotationMode)rotation);
+    env->ReleasePrimitiveArrayCritical(jdata, data, JNI_ABORT);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeSourceCameraSetYUVColorSpace(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jint yuvColorSpace)
+{
+    ((SourceCamera*)classId)->setYUVColorSpace((SourceCamera::YUVColorSpace)yuvColorSpace);
+};
+
+extern "C"
+jboolean Java_com_jin_gpuimage_GPUImage_nativeSourceCameraQueueYUVFrame(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jint width,
+        jint height,
+        jbyteArray jdata,
+        jint yuvFormat,
+        jint rotation)
+{
+    // not a critical section, the Block policy may wait here
+    jbyte* data = env->GetByteArrayElements(jdata, 0);
+    bool isQueued = ((SourceCamera*)classId)->queueYUVFrameData(width, height, data, (SourceCamera::YUVFormat)yuvFormat, (RotationMode)rotation);
+    env->ReleaseByteArrayElements(jdata, data, JNI_ABORT);
+    return isQueued;
+};
+
+extern "C"
+jint Java_com_jin_gpuimage_GPUImage_nativeSourceCameraProcessQueuedFrame(
+        JNIEnv *env,
+        jobject,
+        jlong classId)
+{
+    SourceCamera* sourceCamera = (SourceCamera*)classId;
+    sourceCamera->processQueuedFrame();
+    return sourceCamera->getFrameQueue().getCounters().pendingCount;
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeSourceCameraSetFramePolicy(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jint policy,
+        jint capacity)
+{
+    ((SourceCamera*)classId)->setFramePolicy((FrameQueue::Policy)policy, capacity);
+};
+
+extern "C"
+jdoubleArray Java_com_jin_gpuimage_GPUImage_nativeSourceCameraGetFrameCounters(
+        JNIEnv *env,
+        jobject,
+        jlong classId)
+{
+    // in the order of GPUImageSourceCamera.FrameCounters
+    FrameQueue::Counters counters = ((SourceCamera*)classId)->getFrameQueue().getCounters();
+    jdouble values[] = {
+        (jdouble)counters.queuedCount,
+        (jdouble)counters.droppedCount,
+        (jdouble)counters.processedCount,
+        (jdouble)counters.pendingCount,
+        counters.averageLatencyMs,
+        counters.maxLatencyMs
+    };
+    jdoubleArray jresult = env->NewDoubleArray(6);
+    env->SetDoubleArrayRegion(jresult, 0, 6, values);
+    return jresult;
+};
+
 extern "C"
 jlong Java_com_jin_gpuimage_GPUImage_nativeSourceAddTarget(
         JNIEnv *env,
@@ -142,6 +295,62 @@ void Java_com_jin_gpuimage_GPUImage_nativeSourceRemoveAllTargets(
     ((Source *) classId)->removeAllTargets();
 };
 
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeSourceSetGraphOptimizationEnabled(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jboolean enabled)
+{
+    ((Source *) classId)->setGraphOptimizationEnabled(enabled);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeSourceSetPullEvaluationEnabled(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jboolean enabled)
+{
+    ((Source *) classId)->setPullEvaluationEnabled(enabled);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeSourceSetFramesInFlight(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jint depth)
+{
+    ((Source *) classId)->setFramesInFlight(depth);
+};
+
+extern "C"
+jdoubleArray Java_com_jin_gpuimage_GPUImage_nativeSourceGetFramePipelineStats(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jint depth)
+{
+    FramePipeline* framePipeline = ((Source *) classId)->getFramePipeline();
+    if (!framePipeline) return 0;
+
+    // in the order of GPUImageSource.FramePipelineStats
+    FramePipeline::Stats stats = framePipeline->getStats(depth);
+    jdouble values[] = {
+        (jdouble)stats.depth,
+        (jdouble)stats.frameCount,
+        stats.averageLatencyMs,
+        stats.averageStallMs,
+        stats.framesPerSecond,
+        stats.addedLatencyMs,
+        stats.throughputGain
+    };
+    jdoubleArray jresult = env->NewDoubleArray(7);
+    env->SetDoubleArrayRegion(jresult, 0, 7, values);
+    return jresult;
+};
+
 extern "C"
 jlong Java_com_jin_gpuimage_GPUImage_nativeSourceProceed(
         JNIEnv *env,
@@ -179,21 +388,68 @@ jbyteArray Java_com_jin_gpuimage_GPUImage_nativeSourceCaptureAProcessedFrameData
         jint width,
         jint height )
 {
-    unsigned char* processedFrameData = ((Source *) classId)->captureAProcessedFrameData((Filter*)upToFilterClassId, width, height);
-    int frameSize = width * height * 4 * sizeof(unsigned char);
+    // pooled memory saves allocating and freeing a frame on every capture
+    FrameData* frameData = ((Source *) classId)->captureAProcessedFrameDataToPool((Filter*)upToFilterClassId, width, height);
 
     jbyteArray jresult = NULL;
-    if (processedFrameData) {
-        jbyte* by = (jbyte*)processedFrameData;
-        jresult = env->NewByteArray(frameSize);
-        env->SetByteArrayRegion(jresult, 0, frameSize, by);
-        delete[] processedFrameData;
-        processedFrameData = 0;
+    if (frameData) {
+        jresult = env->NewByteArray(frameData->getSize());
+        env->SetByteArrayRegion(jresult, 0, frameData->getSize(), (const jbyte*)frameData->getData());
+        frameData->release();
     }
 
     return jresult;
 };
 
+extern "C"
+jboolean Java_com_jin_gpuimage_GPUImage_nativeSourceCaptureAProcessedFrameDataToBuffer(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jlong upToFilterClassId,
+        jint width,
+        jint height,
+        jobject jBuffer,
+        jint stride)
+{
+    unsigned char* pixels = (unsigned char*)env->GetDirectBufferAddress(jBuffer);
+    if (!pixels) {
+        Log("WARNING", "nativeSourceCaptureAProcessedFrameDataToBuffer: not a direct buffer");
+        return false;
+    }
+    if (stride <= 0) stride = width * 4;
+    if (env->GetDirectBufferCapacity(jBuffer) < (jlong)stride * (height - 1) + width * 4) {
+        Log("WARNING", "nativeSourceCaptureAProcessedFrameDataToBuffer: buffer too small for a %dx%d capture", width, height);
+        return false;
+    }
+    return ((Source *) classId)->captureAProcessedFrameDataInto((Filter*)upToFilterClassId, pixels, stride, width, height);
+};
+
+extern "C"
+jlong Java_com_jin_gpuimage_GPUImage_nativeSourceCaptureAProcessedFrameDataToPool(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jlong upToFilterClassId,
+        jint width,
+        jint height)
+{
+    return (uintptr_t)((Source *) classId)->captureAProcessedFrameDataToPool((Filter*)upToFilterClassId, width, height);
+};
+
+extern "C"
+jboolean Java_com_jin_gpuimage_GPUImage_nativeSourceCaptureAProcessedFrameDataAsync(
+        JNIEnv *env,
+        jobject,
+        jlong classId,
+        jlong upToFilterClassId,
+        jint width,
+        jint height,
+        jobject jCallback)
+{
+    return ((Source *) classId)->captureAProcessedFrameDataAsync((Filter*)upToFilterClassId, _frameDataCallback(env, jCallback), width, height);
+};
+
 extern "C"
 jlong Java_com_jin_gpuimage_GPUImage_nativeTargetViewNew(
         JNIEnv *env,
@@ -307,6 +563,336 @@ void Java_com_jin_gpuimage_GPUImage_nativeFilterSetPropertyString(
 
 };
 
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeFilterSetInputSynchronization(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jboolean enabled,
+        jdouble toleranceMs,
+        jint depth)
+{
+    ((Filter*)classId)->setInputSynchronization(enabled, (int64_t)(toleranceMs * 1000000.0), depth);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeFilterSetInputSyncRule(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint texIdx,
+        jint rule)
+{
+    ((Filter*)classId)->setInputSyncRule(texIdx, (Target::InputSyncRule)rule);
+};
+
+extern "C"
+jdoubleArray Java_com_jin_gpuimage_GPUImage_nativeFilterGetInputSyncStats(
+        JNIEnv *env,
+        jobject,
+        jlong classId)
+{
+    // in the order of GPUImageFilter.InputSyncStats
+    Target::InputSyncStats stats = ((Filter*)classId)->getInputSyncStats();
+    jdouble values[] = {
+        (jdouble)stats.matchedCount,
+        (jdouble)stats.droppedCount,
+        (jdouble)stats.reusedCount,
+        (jdouble)stats.pendingCount
+    };
+    jdoubleArray jresult = env->NewDoubleArray(4);
+    env->SetDoubleArrayRegion(jresult, 0, 4, values);
+    return jresult;
+};
+
+extern "C"
+jlong Java_com_jin_gpuimage_GPUImage_nativeReadbackTargetNew(
+        JNIEnv *env,
+        jobject obj,
+        jobject jCallback)
+{
+    return (uintptr_t)ReadbackTarget::create(_frameDataCallback(env, jCallback));
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeReadbackTargetFinalize(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId)
+{
+    ((ReadbackTarget*)classId)->release();
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeReadbackTargetSetOutputSize(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint width,
+        jint height)
+{
+    ((ReadbackTarget*)classId)->setOutputSize(width, height);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeReadbackTargetSetOutputFormat(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint format,
+        jobject jCallback)
+{
+    // reads already queued keep the callback, and frame size, they were issued with
+    ReadbackTarget* readbackTarget = (ReadbackTarget*)classId;
+    readbackTarget->setOutputFormat((ReadbackTarget::Format)format);
+    readbackTarget->setCallback(_frameDataCallback(env, jCallback, ReadbackTarget::getBytesPerPixel((ReadbackTarget::Format)format)));
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeReadbackTargetSetCropRegion(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jfloat x,
+        jfloat y,
+        jfloat width,
+        jfloat height)
+{
+    ((ReadbackTarget*)classId)->setCropRegion(x, y, width, height);
+};
+
+extern "C"
+jlong Java_com_jin_gpuimage_GPUImage_nativeYUVTargetNew(
+        JNIEnv *env,
+        jobject obj,
+        jint layout,
+        jobject jCallback)
+{
+    // 4:2:0 planes hold 1.5 bytes per pixel
+    return (uintptr_t)YUVTarget::create((YUVTarget::Layout)layout, _frameDataCallback(env, jCallback, 3, 2));
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeYUVTargetFinalize(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId)
+{
+    ((YUVTarget*)classId)->release();
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeYUVTargetSetOutputSize(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint width,
+        jint height)
+{
+    ((YUVTarget*)classId)->setOutputSize(width, height);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeYUVTargetSetYUVColorSpace(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint yuvColorSpace)
+{
+    ((YUVTarget*)classId)->setYUVColorSpace((YUVTarget::YUVColorSpace)yuvColorSpace);
+};
+
+extern "C"
+jlong Java_com_jin_gpuimage_GPUImage_nativeTensorTargetNew(
+        JNIEnv *env,
+        jobject obj,
+        jint width,
+        jint height,
+        jint dataType,
+        jobject jCallback)
+{
+    int bytesPerPixel = 3 * TensorTarget::getBytesPerElement((TensorTarget::DataType)dataType);
+    return (uintptr_t)TensorTarget::create(width, height, (TensorTarget::DataType)dataType, _frameDataCallback(env, jCallback, bytesPerPixel));
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeTensorTargetFinalize(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId)
+{
+    ((TensorTarget*)classId)->release();
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeTensorTargetSetOutputSize(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint width,
+        jint height)
+{
+    ((TensorTarget*)classId)->setOutputSize(width, height);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeTensorTargetSetDataType(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint dataType,
+        jobject jCallback)
+{
+    // reads already queued keep the callback, and tensor size, they were issued with
+    TensorTarget* tensorTarget = (TensorTarget*)classId;
+    tensorTarget->setDataType((TensorTarget::DataType)dataType);
+    tensorTarget->setCallback(_frameDataCallback(env, jCallback, 3 * TensorTarget::getBytesPerElement((TensorTarget::DataType)dataType)));
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeTensorTargetSetLayout(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint layout)
+{
+    ((TensorTarget*)classId)->setLayout((TensorTarget::Layout)layout);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeTensorTargetSetFillMode(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint fillMode)
+{
+    ((TensorTarget*)classId)->setFillMode((TensorTarget::FillMode)fillMode);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeTensorTargetSetPaddingColor(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jfloat r,
+        jfloat g,
+        jfloat b)
+{
+    ((TensorTarget*)classId)->setPaddingColor(r, g, b);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeTensorTargetSetNormalization(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jfloatArray jMean,
+        jfloatArray jStd)
+{
+    if (env->GetArrayLength(jMean) < 3 || env->GetArrayLength(jStd) < 3) return;
+    float mean[3], std[3];
+    env->GetFloatArrayRegion(jMean, 0, 3, mean);
+    env->GetFloatArrayRegion(jStd, 0, 3, std);
+    ((TensorTarget*)classId)->setNormalization(mean, std);
+};
+
+extern "C"
+jlong Java_com_jin_gpuimage_GPUImage_nativeMultiCaptureNew(
+        JNIEnv *env,
+        jobject obj)
+{
+    return (uintptr_t)(new MultiCapture());
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeMultiCaptureFinalize(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId)
+{
+    delete (MultiCapture*)classId;
+};
+
+extern "C"
+jint Java_com_jin_gpuimage_GPUImage_nativeMultiCaptureAddCapturePoint(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jlong filterClassId,
+        jint width,
+        jint height,
+        jint format)
+{
+    return ((MultiCapture*)classId)->addCapturePoint((Filter*)filterClassId, width, height, (ReadbackTarget::Format)format);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeMultiCaptureSetCapturePointCropRegion(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jint index,
+        jfloat x,
+        jfloat y,
+        jfloat width,
+        jfloat height)
+{
+    ((MultiCapture*)classId)->setCapturePointCropRegion(index, x, y, width, height);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeMultiCaptureRemoveAllCapturePoints(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId)
+{
+    ((MultiCapture*)classId)->removeAllCapturePoints();
+};
+
+extern "C"
+jboolean Java_com_jin_gpuimage_GPUImage_nativeMultiCaptureCapture(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId,
+        jlong sourceClassId,
+        jobject jCallback)
+{
+    MultiCapture* multiCapture = (MultiCapture*)classId;
+    std::vector<int> bytesPerPixel;
+    for (int i = 0; i < multiCapture->getCapturePointCount(); ++i) {
+        bytesPerPixel.push_back(ReadbackTarget::getBytesPerPixel(multiCapture->getCapturePointFormat(i)));
+    }
+    return multiCapture->capture((Source*)sourceClassId, _multiFrameDataCallback(env, jCallback, bytesPerPixel));
+};
+
+extern "C"
+jobject Java_com_jin_gpuimage_GPUImage_nativeFrameDataGetBuffer(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId)
+{
+    FrameData* frameData = (FrameData*)classId;
+    return env->NewDirectByteBuffer(frameData->getData(), frameData->getSize());
+};
+
+extern "C"
+jint Java_com_jin_gpuimage_GPUImage_nativeFrameDataGetStride(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId)
+{
+    return ((FrameData*)classId)->getStride();
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeFrameDataRelease(
+        JNIEnv *env,
+        jobject obj,
+        jlong classId)
+{
+    ((FrameData*)classId)->release();
+};
+
 extern "C"
 void Java_com_jin_gpuimage_GPUImage_nativeContextInit(
         JNIEnv *env,
@@ -331,62 +917,176 @@ void Java_com_jin_gpuimage_GPUImage_nativeContextPurge(
     Context::getInstance()->purge();
 };
 
+extern "C"
+jint Java_com_jin_gpuimage_GPUImage_nativeContextPollReadbacks(
+        JNIEnv *env,
+        jobject obj)
+{
+    ReadbackQueue* readbackQueue = Context::getInstance()->getReadbackQueue();
+    readbackQueue->poll();
+    return readbackQueue->getPendingCount();
+};
 
 extern "C"
-void Java_com_jin_gpuimage_GPUImage_nativeYUVtoRBGA(JNIEnv * env, jobject obj, jbyteArray yuv420sp, jint width, jint height, jintArray rgbOut)
+jlong Java_com_jin_gpuimage_GPUImage_nativeContextGetDeliveredTimestamp(
+        JNIEnv *env,
+        jobject obj)
 {
-    int             sz;
-    int             i;
-    int             j;
-    int             Y;
-    int             Cr = 0;
-    int             Cb = 0;
-    int             pixPtr = 0;
-    int             jDiv2 = 0;
-    int             R = 0;
-    int             G = 0;
-    int             B = 0;
-    int             cOff;
-    int w = width;
-    int h = height;
-    sz = w * h;
-
-    jint *rgbData = (jint*) (env->GetPrimitiveArrayCritical(rgbOut, 0));
-    jbyte* yuv = (jbyte*) env->GetPrimitiveArrayCritical(yuv420sp, 0);
-
-    for(j = 0; j < h; j++) {
-        pixPtr = j * w;
-        jDiv2 = j >> 1;
-        for(i = 0; i < w; i++) {
-            Y = yuv[pixPtr];
-            if(Y < 0) Y += 255;
-            if((i & 0x1) != 1) {
-                cOff = sz + jDiv2 * w + (i >> 1) * 2;
-                Cb = yuv[cOff];
-                if(Cb < 0) Cb += 127; else Cb -= 128;
-                Cr = yuv[cOff + 1];
-                if(Cr < 0) Cr += 127; else Cr -= 128;
-            }
-
-            //ITU-R BT.601 conversion
-            //
-            //R = 1.164*(Y-16) + 2.018*(Cr-128);
-            //G = 1.164*(Y-16) - 0.813*(Cb-128) - 0.391*(Cr-128);
-            //B = 1.164*(Y-16) + 1.596*(Cb-128);
-            //
-            Y = Y + (Y >> 3) + (Y >> 5) + (Y >> 7);
-            R = Y + (Cr << 1) + (Cr >> 6);
-            if(R < 0) R = 0; else if(R > 255) R = 255;
-            G = Y - Cb + (Cb >> 3) + (Cb >> 4) - (Cr >> 1) + (Cr >> 3);
-            if(G < 0) G = 0; else if(G > 255) G = 255;
-            B = Y + Cb + (Cb >> 1) + (Cb >> 4) + (Cb >> 5);
-            if(B < 0) B = 0; else if(B > 255) B = 255;
-            rgbData[pixPtr++] = 0xff000000 + (R << 16) + (G << 8) + B;
-        }
+    return Context::getInstance()->getReadbackQueue()->getDeliveredTimestamp();
+};
+
+extern "C"
+jdoubleArray Java_com_jin_gpuimage_GPUImage_nativeFrameMetricsGetStats(
+        JNIEnv *env,
+        jobject obj,
+        jint metric)
+{
+    // in the order of the GPUImageFrameMetrics constructor
+    FrameMetrics::Stats stats = Context::getInstance()->getFrameMetrics()->getStats((FrameMetrics::Metric)metric);
+    jdouble values[] = {
+        (jdouble)stats.count,
+        stats.p50,
+        stats.p95,
+        stats.p99,
+        stats.max,
+        stats.mean
+    };
+    jdoubleArray jresult = env->NewDoubleArray(6);
+    env->SetDoubleArrayRegion(jresult, 0, 6, values);
+    return jresult;
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeFrameMetricsReset(
+        JNIEnv *env,
+        jobject obj)
+{
+    Context::getInstance()->getFrameMetrics()->reset();
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeFrameMetricsSetWindow(
+        JNIEnv *env,
+        jobject obj,
+        jdouble windowSeconds)
+{
+    Context::getInstance()->getFrameMetrics()->setWindow(windowSeconds);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeFrameMetricsSetEnabled(
+        JNIEnv *env,
+        jobject obj,
+        jboolean enabled)
+{
+    Context::getInstance()->getFrameMetrics()->setEnabled(enabled);
+};
+
+static std::vector<float> _floatArrayToVector(JNIEnv *env, jfloatArray jArray) {
+    std::vector<float> values(env->GetArrayLength(jArray));
+    if (!values.empty()) {
+        env->GetFloatArrayRegion(jArray, 0, (jsize)values.size(), values.data());
     }
+    return values;
+}
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeQualityControllerSetFrameBudget(
+        JNIEnv *env,
+        jobject obj,
+        jdouble budgetMs)
+{
+    Context::getInstance()->getQualityController()->setFrameBudget(budgetMs);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeQualityControllerSetHysteresis(
+        JNIEnv *env,
+        jobject obj,
+        jint downgradeFrames,
+        jint upgradeFrames,
+        jdouble upgradeFraction)
+{
+    Context::getInstance()->getQualityController()->setHysteresis(downgradeFrames, upgradeFrames, upgradeFraction);
+};
 
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeQualityControllerAddFramebufferScaleKnob(
+        JNIEnv *env,
+        jobject obj,
+        jlong sourceClassId,
+        jfloatArray jScales)
+{
+    Context::getInstance()->getQualityController()->addFramebufferScaleKnob((Source*)sourceClassId, _floatArrayToVector(env, jScales));
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeQualityControllerAddPropertyKnob(
+        JNIEnv *env,
+        jobject obj,
+        jlong filterClassId,
+        jstring jProperty,
+        jfloatArray jValues)
+{
+    const char* property = env->GetStringUTFChars(jProperty, 0);
+    Context::getInstance()->getQualityController()->addPropertyKnob((Filter*)filterClassId, property, _floatArrayToVector(env, jValues));
+    env->ReleaseStringUTFChars(jProperty, property);
+};
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeQualityControllerRemoveAllKnobs(
+        JNIEnv *env,
+        jobject obj)
+{
+    Context::getInstance()->getQualityController()->removeAllKnobs();
+};
+
+extern "C"
+jdoubleArray Java_com_jin_gpuimage_GPUImage_nativeQualityControllerGetStats(
+        JNIEnv *env,
+        jobject obj)
+{
+    // in the order of the GPUImageQualityController constructor
+    QualityController::Stats stats = Context::getInstance()->getQualityController()->getStats();
+    jdouble values[] = {
+        stats.budgetMs,
+        stats.frameTimeMs,
+        (jdouble)stats.level,
+        (jdouble)stats.maxLevel,
+        (jdouble)stats.downgradeCount,
+        (jdouble)stats.upgradeCount
+    };
+    jdoubleArray jresult = env->NewDoubleArray(6);
+    env->SetDoubleArrayRegion(jresult, 0, 6, values);
+    return jresult;
+};
+
+
+extern "C"
+void Java_com_jin_gpuimage_GPUImage_nativeYUVtoRBGA(JNIEnv * env, jobject obj, jbyteArray yuv420sp, jint width, jint height, jintArray rgbOut)
+{
+    jint* rgbData = (jint*)env->GetPrimitiveArrayCritical(rgbOut, 0);
+    jbyte* yuv = (jbyte*)env->GetPrimitiveArrayCritical(yuv420sp, 0);
+
+    // the ints hold R, G, B, A bytes in memory, as nativeSourceCameraSetFrame
+    // uploads them with GL_RGBA
+    YUVConverter::convert((const unsigned char*)yuv, width, height, YUVConverter::NV21,
+                          (unsigned char*)rgbData, YUVConverter::RGBA);
+
+    env->ReleasePrimitiveArrayCritical(yuv420sp, yuv, JNI_ABORT);
     env->ReleasePrimitiveArrayCritical(rgbOut, rgbData, 0);
-    env->ReleasePrimitiveArrayCritical(yuv420sp, yuv, 0);
+}
+
+extern "C"
+jfloat Java_com_jin_gpuimage_GPUImage_nativeYUVConverterBenchmark(
+        JNIEnv *env,
+        jobject obj,
+        jint width,
+        jint height,
+        jint yuvFormat,
+        jint iterations)
+{
+    return YUVConverter::benchmark(width, height, (YUVConverter::SourceFormat)yuvFormat, YUVConverter::BGRA, iterations);
 }
 
 #endif
\ No newline at end of file
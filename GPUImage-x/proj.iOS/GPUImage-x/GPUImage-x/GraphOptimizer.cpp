@@ -0,0 +1,152 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GraphOptimizer.hpp"
+#include "filter/FilterGroup.hpp"
+#include "util.h"
+#include <algorithm>
+#include <map>
+#include <set>
+
+NS_GI_BEGIN
+
+GraphOptimizer::GraphOptimizer(Source* source)
+:_source(source)
+,_graphRevision(0)
+,_evaluated(false)
+,_mergedFilterCount(0)
+{
+}
+
+GraphOptimizer::~GraphOptimizer() {
+    _clear();
+}
+
+void GraphOptimizer::update() {
+    if (_evaluated && _graphRevision == Source::getGraphRevision()) return;
+
+    // read first, a change made while merging is picked up next time
+    unsigned int graphRevision = Source::getGraphRevision();
+    _clear();
+    _merge();
+    _graphRevision = graphRevision;
+    _evaluated = true;
+}
+
+void GraphOptimizer::_merge() {
+    struct Input {
+        Source* source;
+        int texIdx;
+    };
+
+    // the inputs of every filter reachable from the source
+    std::map<Filter*, std::vector<Input>> inputs;
+    std::vector<Filter*> filters;
+    std::vector<Source*> pending(1, _source);
+    std::set<Source*> visited(pending.begin(), pending.end());
+    for (size_t i = 0; i < pending.size(); ++i) {
+        // targets of a group hang off its terminal filter, which may not be set yet
+        if (i > 0 && dynamic_cast<FilterGroup*>(pending[i])) continue;
+
+        for (auto const& it : pending[i]->getTargets()) {
+            Filter* filter = dynamic_cast<Filter*>(it.first);
+            if (!filter) continue;
+            Input input = {pending[i], it.second};
+            inputs[filter].push_back(input);
+            if (visited.insert(filter).second) {
+                filters.push_back(filter);
+                pending.push_back(filter);
+            }
+        }
+    }
+
+    // Visit filters after all of their inputs, so a filter is keyed on what its
+    // inputs were merged into.
+    std::map<Source*, Source*> canonical;
+    canonical[_source] = _source;
+    std::map<std::string, Filter*> representatives;
+    std::map<Filter*, std::vector<Filter*>> groups;
+    std::vector<bool> done(filters.size(), false);
+    bool progressed = true;
+    while (progressed) {
+        progressed = false;
+        for (size_t i = 0; i < filters.size(); ++i) {
+            if (done[i]) continue;
+            Filter* filter = filters[i];
+            std::vector<Input>& filterInputs = inputs[filter];
+            bool isReady = true;
+            for (auto const& input : filterInputs) {
+                if (canonical.find(input.source) == canonical.end()) {
+                    isReady = false;
+                    break;
+                }
+            }
+            if (!isReady) continue;
+            done[i] = true;
+            progressed = true;
+
+            std::string key;
+            if ((int)filterInputs.size() != filter->getInputNumber() || !filter->getMergeKey(key)) {
+                canonical[filter] = filter;
+                continue;
+            }
+            std::vector<std::string> inputKeys;
+            for (auto const& input : filterInputs) {
+                inputKeys.push_back(str_format("|%p:%d", canonical[input.source], input.texIdx));
+            }
+            std::sort(inputKeys.begin(), inputKeys.end());
+            for (auto const& inputKey : inputKeys) {
+                key += inputKey;
+            }
+
+            std::map<std::string, Filter*>::iterator it = representatives.find(key);
+            if (it == representatives.end()) {
+                representatives[key] = filter;
+                canonical[filter] = filter;
+            } else {
+                canonical[filter] = it->second;
+                std::vector<Filter*>& group = groups[it->second];
+                if (group.empty()) {
+                    group.push_back(it->second);
+                }
+                group.push_back(filter);
+            }
+        }
+    }
+
+    for (auto const& it : groups) {
+        std::shared_ptr<Filter::MergeGroup> mergeGroup(new Filter::MergeGroup((int)it.second.size()));
+        for (auto const& filter : it.second) {
+            filter->setMergeGroup(mergeGroup);
+            filter->retain();
+            _mergedFilters.push_back(filter);
+        }
+        _mergedFilterCount += (int)it.second.size() - 1;
+    }
+}
+
+void GraphOptimizer::_clear() {
+    for (auto const& filter : _mergedFilters) {
+        filter->setMergeGroup(nullptr);
+        filter->release();
+    }
+    _mergedFilters.clear();
+    _mergedFilterCount = 0;
+}
+
+NS_GI_END
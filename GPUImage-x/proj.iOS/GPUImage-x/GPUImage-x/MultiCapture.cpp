@@ -0,0 +1,96 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MultiCapture.hpp"
+#include "Context.hpp"
+
+NS_GI_BEGIN
+
+MultiCapture::MultiCapture() {
+}
+
+MultiCapture::~MultiCapture() {
+    removeAllCapturePoints();
+}
+
+int MultiCapture::addCapturePoint(Filter* filter, int width/* = 0*/, int height/* = 0*/, ReadbackTarget::Format format/* = ReadbackTarget::RGBA*/) {
+    if (!filter) return -1;
+
+    CapturePoint capturePoint;
+    capturePoint.filter = filter;
+    capturePoint.target = ReadbackTarget::create();
+    if (!capturePoint.target) return -1;
+    capturePoint.target->setOutputSize(width, height);
+    capturePoint.target->setOutputFormat(format);
+    capturePoint.target->setDeferred(true);
+    filter->retain();
+    _capturePoints.push_back(capturePoint);
+    return (int)_capturePoints.size() - 1;
+}
+
+void MultiCapture::setCapturePointCropRegion(int index, float x, float y, float width, float height) {
+    if (index < 0 || index >= (int)_capturePoints.size()) return;
+    _capturePoints[index].target->setCropRegion(x, y, width, height);
+}
+
+void MultiCapture::removeAllCapturePoints() {
+    for (auto& capturePoint : _capturePoints) {
+        capturePoint.target->release();
+        capturePoint.filter->release();
+    }
+    _capturePoints.clear();
+}
+
+bool MultiCapture::capture(Source* source, Callback callback) {
+    if (!source || !callback || _capturePoints.empty()) return false;
+    // the pass, and so the capture state and the reads, belong to the context of the source
+    Context* context = source->getContext();
+    if (context->isCapturingFrame) return false;
+
+    Context* previousContext = Context::setCurrent(context);
+    // hand over what has completed before queueing more
+    context->getReadbackQueue()->poll();
+
+    for (int i = 0; i < (int)_capturePoints.size(); ++i) {
+        _capturePoints[i].target->setCallback([callback, i](const unsigned char* pixels, int width, int height) {
+            callback(i, pixels, width, height);
+        });
+        _capturePoints[i].filter->addTarget(_capturePoints[i].target);
+    }
+
+    // keeps readback targets outside of this capture from seeing the frame twice
+    context->isCapturingFrame = true;
+    context->captureUpToFilter = 0;
+    source->proceed(true);
+    context->isCapturingFrame = false;
+
+    // issue the reads back to back now that the whole graph has been drawn
+    bool capturedAll = true;
+    for (auto& capturePoint : _capturePoints) {
+        if (!capturePoint.target->flush()) {
+            capturedAll = false;
+        }
+        capturePoint.filter->removeTarget(capturePoint.target);
+        // do not keep the input out of the framebuffer cache until the next capture
+        capturePoint.target->setInputFramebuffer(0);
+    }
+    Context::setCurrent(previousContext);
+    return capturedAll;
+}
+
+NS_GI_END
@@ -0,0 +1,131 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef QualityController_hpp
+#define QualityController_hpp
+
+#include "macros.h"
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+NS_GI_BEGIN
+
+class Source;
+class Filter;
+
+// QualityController holds the frames of a context to a time budget by trading
+// quality for speed. Knobs are registered in the order they may be given up,
+// each with levels from 0, the full quality, to the cheapest; together they
+// make one ladder, stepped down one level when frames take longer than the
+// budget and back up when they have taken clearly less for a while:
+//
+//   context->getQualityController()->addFramebufferScaleKnob(beautify, {1.0, 0.75, 0.5});
+//   context->getQualityController()->addPropertyKnob(blur, "radius", {8, 6, 4});
+//   context->getQualityController()->setFrameBudget(33);
+//
+// A frame takes the time from the upload of its pixels to the end of its pass,
+// see FrameMetrics::FrameTime. Uploading waits for the frame before it to
+// retire from the FramePipeline of the source, so a GPU that falls behind
+// shows as that wait; sources without a pipeline get one of depth 1 while a
+// budget is set. GLES2 has no fences, there only what the driver blocks on is
+// seen. Levels change between passes, on the thread of the context.
+class QualityController {
+public:
+    // sets the level of a knob, called on the thread of the context
+    typedef std::function<void(int level)> Apply;
+
+    struct Stats {
+        double budgetMs;
+        // the smoothed frame time
+        double frameTimeMs;
+        // steps down the ladder, 0 for the full quality
+        int level;
+        int maxLevel;
+        unsigned int downgradeCount;
+        unsigned int upgradeCount;
+    };
+
+    QualityController();
+    ~QualityController();
+
+    // 0 stops the controller and gives every knob its full quality back
+    void setFrameBudget(double budgetMs);
+    double getFrameBudget() const;
+    // a budget is set and there are knobs to turn
+    bool isActive() const;
+    // Step down once frames have been over budget for downgradeFrames, and
+    // up once they have been under upgradeFraction of it for upgradeFrames.
+    // A step back down soon after a step up doubles the frames the next step
+    // up waits for, so a level that does not hold is not tried all the time.
+    void setHysteresis(int downgradeFrames, int upgradeFrames, double upgradeFraction);
+
+    // Knobs return an id, -1 if they have fewer than two levels. Sources and
+    // filters are retained while registered.
+    int addKnob(const std::string& name, int levelCount, Apply apply);
+    // a filter group scales its members, see FilterGroup::setFramebufferScale()
+    int addFramebufferScaleKnob(Source* source, const std::vector<float>& scales);
+    int addPropertyKnob(Filter* filter, const std::string& property, const std::vector<float>& values);
+    // the knob goes back to its full quality before it is removed
+    void removeKnob(int knobId);
+    void removeAllKnobs();
+    int getKnobLevel(int knobId) const;
+
+    // a frame of the context took frameTimeUs, see Source::updateTargets()
+    void recordFrame(int64_t frameTimeUs);
+
+    // may be called on any thread
+    Stats getStats() const;
+
+private:
+    struct Knob {
+        int id;
+        std::string name;
+        int levelCount;
+        int level;
+        Apply apply;
+        std::function<void(void)> release;
+    };
+
+    mutable std::mutex _mutex;
+    std::vector<Knob> _knobs;
+    int _nextKnobId;
+    double _budgetMs;
+    int _downgradeFrames;
+    int _upgradeFrames;
+    double _upgradeFraction;
+    double _frameTimeMs;
+    int _sampleCount;
+    int _overBudgetCount;
+    int _underBudgetCount;
+    // frames a step up waits for, and since the last step up
+    int _upgradeWait;
+    int _framesSinceUpgrade;
+    unsigned int _downgradeCount;
+    unsigned int _upgradeCount;
+
+    int _getLevel() const;
+    // move one step along the ladder, returns what to apply once unlocked
+    bool _step(bool down, std::vector<std::pair<Apply, int>>& applies);
+};
+
+NS_GI_END
+
+#endif /* QualityController_hpp */
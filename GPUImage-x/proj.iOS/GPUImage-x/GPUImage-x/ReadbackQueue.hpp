@@ -0,0 +1,85 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ReadbackQueue_hpp
+#define ReadbackQueue_hpp
+
+#include "macros.h"
+#include "Framebuffer.hpp"
+#include <functional>
+#include <vector>
+
+NS_GI_BEGIN
+
+// ReadbackQueue reads framebuffers back to the CPU without draining the GPU.
+//
+// On GLES3 each read goes into one buffer of a ring of pixel pack buffers and a
+// fence is inserted after it. poll() hands the pixels of every read whose
+// fence has signalled to its callback, normally one or two frames later. When
+// the ring is full the oldest read is waited for. GLES2 has no pack buffers,
+// there read() falls back to a blocking glReadPixels and calls back at once.
+// A callback may read again; a read that would reuse the buffer being
+// delivered is done blocking instead.
+class ReadbackQueue {
+public:
+    // pixels are RGBA rows of width * 4 bytes, valid only during the call
+    typedef std::function<void(const unsigned char* pixels, int width, int height)> Callback;
+
+    ReadbackQueue(int depth = 3);
+    ~ReadbackQueue();
+
+    void read(Framebuffer* framebuffer, Callback callback);
+
+    // Blocking read straight into caller memory, rows stride bytes apart (0 for width * 4).
+    bool readInto(Framebuffer* framebuffer, unsigned char* pixels, int stride = 0);
+
+    // deliver the reads that have completed, in the order they were issued, never blocks
+    void poll();
+    // wait for and deliver every pending read
+    void finish();
+    int getPendingCount() const;
+    // timestamp of the framebuffer read, valid while its callback runs
+    int64_t getDeliveredTimestamp() const { return _deliveredTimestamp; }
+
+private:
+    struct Slot {
+        GLuint buffer;
+        GLsizeiptr size;
+        GLsync fence;
+        int width;
+        int height;
+        int64_t timestamp;
+        Callback callback;
+        // mapped while its callback runs, no read may go into it
+        bool isDelivering;
+    };
+    std::vector<Slot> _slots;
+    int _next;
+    int64_t _deliveredTimestamp;
+    std::vector<unsigned char> _syncPixels;
+    // callbacks running, nested ones when a callback reads again
+    int _deliveryDepth;
+
+    bool _isPending(const Slot& slot) const { return slot.fence != 0; }
+    void _deliver(Slot& slot);
+    void _readBlocking(Framebuffer* framebuffer, const Callback& callback);
+};
+
+NS_GI_END
+
+#endif /* ReadbackQueue_hpp */
@@ -32,24 +32,26 @@ Ref::~Ref() {
 }
 
 void Ref::retain() {
-    assert(_referenceCount > 0);
-    ++_referenceCount;
+    unsigned int count = _referenceCount.fetch_add(1, std::memory_order_relaxed);
+    assert(count > 0);
+    (void)count;
 }
 
 void Ref::release() {
-    assert(_referenceCount > 0);
-    --_referenceCount;
-    if (_referenceCount == 0) {
+    // the last release sees every write made through the other references
+    unsigned int count = _referenceCount.fetch_sub(1, std::memory_order_acq_rel);
+    assert(count > 0);
+    if (count == 1) {
         delete this;
     }
 }
 
 void Ref::resetRefenceCount() {
-    _referenceCount = 1;
+    _referenceCount.store(1, std::memory_order_relaxed);
 }
 
 unsigned int Ref::getReferenceCount() const {
-    return _referenceCount;
+    return _referenceCount.load(std::memory_order_relaxed);
 }
 
 
@@ -20,9 +20,13 @@
 #define Ref_hpp
 
 #include "macros.h"
+#include <atomic>
 
 NS_GI_BEGIN
 
+// Reference counted base. Counts are atomic, a reference may be retained and
+// released on any thread; what the object holds in GL is deleted on the
+// thread of its context, see Context::deferDeletion.
 class Ref {
 public:
     virtual ~Ref();
@@ -33,7 +37,7 @@ public:
     unsigned int getReferenceCount() const;
 
 protected:
-    unsigned int _referenceCount;
+    std::atomic<unsigned int> _referenceCount;
     Ref();
     
 };
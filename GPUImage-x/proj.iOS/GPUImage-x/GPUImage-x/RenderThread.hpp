@@ -0,0 +1,127 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RenderThread_hpp
+#define RenderThread_hpp
+
+#include "macros.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+NS_GI_BEGIN
+
+// RenderThread owns a GL context on a thread of its own and runs the commands
+// posted to it, in the order they were posted, on that thread.
+//
+// Commands go through a bounded queue that any number of threads post to
+// without taking a lock. Its slots are allocated once when the thread is
+// created, posting only stores the function into a free slot; when every slot
+// is taken the poster yields until the render thread frees one. The thread
+// sleeps while the queue is empty and is woken by the next post.
+//
+// Frames can be driven from the thread itself at a fixed rate with
+// startFrames(), so a graph runs without a view asking it to draw.
+//
+// On Android and Linux the context is an EGL pbuffer context, GLES3 where the
+// driver has it and GLES2 otherwise. With ENABLE_GL_MOCK no context is made.
+class RenderThread {
+public:
+    typedef std::function<void(void)> Command;
+    // frameTime is the time in seconds since startFrames()
+    typedef std::function<void(float frameTime)> FrameCallback;
+
+    // capacity is rounded up to a power of two
+    RenderThread(int capacity = 64);
+    // stops the thread, running what was posted before
+    ~RenderThread();
+
+    // Create the context, sharing objects with sharedContext (an EGLContext)
+    // if given, and start the thread. Returns false if the context could not
+    // be made, the thread is not started then.
+    bool start(void* sharedContext = 0);
+    // Run the commands already posted, release the context and join the
+    // thread. Posts racing with it either run before the thread ends or are
+    // dropped with a warning, a runSync() then returns without waiting.
+    void stop();
+    bool isRunning() const { return _thread.joinable(); }
+    bool isRenderThread() const { return std::this_thread::get_id() == _threadId.load(); }
+
+    // Run func on the render thread and wait for it. Called on the render
+    // thread, func runs in place.
+    void runSync(Command func);
+    // Post func to the render thread and return. Called on the render thread,
+    // func runs in place.
+    void runAsync(Command func);
+
+    // call callback fps times a second from the render thread until stopFrames()
+    void startFrames(float fps, FrameCallback callback);
+    void stopFrames();
+
+    int getCapacity() const { return _capacity; }
+    // times a post found the queue full and had to wait
+    unsigned int getFullQueueCount() const { return _fullQueueCount.load(); }
+
+private:
+    struct Slot {
+        std::atomic<unsigned int> sequence;
+        Command command;
+    };
+    Slot* _slots;
+    int _capacity;
+    std::atomic<unsigned int> _enqueuePosition;
+    unsigned int _dequeuePosition;
+    std::atomic<unsigned int> _fullQueueCount;
+    // set once stop() begins, posts are refused from then on
+    std::atomic<bool> _isClosed;
+    // posts between the check of _isClosed and their command being queued
+    std::atomic<int> _postingCount;
+
+    std::thread _thread;
+    std::atomic<std::thread::id> _threadId;
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeUp;
+    std::atomic<bool> _isSleeping;
+    int _startResult;
+
+    // only touched on the render thread
+    bool _isStopping;
+    FrameCallback _frameCallback;
+    std::chrono::steady_clock::duration _frameInterval;
+    std::chrono::steady_clock::time_point _framesStart;
+    std::chrono::steady_clock::time_point _nextFrame;
+
+    void* _eglDisplay;
+    void* _eglSurface;
+    void* _eglContext;
+
+    bool _post(Command& func);
+    void _enqueue(Command& func);
+    bool _hasNext() const;
+    bool _runNext();
+    void _loop();
+    bool _createContext(void* sharedContext);
+    void _destroyContext();
+};
+
+NS_GI_END
+
+#endif /* RenderThread_hpp */
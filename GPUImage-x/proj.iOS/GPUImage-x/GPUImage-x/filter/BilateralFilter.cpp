@@ -174,10 +174,12 @@ bool BilateralMonoFilter::proceed(bool bUpdateTargets/* = true*/) {
 
 void BilateralMonoFilter::setTexelSpacingMultiplier(float multiplier) {
     _texelSpacingMultiplier = multiplier;
+    _notifyGraphChanged();
 }
 
 void BilateralMonoFilter::setDistanceNormalizationFactor(float value) {
     _distanceNormalizationFactor = value;
+    _notifyGraphChanged();
 }
 
 REGISTER_FILTER_CLASS(BilateralFilter)
@@ -241,4 +243,11 @@ void BilateralFilter::setDistanceNormalizationFactor(float value) {
     _vBlurFilter->setDistanceNormalizationFactor(value);
     
 }
+
+bool BilateralMonoFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {(float)_type, _texelSpacingMultiplier, _distanceNormalizationFactor});
+    return true;
+}
+
 NS_GI_END
@@ -33,6 +33,7 @@ public:
     bool init();
     
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
     void setTexelSpacingMultiplier(float multiplier);
     void setDistanceNormalizationFactor(float value);
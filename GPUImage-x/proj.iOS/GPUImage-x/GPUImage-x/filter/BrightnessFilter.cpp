@@ -60,6 +60,7 @@ void BrightnessFilter::setBrightness(float brightness) {
     _brightness = brightness;
     if (_brightness > 1.0) _brightness = 1.0;
     else if (_brightness < -1.0) _brightness = -1.0;
+    _notifyGraphChanged();
 }
 
 bool BrightnessFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -67,3 +68,8 @@ bool BrightnessFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool BrightnessFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_brightness});
+    return true;
+}
@@ -29,6 +29,7 @@ public:
     static BrightnessFilter* create(float brightness = 0.0);
     bool init(float brightness);
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
     void setBrightness(float brightness);
 
@@ -89,5 +89,11 @@ bool ColorMatrixFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool ColorMatrixFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_intensity});
+    _appendMergeState(key, _colorMatrix.m, 16);
+    return true;
+}
 
 NS_GI_END
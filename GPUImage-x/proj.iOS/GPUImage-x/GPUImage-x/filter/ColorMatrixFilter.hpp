@@ -32,9 +32,10 @@ public:
     bool init();
     
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
-    void setIntensity(float intensity) { _intensity = intensity; }
-    void setColorMatrix(Matrix4 colorMatrix) { _colorMatrix = colorMatrix; }
+    void setIntensity(float intensity) { _intensity = intensity; _notifyGraphChanged(); }
+    void setColorMatrix(Matrix4 colorMatrix) { _colorMatrix = colorMatrix; _notifyGraphChanged(); }
     
 protected:
     ColorMatrixFilter();
@@ -29,6 +29,7 @@ class Convolution3x3Filter : public NearbySampling3x3Filter {
 public:
     virtual bool init();
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
 protected:
     Convolution3x3Filter() {};
     
@@ -106,9 +106,16 @@ bool CrosshatchFilter::proceed(bool bUpdateTargets/* = true*/) {
 
 void CrosshatchFilter::setCrossHatchSpacing(float crossHatchSpacing) {
     _crossHatchSpacing = crossHatchSpacing;
+    _notifyGraphChanged();
 }
 
 void CrosshatchFilter::setLineWidth(float lineWidth) {
     _lineWidth = lineWidth;
+    _notifyGraphChanged();
 }
 
+bool CrosshatchFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_crossHatchSpacing, _lineWidth});
+    return true;
+}
@@ -60,6 +60,7 @@ void ExposureFilter::setExposure(float exposure) {
     _exposure = exposure;
     if (_exposure > 10.0) _exposure = 10.0;
     else if (_exposure < -10.0) _exposure = -10.0;
+    _notifyGraphChanged();
 }
 
 bool ExposureFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -67,3 +68,8 @@ bool ExposureFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool ExposureFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_exposure});
+    return true;
+}
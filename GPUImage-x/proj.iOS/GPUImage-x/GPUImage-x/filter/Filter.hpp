@@ -26,6 +26,8 @@
 #include "../GLProgram.hpp"
 #include "../Ref.hpp"
 #include "../util.h"
+#include <memory>
+#include <initializer_list>
 
 NS_GI_BEGIN
 
@@ -88,6 +90,25 @@ public:
     bool getPropertyComment(const std::string& name, std::string& retComment);
     bool getPropertyType(const std::string& name, std::string& retType);
 
+    // Filters merged by GraphOptimizer share one output per pass: the first of
+    // them to run draws it, the others hand it to their targets as it is.
+    struct MergeGroup {
+        Framebuffer* framebuffer;
+        unsigned int passSerial;
+        int memberCount;
+        int pendingUses;
+
+        MergeGroup(int count) : framebuffer(0), passSerial(0), memberCount(count), pendingUses(0) {}
+        ~MergeGroup() { if (framebuffer) framebuffer->release(); }
+    };
+    void setMergeGroup(std::shared_ptr<MergeGroup> mergeGroup) { _mergeGroup = mergeGroup; }
+    // Describes everything the output depends on besides the inputs: the class,
+    // the properties and the output settings. Returns false for filters that
+    // cannot be merged, those without a class name and filter groups.
+    // Subclasses keeping state outside of their properties, e.g. set through
+    // their own setters, append it with _appendMergeState().
+    virtual bool getMergeKey(std::string& key) const;
+
 #if PLATFORM == PLATFORM_ANDROID
     class Registry {
     public:
@@ -111,6 +132,8 @@ protected:
     
     Filter();
     std::string _getVertexShaderString() const;
+    static void _appendMergeState(std::string& key, std::initializer_list<float> values);
+    static void _appendMergeState(std::string& key, const float* values, int count);
     const GLfloat* _getTexureCoordinate(const RotationMode& rotationMode) const;
 
     // properties
@@ -138,6 +161,8 @@ protected:
     };
     std::map<std::string, StringProperty> _stringProperties;
 
+    std::shared_ptr<MergeGroup> _mergeGroup;
+
 private:
     static std::map<std::string, std::function<Filter*()>> _filterFactories;
 };
@@ -153,7 +178,7 @@ class className##Registry { \
         static const Filter::Registry _registry; \
 }; \
 const Filter::Registry className##Registry::_registry(#className, className##Registry::newInstance);
-#elif PLATFORM == PLATFORM_IOS
+#else
 #define REGISTER_FILTER_CLASS(className) 
 #endif
 
@@ -176,10 +176,7 @@ void FilterGroup::update(float frameTime) {
     }
     
     for(auto& filter : _filters){
-        if (filter->isPrepared()) {
-            filter->update(frameTime);
-            filter->unPrepear();
-        }
+        filter->runIfPrepared(frameTime);
     }
 }
 
@@ -193,6 +190,19 @@ void FilterGroup::setFramebuffer(Framebuffer* fb, RotationMode outputRotation/*
     //    _terminalFilter->setFramebuffer(fb);
 }
 
+void FilterGroup::setFramebufferScale(float framebufferScale) {
+    if (framebufferScale > 0 && _framebufferScale > 0) {
+        float ratio = framebufferScale / _framebufferScale;
+        for (auto& filter : _filters) {
+            // one joining several inputs takes the size of its first one
+            if (filter->getInputNumber() == 1) {
+                filter->setFramebufferScale(filter->getFramebufferScale() * ratio);
+            }
+        }
+    }
+    Source::setFramebufferScale(framebufferScale);
+}
+
 Framebuffer* FilterGroup::getFramebuffer() const {
     //if (_terminalFilter)
     //    return _terminalFilter->getFramebuffer();
@@ -219,4 +229,14 @@ void FilterGroup::unPrepear() {
     //}
 }
 
+void FilterGroup::setInputSynchronization(bool enabled, int64_t tolerance/* = 5000000*/, int depth/* = 3*/) {
+    if (enabled) {
+        Log("WARNING", "FilterGroup: the inputs of a group are joined by its members, synchronise those instead");
+    }
+}
+
+void FilterGroup::setInputSyncRule(int texIdx, InputSyncRule rule) {
+    Log("WARNING", "FilterGroup: the inputs of a group are joined by its members, synchronise those instead");
+}
+
 NS_GI_END
@@ -45,6 +45,8 @@ public:
     // Most often, it's not necessary to specify the terminal filter manually,
     // as the terminal filter will be specified automatically.
     void setTerminalFilter(Filter* filter) { _terminalFilter = filter; }
+    Filter* getTerminalFilter() const { return _terminalFilter; }
+    const std::vector<Filter*>& getFilters() const { return _filters; }
     
     virtual Source* addTarget(Target* target) override;
 //#if GI_TARGET_PLATFORM == GI_PLATFORM_IOS
@@ -59,9 +61,19 @@ public:
     virtual void updateTargets(float frameTime) override;
     virtual void setFramebuffer(Framebuffer* fb, RotationMode outputRotation = RotationMode::NoRotation) override;
     virtual Framebuffer* getFramebuffer() const override;
+    // A group renders through its members: the ones its input goes to are
+    // scaled by the same factor, keeping scales of their own, and the members
+    // behind them follow their smaller inputs.
+    virtual void setFramebufferScale(float framebufferScale) override;
     virtual void setInputFramebuffer(Framebuffer* framebuffer, RotationMode rotationMode = NoRotation, int texIdx = 0) override;
     virtual bool isPrepared() const override;
     virtual void unPrepear() override;
+    // Inputs go straight to the members, a group never joins them itself.
+    // Synchronise the member that does instead.
+    virtual void setInputSynchronization(bool enabled, int64_t tolerance = 5000000, int depth = 3) override;
+    virtual void setInputSyncRule(int texIdx, InputSyncRule rule) override;
+    // the members are wired inside the group, it is never merged as a whole
+    virtual bool getMergeKey(std::string& key) const override { return false; }
     
 protected:
     std::vector<Filter*> _filters;
@@ -35,6 +35,7 @@ public:
     void setSigma(float sigma);
     
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
 protected:
     GaussianBlurMonoFilter(Type type = HORIZONTAL);
     Type _type;
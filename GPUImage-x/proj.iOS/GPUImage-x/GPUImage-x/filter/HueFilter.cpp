@@ -93,6 +93,7 @@ bool HueFilter::init() {
 void HueFilter::setHueAdjustment(float hueAdjustment) {
     // Convert degrees to radians for hue rotation
     _hueAdjustment = fmodf(hueAdjustment, 360.0) * M_PI/180;
+    _notifyGraphChanged();
 }
 
 bool HueFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -100,3 +101,8 @@ bool HueFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool HueFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_hueAdjustment});
+    return true;
+}
@@ -29,6 +29,7 @@ public:
     static LuminanceRangeFilter* create();
     bool init();
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
     void setRangeReductionFactor(float rangeReductionFactor);
 
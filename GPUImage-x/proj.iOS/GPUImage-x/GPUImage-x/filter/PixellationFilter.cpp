@@ -63,7 +63,7 @@ void PixellationFilter::setPixelSize(float pixelSize) {
     _pixelSize = pixelSize;
     if (_pixelSize > 1.0) _pixelSize = 1.0;
     else if (_pixelSize < 0.0) _pixelSize = 0.0;
-    
+    _notifyGraphChanged();
 }
 
 bool PixellationFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -84,3 +84,8 @@ bool PixellationFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool PixellationFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_pixelSize});
+    return true;
+}
@@ -72,16 +72,19 @@ bool RGBFilter::init() {
 void RGBFilter::setRedAdjustment(float redAdjustment) {
     _redAdjustment = redAdjustment;
     if (_redAdjustment < 0.0) _redAdjustment = 0.0;
+    _notifyGraphChanged();
 }
 
 void RGBFilter::setGreenAdjustment(float greenAdjustment) {
     _greenAdjustment = greenAdjustment;
     if (_greenAdjustment < 0.0) _greenAdjustment = 0.0;
+    _notifyGraphChanged();
 }
 
 void RGBFilter::setBlueAdjustment(float blueAdjustment) {
     _blueAdjustment = blueAdjustment;
     if (_blueAdjustment < 0.0) _blueAdjustment = 0.0;
+    _notifyGraphChanged();
 }
 bool RGBFilter::proceed(bool bUpdateTargets/* = true*/) {
     _filterProgram->setUniformValue("redAdjustment", _redAdjustment);
@@ -90,3 +93,8 @@ bool RGBFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool RGBFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_redAdjustment, _greenAdjustment, _blueAdjustment});
+    return true;
+}
@@ -126,6 +126,7 @@ bool _SketchFilter::init() {
 
 void _SketchFilter::setEdgeStrength(float edgeStrength) {
     _edgeStrength = edgeStrength;
+    _notifyGraphChanged();
 }
 
 bool _SketchFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -145,5 +146,10 @@ bool _SketchFilter::proceed(bool bUpdateTargets/* = true*/) {
     return NearbySampling3x3Filter::proceed(bUpdateTargets);
 }
 
+bool _SketchFilter::getMergeKey(std::string& key) const {
+    if (!NearbySampling3x3Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_edgeStrength});
+    return true;
+}
 
 NS_GI_END
@@ -48,6 +48,7 @@ public:
     static _SobelEdgeDetectionFilter* create();
     bool init();
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
     void setEdgeStrength(float edgeStrength);
     
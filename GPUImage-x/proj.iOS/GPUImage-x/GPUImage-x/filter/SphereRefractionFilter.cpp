@@ -103,17 +103,26 @@ bool SphereRefractionFilter::proceed(bool bUpdateTargets/* = true*/) {
 
 void SphereRefractionFilter::setPositionX(float x) {
     _position.x = x;
+    _notifyGraphChanged();
 }
 
 void SphereRefractionFilter::setPositionY(float y) {
     _position.y = y;
+    _notifyGraphChanged();
 }
 
 void SphereRefractionFilter::setRadius(float radius) {
     _radius = radius;
+    _notifyGraphChanged();
 }
 
 void SphereRefractionFilter::setRefractiveIndex(float refractiveIndex) {
     _refractiveIndex = refractiveIndex;
+    _notifyGraphChanged();
 }
 
+bool SphereRefractionFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_position.x, _position.y, _radius, _refractiveIndex});
+    return true;
+}
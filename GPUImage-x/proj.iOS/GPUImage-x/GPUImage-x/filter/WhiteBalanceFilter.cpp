@@ -76,10 +76,12 @@ bool WhiteBalanceFilter::init() {
 
 void WhiteBalanceFilter::setTemperature(float temperature) {
     _temperature = temperature < 5000 ? 0.0004 * (temperature - 5000.0) : 0.00006 * (temperature - 5000.0);
+    _notifyGraphChanged();
 }
 
 void WhiteBalanceFilter::setTint(float tint) {
     _tint = tint / 100.0;
+    _notifyGraphChanged();
 }
 
 bool WhiteBalanceFilter::proceed(bool bUpdateTargets/* = true*/) {
@@ -88,3 +90,8 @@ bool WhiteBalanceFilter::proceed(bool bUpdateTargets/* = true*/) {
     return Filter::proceed(bUpdateTargets);
 }
 
+bool WhiteBalanceFilter::getMergeKey(std::string& key) const {
+    if (!Filter::getMergeKey(key)) return false;
+    _appendMergeState(key, {_temperature, _tint});
+    return true;
+}
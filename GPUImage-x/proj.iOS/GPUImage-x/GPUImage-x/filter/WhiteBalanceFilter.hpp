@@ -29,6 +29,7 @@ public:
     static WhiteBalanceFilter* create();
     bool init();
     virtual bool proceed(bool bUpdateTargets = true) override;
+    virtual bool getMergeKey(std::string& key) const override;
     
     void setTemperature(float temperature);
     void setTint(float tint);
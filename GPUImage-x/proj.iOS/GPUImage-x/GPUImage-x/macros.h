@@ -45,6 +45,12 @@
 
 #define ENABLE_GL_CHECK false
 
+// Route every GL entry point to the recording stubs in GLMock.hpp instead of
+// the driver, which lets the CPU side of a frame be measured without a GPU.
+#ifndef ENABLE_GL_MOCK
+    #define ENABLE_GL_MOCK false
+#endif
+
 #if ENABLE_GL_CHECK
     #define CHECK_GL(glFunc) \
         glFunc; \
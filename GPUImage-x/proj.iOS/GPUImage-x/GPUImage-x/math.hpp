@@ -77,8 +77,17 @@ public:
     bool operator!=(const Vector2& v) const;
 };
 
-class Vector3 {
-    
+class Vector3
+{
+public:
+
+    float x;
+    float y;
+    float z;
+
+    Vector3();
+    Vector3(float xx, float yy, float zz);
+    Vector3(const float* array);
 };
 
 class Matrix4 {
@@ -21,6 +21,9 @@
 
 
 #include "Source.hpp"
+#include "../GLProgram.hpp"
+#include "../InputTexture.hpp"
+#include "../FrameQueue.hpp"
 
 #if PLATFORM == PLATFORM_IOS
 #import <AVFoundation/AVFoundation.h>
@@ -32,12 +35,42 @@ NS_GI_BEGIN
 
 class SourceCamera : public Source{
 public:
+    enum YUVFormat {
+        NV21 = 0,   // Y plane followed by an interleaved VU plane, the Android camera default
+        NV12 = 1,   // Y plane followed by an interleaved UV plane
+        I420 = 2    // Y plane followed by a U plane and a V plane
+    };
+
+    enum YUVColorSpace {
+        BT601FullRange = 0,
+        BT601VideoRange = 1,
+        BT709FullRange = 2,
+        BT709VideoRange = 3
+    };
+
     SourceCamera();
     virtual ~SourceCamera();
     
     static SourceCamera* create();
 
     void setFrameData(int width, int height, const void* pixels, RotationMode outputRotation = RotationMode::NoRotation);
+
+    // Upload the luma and chroma planes of a YUV 4:2:0 frame as they are and
+    // convert them to RGBA on the GPU, so no CPU conversion is needed.
+    void setYUVFrameData(int width, int height, const void* yuvData, YUVFormat yuvFormat, RotationMode outputRotation = RotationMode::NoRotation);
+    void setYUVColorSpace(YUVColorSpace yuvColorSpace) { _yuvColorSpace = yuvColorSpace; }
+    // also sizes the upload rings, so no upload waits for a frame in flight
+    virtual void setFramesInFlight(int depth) override;
+
+    // Frames handed over from the camera thread, see FrameQueue. The queue
+    // calls copy a frame in on any thread and return at once, or once there is
+    // room with the Block policy. processQueuedFrame() uploads and processes
+    // the oldest waiting frame on the GL thread, false if there was none.
+    void setFramePolicy(FrameQueue::Policy policy, int capacity = 1) { _frameQueue.setPolicy(policy, capacity); }
+    bool queueFrameData(int width, int height, const void* pixels, RotationMode outputRotation = RotationMode::NoRotation);
+    bool queueYUVFrameData(int width, int height, const void* yuvData, YUVFormat yuvFormat, RotationMode outputRotation = RotationMode::NoRotation);
+    bool processQueuedFrame();
+    FrameQueue& getFrameQueue() { return _frameQueue; }
 #if PLATFORM == PLATFORM_IOS    
     bool init();
     bool init(NSString* sessionPreset, AVCaptureDevicePosition cameraPosition);
@@ -56,6 +89,20 @@ public:
 #endif
 
 private:
+    InputTexture _inputTexture;
+    InputTexture _lumaTexture;
+    InputTexture _chromaTexture;
+    InputTexture _secondChromaTexture;
+    YUVColorSpace _yuvColorSpace;
+    FrameQueue _frameQueue;
+    FrameQueue::Frame _queuedFrame;
+    GLProgram* _yuvConversionProgram;
+    GLuint _yuvPositionAttribLocation;
+    GLuint _yuvTexCoordAttribLocation;
+
+    bool _initYUVConversionProgram();
+    Matrix3 _getYUVConversionMatrix(YUVFormat yuvFormat) const;
+
 #if PLATFORM == PLATFORM_IOS
     VideoDataOutputSampleBufferDelegate* _videoDataOutputSampleBufferDelegate;
     AVCaptureSession* _captureSession;
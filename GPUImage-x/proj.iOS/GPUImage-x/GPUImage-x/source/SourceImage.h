@@ -20,6 +20,7 @@
 #define GPUIMAGE_X_SOURCEIMAGE_H
 
 #include "Source.hpp"
+#include "../InputTexture.hpp"
 
 NS_GI_BEGIN
 
@@ -42,8 +43,11 @@ public:
     
     static SourceImage* create(CGImageRef image);
     SourceImage* setImage(CGImageRef image);
+#endif
 
 private:
+    InputTexture _inputTexture;
+#if PLATFORM == PLATFORM_IOS
     UIImage* _adjustImageOrientation(UIImage* image);
 #endif
 };
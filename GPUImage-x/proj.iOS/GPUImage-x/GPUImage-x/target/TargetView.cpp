@@ -107,6 +107,7 @@ void TargetView::update(float frameTime)
     CHECK_GL(glVertexAttribPointer(_positionAttribLocation, 2, GL_FLOAT, 0, 0, _displayVertices));
     CHECK_GL(glVertexAttribPointer(_texCoordAttribLocation, 2, GL_FLOAT, 0, 0, _getTexureCoordinate(_inputFramebuffers[0].rotationMode)));
     CHECK_GL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    Context::getInstance()->getFrameMetrics()->recordLatency(FrameMetrics::DisplayLatency, getInputTimestamp());
 }
 
 void TargetView::_updateDisplayVertices()
@@ -41,6 +41,8 @@ public:
     void setFillMode(FillMode fillMode);
     void onSizeChanged(int width, int height);
     virtual void update(float frameTime) override;
+    // inactive until the view has a size, and again once its surface is gone
+    virtual bool isActive() const override { return _viewWidth > 0 && _viewHeight > 0; }
 
 private:
     int _viewWidth;
@@ -0,0 +1,295 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TensorTarget.hpp"
+#include "ReadbackPass.hpp"
+#include "../Context.hpp"
+#include "../util.h"
+
+NS_GI_BEGIN
+
+// the bytes of the tensor, packed by ReadbackPass
+const std::string kTensorTargetPackShaderString = SHADER_STRING
+(
+ uniform sampler2D colorMap;
+ uniform mat3 texCoordMatrix;
+ uniform mat4 normalizationMatrix;
+ uniform vec3 paddingColor;
+ uniform vec2 outputSize;
+ uniform float planar;
+ uniform float bytesPerElement;
+
+ vec3 tensorPixel(float pixel)
+ {
+     float row = floor((pixel + 0.5) / outputSize.x);
+     float column = pixel - row * outputSize.x;
+     vec2 texCoord = (texCoordMatrix * vec3(vec2(column + 0.5, row + 0.5) / outputSize, 1.0)).xy;
+     // outside of the image is the letterbox
+     float inside = step(0.0, texCoord.x) * step(texCoord.x, 1.0) * step(0.0, texCoord.y) * step(texCoord.y, 1.0);
+     vec3 color = mix(paddingColor, texture2D(colorMap, texCoord).rgb, inside);
+     return (normalizationMatrix * vec4(color, 1.0)).rgb;
+ }
+
+ float tensorElement(float element)
+ {
+     float pixel;
+     float channel;
+     if (planar > 0.5) {
+         float pixelCount = outputSize.x * outputSize.y;
+         channel = floor((element + 0.5) / pixelCount);
+         pixel = element - channel * pixelCount;
+     } else {
+         pixel = floor((element + 0.5) / 3.0);
+         channel = element - pixel * 3.0;
+     }
+     vec3 value = tensorPixel(pixel);
+     return channel < 0.5 ? value.r : (channel < 1.5 ? value.g : value.b);
+ }
+
+ float exponentOf(float magnitude)
+ {
+     // log2 is not exact on every GPU
+     float exponent = floor(log2(magnitude));
+     if (exp2(exponent) > magnitude) {
+         exponent -= 1.0;
+     } else if (exp2(exponent + 1.0) <= magnitude) {
+         exponent += 1.0;
+     }
+     return exponent;
+ }
+
+ vec2 encodeFloat16(float value)
+ {
+     float magnitude = abs(value);
+     float bits;
+     if (magnitude < 0.00006103515625) {
+         // subnormal, in units of 2^-24
+         bits = floor(magnitude * 16777216.0 + 0.5);
+     } else {
+         float exponent = exponentOf(magnitude);
+         float mantissa = floor((magnitude / exp2(exponent) - 1.0) * 1024.0 + 0.5);
+         if (mantissa > 1023.5) {
+             mantissa = 0.0;
+             exponent += 1.0;
+         }
+         bits = exponent > 15.0 ? 31744.0 : (exponent + 15.0) * 1024.0 + mantissa;
+     }
+     bits += value < 0.0 ? 32768.0 : 0.0;
+     float high = floor(bits / 256.0);
+     return vec2(bits - high * 256.0, high) / 255.0;
+ }
+
+ vec4 encodeFloat32(float value)
+ {
+     float signBits = value < 0.0 ? 128.0 : 0.0;
+     float magnitude = abs(value);
+     if (magnitude < 1.17549435e-38) {
+         // subnormals are flushed to zero
+         return vec4(0.0, 0.0, 0.0, signBits / 255.0);
+     }
+     float exponent = exponentOf(magnitude);
+     float mantissa = floor((magnitude / exp2(exponent) - 1.0) * 8388608.0 + 0.5);
+     if (mantissa > 8388607.5) {
+         mantissa = 0.0;
+         exponent += 1.0;
+     }
+     exponent += 127.0;
+     float byte2 = floor(mantissa / 65536.0);
+     mantissa -= byte2 * 65536.0;
+     float byte1 = floor(mantissa / 256.0);
+     float byte0 = mantissa - byte1 * 256.0;
+     float exponentHigh = floor(exponent / 2.0);
+     byte2 += (exponent - exponentHigh * 2.0) * 128.0;
+     return vec4(byte0, byte1, byte2, signBits + exponentHigh) / 255.0;
+ }
+
+ vec4 packedTexel(float offset)
+ {
+     if (bytesPerElement > 3.5) {
+         return encodeFloat32(tensorElement(offset / 4.0));
+     } else if (bytesPerElement > 1.5) {
+         float element = offset / 2.0;
+         return vec4(encodeFloat16(tensorElement(element)), encodeFloat16(tensorElement(element + 1.0)));
+     }
+     return clamp(vec4(tensorElement(offset), tensorElement(offset + 1.0), tensorElement(offset + 2.0), tensorElement(offset + 3.0)), 0.0, 1.0);
+ }
+);
+
+TensorTarget::TensorTarget()
+:_outputWidth(0)
+,_outputHeight(0)
+,_layout(NCHW)
+,_dataType(Float32)
+,_fillMode(Stretch)
+,_tensorProgram(0)
+,_positionAttribLocation(0)
+,_downscaleProgram(0)
+{
+    for (int i = 0; i < 3; ++i) {
+        _paddingColor[i] = 0.0;
+        _mean[i] = 0.0;
+        _std[i] = 1.0;
+    }
+}
+
+TensorTarget::~TensorTarget() {
+    if (_tensorProgram) {
+        delete _tensorProgram;
+        _tensorProgram = 0;
+    }
+    if (_downscaleProgram) {
+        delete _downscaleProgram;
+        _downscaleProgram = 0;
+    }
+}
+
+TensorTarget* TensorTarget::create(int width, int height, DataType dataType/* = Float32*/, ReadbackQueue::Callback callback/* = nullptr*/) {
+    TensorTarget* ret = new (std::nothrow) TensorTarget();
+    if (ret) {
+        ret->setOutputSize(width, height);
+        ret->setDataType(dataType);
+        ret->setCallback(callback);
+    }
+    return ret;
+}
+
+int TensorTarget::getBytesPerElement(DataType dataType) {
+    switch (dataType) {
+        case UInt8:
+            return 1;
+        case Float16:
+            return 2;
+        case Float32:
+        default:
+            return 4;
+    }
+}
+
+void TensorTarget::setOutputSize(int width, int height) {
+    _outputWidth = width > 0 ? width : 0;
+    _outputHeight = height > 0 ? height : 0;
+}
+
+void TensorTarget::setPaddingColor(float r, float g, float b) {
+    _paddingColor[0] = r;
+    _paddingColor[1] = g;
+    _paddingColor[2] = b;
+}
+
+void TensorTarget::setNormalization(const float mean[3], const float std[3]) {
+    for (int i = 0; i < 3; ++i) {
+        if (std[i] == 0.0) {
+            Log("WARNING", "TensorTarget: std of 0, normalization unchanged");
+            return;
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        _mean[i] = mean[i];
+        _std[i] = std[i];
+    }
+}
+
+void TensorTarget::update(float frameTime) {
+    if (!_callback || ReadbackPass::isRepeatedPass()) return;
+    if (_inputFramebuffers.find(0) == _inputFramebuffers.end() || _inputFramebuffers[0].frameBuffer == 0) return;
+    if (_outputWidth <= 0 || _outputHeight <= 0) {
+        Log("WARNING", "TensorTarget: no output size");
+        return;
+    }
+
+    Framebuffer* inputFramebuffer = _inputFramebuffers[0].frameBuffer;
+    RotationMode inputRotation = _inputFramebuffers[0].rotationMode;
+    int width = _outputWidth;
+    int height = _outputHeight;
+
+    int rotatedFramebufferWidth = inputFramebuffer->getWidth();
+    int rotatedFramebufferHeight = inputFramebuffer->getHeight();
+    if (rotationSwapsSize(inputRotation)) {
+        rotatedFramebufferWidth = inputFramebuffer->getHeight();
+        rotatedFramebufferHeight = inputFramebuffer->getWidth();
+    }
+
+    // size the image is drawn at in the tensor, centered
+    float scaleX = (float)width / rotatedFramebufferWidth;
+    float scaleY = (float)height / rotatedFramebufferHeight;
+    if (_fillMode == PreserveAspectRatio) {
+        scaleX = scaleY = (scaleX < scaleY ? scaleX : scaleY);
+    } else if (_fillMode == PreserveAspectRatioAndFill) {
+        scaleX = scaleY = (scaleX > scaleY ? scaleX : scaleY);
+    }
+    float contentWidth = rotatedFramebufferWidth * scaleX;
+    float contentHeight = rotatedFramebufferHeight * scaleY;
+
+    if (!_tensorProgram && !_initTensorProgram()) return;
+
+    // halved in the orientation of the input, the tensor pass rotates it
+    GLfloat textureCoordinates[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+    };
+    float regionWidth = inputFramebuffer->getWidth();
+    float regionHeight = inputFramebuffer->getHeight();
+    Framebuffer* sourceFramebuffer = rotationSwapsSize(inputRotation)
+        ? ReadbackPass::downscale(_downscaleProgram, inputFramebuffer, textureCoordinates, regionWidth, regionHeight, contentHeight, contentWidth)
+        : ReadbackPass::downscale(_downscaleProgram, inputFramebuffer, textureCoordinates, regionWidth, regionHeight, contentWidth, contentHeight);
+
+    int bytesPerElement = getBytesPerElement(_dataType);
+
+    // maps a position in the tensor, from 0 to 1, to the image it is drawn from
+    float contentScaleX = width / contentWidth;
+    float contentScaleY = height / contentHeight;
+    float contentOffsetX = -(width - contentWidth) * 0.5 / contentWidth;
+    float contentOffsetY = -(height - contentHeight) * 0.5 / contentHeight;
+
+    Framebuffer* framebuffer = ReadbackPass::fetchPackFramebuffer(width * bytesPerElement, width * height * 3 * bytesPerElement);
+    framebuffer->setTimestamp(getInputTimestamp());
+    Context::getInstance()->setActiveShaderProgram(_tensorProgram);
+    _tensorProgram->setUniformValue("texCoordMatrix", ReadbackPass::getTexCoordMatrix(inputRotation, contentScaleX, contentScaleY, contentOffsetX, contentOffsetY));
+    _tensorProgram->setUniformValue("normalizationMatrix", _getNormalizationMatrix());
+    _tensorProgram->setUniformValue("paddingColor", Vector3(_paddingColor));
+    _tensorProgram->setUniformValue("outputSize", Vector2(width, height));
+    _tensorProgram->setUniformValue("planar", _layout == NCHW ? 1.0f : 0.0f);
+    _tensorProgram->setUniformValue("bytesPerElement", (float)bytesPerElement);
+    ReadbackPass::drawPack(_tensorProgram, _positionAttribLocation, sourceFramebuffer, framebuffer);
+    sourceFramebuffer->release();
+
+    ReadbackPass::readPacked(framebuffer, _callback, width, height);
+    framebuffer->release();
+}
+
+bool TensorTarget::_initTensorProgram() {
+    _tensorProgram = ReadbackPass::createPackProgram(kTensorTargetPackShaderString, false);
+    if (!_tensorProgram) {
+        Log("ERROR", "TensorTarget: failed to create the tensor program");
+        return false;
+    }
+    _positionAttribLocation = _tensorProgram->getAttribLocation("position");
+    return true;
+}
+
+// (x - mean) / std for each channel, as one affine transform of the color
+Matrix4 TensorTarget::_getNormalizationMatrix() const {
+    return Matrix4(1.0 / _std[0], 0.0, 0.0, -_mean[0] / _std[0],
+                   0.0, 1.0 / _std[1], 0.0, -_mean[1] / _std[1],
+                   0.0, 0.0, 1.0 / _std[2], -_mean[2] / _std[2],
+                   0.0, 0.0, 0.0, 1.0);
+}
+
+NS_GI_END
@@ -0,0 +1,101 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TensorTarget_hpp
+#define TensorTarget_hpp
+
+#include "../macros.h"
+#include "Target.hpp"
+#include "../GLProgram.hpp"
+#include "../ReadbackQueue.hpp"
+
+NS_GI_BEGIN
+
+// TensorTarget turns the frames it receives into the input tensor of a model:
+// resized or letterboxed to the input size, normalized per channel as
+// (x - mean) / std with x from 0 to 1, laid out planar (NCHW) or interleaved
+// (NHWC) and stored as uint8, float16 or float32. All of it runs in a shader
+// that writes the bytes of the tensor four to a texel of an RGBA framebuffer,
+// so the read returns the tensor as the model takes it, in little-endian
+// order. Float output needs highp in fragment shaders.
+//
+// Inputs more than twice the size they are drawn at are halved a pass at a
+// time first, like ReadbackTarget does. Reads go through the context's
+// ReadbackQueue; the callback receives width * height * 3 elements of the
+// data type, with the tensor width and height.
+class TensorTarget : public Target {
+public:
+    enum Layout {
+        NCHW = 0,   // one plane per channel
+        NHWC = 1    // channels interleaved per pixel
+    };
+
+    enum DataType {
+        UInt8 = 0,  // the normalized value times 255, clamped to 0 to 255
+        Float16 = 1,
+        Float32 = 2
+    };
+
+    enum FillMode {
+        Stretch = 0,                    // fill the tensor, may distort the image
+        PreserveAspectRatio = 1,        // letterbox, the rest is the padding color
+        PreserveAspectRatioAndFill = 2  // zoom in to fill the tensor, cropping the image
+    };
+
+    static int getBytesPerElement(DataType dataType);
+
+    static TensorTarget* create(int width, int height, DataType dataType = Float32, ReadbackQueue::Callback callback = nullptr);
+    ~TensorTarget();
+
+    void setCallback(ReadbackQueue::Callback callback) { _callback = callback; }
+    void setOutputSize(int width, int height);
+    void setLayout(Layout layout) { _layout = layout; }
+    void setDataType(DataType dataType) { _dataType = dataType; }
+    DataType getDataType() const { return _dataType; }
+    void setFillMode(FillMode fillMode) { _fillMode = fillMode; }
+    // the color of the letterbox bars, before normalization
+    void setPaddingColor(float r, float g, float b);
+    // per channel in R, G, B order, std must not be 0
+    void setNormalization(const float mean[3], const float std[3]);
+
+    virtual void update(float frameTime) override;
+
+protected:
+    TensorTarget();
+
+private:
+    ReadbackQueue::Callback _callback;
+    int _outputWidth;
+    int _outputHeight;
+    Layout _layout;
+    DataType _dataType;
+    FillMode _fillMode;
+    float _paddingColor[3];
+    float _mean[3];
+    float _std[3];
+    GLProgram* _tensorProgram;
+    GLuint _positionAttribLocation;
+    GLProgram* _downscaleProgram;
+
+    bool _initTensorProgram();
+    Matrix4 _getNormalizationMatrix() const;
+};
+
+NS_GI_END
+
+#endif /* TensorTarget_hpp */
@@ -0,0 +1,81 @@
+/*
+ * GPUImage-x
+ *
+ * Copyright (C) 2017 Yijin Wang, Yiqian Wang
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef YUVTarget_hpp
+#define YUVTarget_hpp
+
+#include "../macros.h"
+#include "Target.hpp"
+#include "../GLProgram.hpp"
+#include "../ReadbackQueue.hpp"
+
+NS_GI_BEGIN
+
+// YUVTarget hands the frames it receives to an encoder as NV12 or I420. The
+// conversion runs in a shader that writes the bytes of the Y, U and V planes
+// four to a texel into a compact RGBA framebuffer, so one read returns the
+// finished planes at 1.5 bytes per pixel instead of RGBA at 4. Chroma is
+// sampled between the four pixels it stands for and averaged by the linear
+// filter of the input texture.
+//
+// Reads go through the context's ReadbackQueue like ReadbackTarget's. The
+// callback receives width * height * 3 / 2 bytes of planes, tightly packed.
+class YUVTarget : public Target {
+public:
+    enum Layout {
+        NV12 = 0,   // Y plane followed by an interleaved UV plane
+        I420 = 1    // Y plane followed by a U plane and a V plane
+    };
+
+    enum YUVColorSpace {
+        BT601FullRange = 0,
+        BT601VideoRange = 1,
+        BT709FullRange = 2,
+        BT709VideoRange = 3
+    };
+
+    static YUVTarget* create(Layout layout = NV12, ReadbackQueue::Callback callback = nullptr);
+    ~YUVTarget();
+
+    void setCallback(ReadbackQueue::Callback callback) { _callback = callback; }
+    void setLayout(Layout layout) { _layout = layout; }
+    void setYUVColorSpace(YUVColorSpace yuvColorSpace) { _yuvColorSpace = yuvColorSpace; }
+    // 0 keeps the input size after rotation, odd sizes are rounded down
+    void setOutputSize(int width, int height);
+
+    virtual void update(float frameTime) override;
+
+protected:
+    YUVTarget();
+
+private:
+    ReadbackQueue::Callback _callback;
+    Layout _layout;
+    YUVColorSpace _yuvColorSpace;
+    int _outputWidth;
+    int _outputHeight;
+    GLProgram* _conversionProgram;
+    GLuint _positionAttribLocation;
+
+    bool _initConversionProgram();
+    Matrix4 _getColorMatrix() const;
+};
+
+NS_GI_END
+
+#endif /* YUVTarget_hpp */